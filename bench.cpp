@@ -0,0 +1,2090 @@
+/**
+ * @file bench.cpp
+ * @brief Замеры производительности Time и связанных типов
+ *
+ * Запуск: bench [--json файл] [--sizes список | --sweep] [фильтр] [размер]
+ *
+ * Фильтр - подстрока имени замера. --json дописывает в файл по строке
+ * JSON на каждый результат (JSON Lines) для сравнения прогонов. --sizes
+ * прогоняет каждый замер на размерах из списка через запятую, --sweep -
+ * на 10, 100, ..., 10^7.
+ */
+
+ #include "time.h"
+ #include "timevalue.h"
+ #include "timespan.h"
+ #include "schedulestore.h"
+ #include "conflicts.h"
+ #include "scheduleanalytics.h"
+ #include "timebatch.h"
+ #include "schedulecommands.h"
+ #include "schedulefile.h"
+ #include "scheduleio.h"
+ #include "concurrentschedule.h"
+ #include "tracing.h"
+ #include "datetime.h"
+ #include "recurrence.h"
+ #include "schedulejournal.h"
+ #include <algorithm>
+ #include <atomic>
+ #include <chrono>
+ #include <cmath>
+ #include <cstdlib>
+ #include <cstring>
+ #include <ctime>
+ #include <fstream>
+ #include <iomanip>
+ #include <iostream>
+ #include <new>
+ #include <random>
+ #include <shared_mutex>
+ #include <sstream>
+ #include <streambuf>
+ #include <string>
+ #include <thread>
+ #include <vector>
+ 
+ using namespace std;
+ using namespace timeLiterals;
+ 
+ // Литералы и операторы TimeValue вычисляются при компиляции
+ static_assert(1_h + 30_min == TimeValue(1, 30, 0), "литералы складываются при компиляции");
+ static_assert((24_h).getTotalSeconds() == 86400 && 90_s > 1_min, "литералы сравниваются при компиляции");
+ static_assert((1_h - 2_h) == 0_s && (10_min * 1.5) == 15_min, "семантика операторов Time сохраняется");
+ 
+ // Буфер-заглушка: поглощает вывод деструкторов Time во время замеров
+ class NullBuffer : public streambuf {
+ protected:
+     int overflow(int c) override { return c; }
+     streamsize xsputn(const char*, streamsize n) override { return n; }
+ };
+ 
+ // Перенаправляет cout в заглушку на время жизни объекта
+ class SilenceCout {
+ private:
+     NullBuffer null_;
+     streambuf* saved_;
+ public:
+     SilenceCout() : saved_(cout.rdbuf(&null_)) {}
+     ~SilenceCout() { cout.rdbuf(saved_); }
+ };
+ 
+ // Счётчик выделений памяти текущего потока: проверки "без выделений"
+ // сравнивают его до и после цикла
+ #ifdef SCHEDULE_TRACING
+ // new/delete уже подменены в tracing.cpp
+ static size_t threadAllocations() { return traceThreadAllocations(); }
+ #else
+ static thread_local size_t allocationCount = 0;
+ static size_t threadAllocations() { return allocationCount; }
+ 
+ __attribute__((noinline)) void* operator new(size_t size) {
+     allocationCount++;
+     if (void* p = malloc(size != 0 ? size : 1)) return p;
+     throw bad_alloc();
+ }
+ __attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+ __attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+ #endif
+ 
+ static volatile long long benchSink = 0; // Не даёт компилятору выбросить вычисления
+ 
+ static double secondsSince(chrono::steady_clock::time_point start) {
+     return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+ }
+ 
+ static ofstream jsonOut;               // Результаты в JSON Lines (--json)
+ static const char* currentBenchmark = ""; // Выполняемый замер и его размер - для записей JSON
+ static size_t currentSize = 0;
+ 
+ // Имя в кавычках JSON: в именах замеров бывают только кавычки и обратная косая
+ static void writeJsonString(ostream& out, const string& text) {
+     out << '"';
+     for (char c : text) {
+         if (c == '"' || c == '\\') out << '\\';
+         out << c;
+     }
+     out << '"';
+ }
+ 
+ static void report(const string& name, size_t ops, double seconds) {
+     cout << left << setw(36) << name << right
+          << setw(12) << fixed << setprecision(2) << ops / seconds / 1e6 << " Mops/s"
+          << setw(12) << setprecision(2) << seconds * 1e9 / ops << " ns/op" << endl;
+     if (!jsonOut.is_open()) return;
+     jsonOut << "{\"benchmark\":";
+     writeJsonString(jsonOut, currentBenchmark);
+     jsonOut << ",\"name\":";
+     writeJsonString(jsonOut, name);
+     jsonOut << ",\"size\":" << currentSize << ",\"ops\":" << ops
+             << ",\"seconds\":" << setprecision(9) << seconds
+             << ",\"nsPerOp\":" << setprecision(3) << seconds * 1e9 / ops << "}\n";
+ }
+ 
+ // Пропускная способность в МБ/с (разбор, формат, импорт)
+ static void reportRate(const string& name, size_t bytes, double seconds) {
+     cout << left << setw(36) << name << right << setw(12) << fixed << setprecision(2)
+          << bytes / seconds / 1e6 << endl;
+     if (!jsonOut.is_open()) return;
+     jsonOut << "{\"benchmark\":";
+     writeJsonString(jsonOut, currentBenchmark);
+     jsonOut << ",\"name\":";
+     writeJsonString(jsonOut, name);
+     jsonOut << ",\"size\":" << currentSize << ",\"bytes\":" << bytes
+             << ",\"seconds\":" << setprecision(9) << seconds
+             << ",\"mbPerSecond\":" << setprecision(3) << bytes / seconds / 1e6 << "}\n";
+ }
+ 
+ // Смесь операторов Time: каждый вызов создаёт временные объекты,
+ // деструктор которых пишет в поток
+ static void benchTimeArithmetic(size_t n) {
+     long long acc = 0;
+     auto start = chrono::steady_clock::now();
+     {
+         SilenceCout silence;
+         Time step(0, 1, 30);
+         for (size_t i = 0; i < n; i++) {
+             Time t(0, 0, static_cast<int>(i % 86400));
+             Time sum = t + step;
+             sum -= step;
+             Time scaled = sum * 1.5;
+             if (scaled > t) acc += scaled.getTotalSeconds();
+             else acc -= t.getSeconds();
+         }
+     }
+     benchSink = benchSink + acc;
+     report("time/arithmetic (Time)", n, secondsSince(start));
+ }
+ 
+ // Та же смесь операторов на TimeValue
+ static void benchTimeValueArithmetic(size_t n) {
+     long long acc = 0;
+     auto start = chrono::steady_clock::now();
+     TimeValue step(0, 1, 30);
+     for (size_t i = 0; i < n; i++) {
+         TimeValue t = TimeValue::fromSeconds(static_cast<int>(i % 86400));
+         TimeValue sum = t + step;
+         sum -= step;
+         TimeValue scaled = sum * 1.5;
+         if (scaled > t) acc += scaled.getTotalSeconds();
+         else acc -= t.getSeconds();
+     }
+     benchSink = benchSink + acc;
+     report("time/arithmetic (TimeValue)", n, secondsSince(start));
+ }
+ 
+ // Каждый оператор и метод Time из time.h по отдельности. Деструкторы
+ // временных объектов и print() пишут в заглушку cout, как в остальных
+ // замерах Time.
+ static void benchTimeOperators(size_t n) {
+     struct Result {
+         const char* name;
+         double seconds;
+     };
+     vector<Result> results;
+     long long acc = 0;
+     {
+         SilenceCout silence;
+         Time t(1, 0, 0);
+         const Time step(0, 0, 7);
+         // Сравнения и методы доступа читают разные значения, иначе
+         // компилятор выносит их из цикла
+         vector<Time> probes;
+         probes.reserve(1024);
+         for (int i = 0; i < 1024; i++) probes.emplace_back(0, 0, i * 84);
+         // Замер одного оператора: body(i) вызывается n раз
+         auto measure = [&](const char* name, auto body) {
+             t.setTime(1, 0, 0);
+             auto start = chrono::steady_clock::now();
+             for (size_t i = 0; i < n; i++) body(i);
+             results.push_back({name, secondsSince(start)});
+             acc += t.getTotalSeconds();
+         };
+         measure("time/operators/++t", [&](size_t) { ++t; });
+         measure("time/operators/t++", [&](size_t) { t++; });
+         measure("time/operators/--t", [&](size_t) { --t; });
+         measure("time/operators/t--", [&](size_t) { t--; });
+         measure("time/operators/+=", [&](size_t) { t += step; });
+         measure("time/operators/-=", [&](size_t) { t -= step; });
+         measure("time/operators/*=", [&](size_t i) { t *= (i & 1) ? 2.0 : 0.5; });
+         measure("time/operators//=", [&](size_t i) { t /= (i & 1) ? 0.5 : 2.0; });
+         measure("time/operators/+", [&](size_t) { acc += (t + step).getTotalSeconds(); });
+         measure("time/operators/-", [&](size_t) { acc += (t - step).getTotalSeconds(); });
+         measure("time/operators/*", [&](size_t) { acc += (t * 1.5).getTotalSeconds(); });
+         measure("time/operators//", [&](size_t) { acc += (t / 1.5).getTotalSeconds(); });
+         measure("time/operators/<", [&](size_t i) { acc += probes[i & 1023] < step; });
+         measure("time/operators/>", [&](size_t i) { acc += probes[i & 1023] > step; });
+         measure("time/operators/<=", [&](size_t i) { acc += probes[i & 1023] <= step; });
+         measure("time/operators/>=", [&](size_t i) { acc += probes[i & 1023] >= step; });
+         measure("time/operators/==", [&](size_t i) { acc += probes[i & 1023] == step; });
+         measure("time/operators/!=", [&](size_t i) { acc += probes[i & 1023] != step; });
+         measure("time/operators/getters", [&](size_t i) {
+             const Time& p = probes[i & 1023];
+             acc += p.getHours() + p.getMinutes() + p.getSeconds();
+         });
+         measure("time/operators/setTime", [&](size_t i) { t.setTime(0, 0, static_cast<int>(i % 86400)); acc += t.getSeconds(); });
+         measure("time/operators/print", [&](size_t) { t.print(); });
+         measure("time/operators/Time(h, m, s)", [&](size_t i) { Time made(0, 0, static_cast<int>(i)); acc += made.getSeconds(); });
+         measure("time/operators/Time(const Time&)", [&](size_t) { Time copy(t); acc += copy.getSeconds(); });
+     }
+     benchSink = benchSink + acc;
+     for (const Result& r : results) report(r.name, n, r.seconds);
+ }
+ 
+ // Сравнения и методы доступа Time над готовым массивом: без лишних
+ // объектов, только вызовы getHours()/operator< и т.п.
+ static void benchTimeCompare(size_t n) {
+     mt19937 rng(17);
+     uniform_int_distribution<int> second(0, 86399);
+     double seconds = 0;
+     long long acc = 0;
+     {
+         SilenceCout silence;
+         vector<Time> times;
+         times.reserve(n);
+         for (size_t i = 0; i < n; i++) times.emplace_back(0, 0, second(rng));
+         const Time noon(12, 0, 0);
+         auto start = chrono::steady_clock::now();
+         for (size_t i = 1; i < n; i++) {
+             if (times[i - 1] < times[i]) acc++;
+             if (times[i] >= noon) acc += times[i].getHours();
+             acc += times[i].getMinutes() + times[i].getSeconds();
+         }
+         seconds = secondsSince(start);
+     }
+     benchSink = benchSink + acc;
+     report("time/compare (Time)", n, seconds);
+     
+     rng.seed(17);
+     vector<TimeValue> values(n);
+     for (TimeValue& value : values) value = TimeValue::fromSeconds(second(rng));
+     long long valueAcc = 0;
+     auto start = chrono::steady_clock::now();
+     for (size_t i = 1; i < n; i++) {
+         if (values[i - 1] < values[i]) valueAcc++;
+         if (values[i] >= 12_h) valueAcc += values[i].getHours();
+         valueAcc += values[i].getMinutes() + values[i].getSeconds();
+     }
+     report("time/compare (TimeValue)", n, secondsSince(start));
+     benchSink = benchSink + valueAcc;
+     if (valueAcc != acc) {
+         cerr << "time/compare: Time и TimeValue дали разные суммы" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Сумма длительностей за год: n мероприятий в день по 1-4 часа, 365 дней.
+ // Прежний int (здесь - unsigned, чтобы переполнение не было UB)
+ // молча заворачивается; TimeSpan32 насыщается, TimeSpanMs считает точно
+ // (TimeSpanNs хватает на 292 года - для такой суммы мало).
+ static void benchTimeSpan(size_t n) {
+     mt19937 rng(16);
+     uniform_int_distribution<int> length(3600, 4 * 3600);
+     vector<int> durations(n);
+     for (int& d : durations) d = length(rng);
+     const size_t days = 365;
+     long long expected = 0;
+     for (int d : durations) expected += d;
+     expected *= static_cast<long long>(days);
+     
+     unsigned wrapped = 0;
+     auto start = chrono::steady_clock::now();
+     for (size_t day = 0; day < days; day++) {
+         for (int d : durations) wrapped += static_cast<unsigned>(d);
+     }
+     report("time/span/int (wraps)", n * days, secondsSince(start));
+     
+     TimeValue value;
+     start = chrono::steady_clock::now();
+     for (size_t day = 0; day < days; day++) {
+         for (int d : durations) value += TimeValue::fromSeconds(d);
+     }
+     report("time/span/TimeValue (saturating)", n * days, secondsSince(start));
+     
+     TimeSpan32 span32;
+     start = chrono::steady_clock::now();
+     for (size_t day = 0; day < days; day++) {
+         for (int d : durations) span32 += TimeSpan32::fromTicks(d);
+     }
+     report("time/span/TimeSpan32 (saturating)", n * days, secondsSince(start));
+     
+     TimeSpanMs spanMs;
+     start = chrono::steady_clock::now();
+     for (size_t day = 0; day < days; day++) {
+         for (int d : durations) spanMs += TimeSpanMs::fromTicks(d * 1000LL);
+     }
+     report("time/span/TimeSpanMs (saturating)", n * days, secondsSince(start));
+     
+     TimeSpanMs checkedMs;
+     size_t overflows = 0;
+     start = chrono::steady_clock::now();
+     for (size_t day = 0; day < days; day++) {
+         for (int d : durations) overflows += !checkedMs.checkedAdd(TimeSpanMs::fromTicks(d * 1000LL));
+     }
+     report("time/span/TimeSpanMs (checked)", n * days, secondsSince(start));
+     benchSink = benchSink + static_cast<long long>(wrapped) + value.getTotalSeconds() + span32.ticks();
+     
+     bool overflowed = expected > INT32_MAX;
+     bool timeSaturates = false;
+     {
+         SilenceCout silence;
+         timeSaturates = Time(700000, 0, 0).getTotalSeconds() == INT32_MAX;
+     }
+     TimeSpanNs asNs = timeSpanCast<TimeSpanNs>(spanMs);
+     bool same = spanMs.totalSeconds() == expected && checkedMs == spanMs && overflows == 0
+         && asNs == (expected > INT64_MAX / 1000000000 ? TimeSpanNs::max() : TimeSpanNs::fromSeconds(expected))
+         && span32.ticks() == (overflowed ? INT32_MAX : expected)
+         && value.getTotalSeconds() == (overflowed ? INT32_MAX : expected)
+         && (TimeSpanNs::max() + TimeSpanNs::fromTicks(1)) == TimeSpanNs::max()
+         && (TimeSpanNs::min() - TimeSpanNs::fromTicks(1)) == TimeSpanNs::min()
+         && (TimeSpan32::fromSeconds(100000) * 1e9) == TimeSpan32::max()
+         && timeSaturates;
+     if (!same) {
+         cerr << "time/span: сумма или насыщение не совпадают с ожидаемыми" << endl;
+         exit(1);
+     }
+     cout << "time/span: точная сумма " << expected << " с, int дал " << static_cast<int>(wrapped)
+          << (overflowed ? " (переполнение)" : "") << endl;
+ }
+ 
+ // Запускает body(threadIndex, perThread) в threads потоках и возвращает время
+ template <typename Body>
+ static double runThreads(unsigned threads, size_t perThread, Body body) {
+     vector<thread> workers;
+     atomic<bool> go{false};
+     for (unsigned t = 0; t < threads; t++) {
+         workers.emplace_back([&, t] {
+             while (!go.load(memory_order_acquire)) this_thread::yield();
+             body(t, perThread);
+         });
+     }
+     auto start = chrono::steady_clock::now();
+     go.store(true, memory_order_release);
+     for (thread& w : workers) w.join();
+     return secondsSince(start);
+ }
+ 
+ static vector<unsigned> threadCounts() {
+     unsigned hw = max(1u, thread::hardware_concurrency());
+     vector<unsigned> counts;
+     for (unsigned t = 1; t < hw; t *= 2) counts.push_back(t);
+     counts.push_back(hw);
+     return counts;
+ }
+ 
+ // Конструирование и арифметика Time из нескольких потоков. Объект
+ // создаётся размещающим new в локальном буфере и не разрушается, чтобы
+ // замер видел только конструктор и счетчики, а не вывод деструктора.
+ static void benchCounterStress(size_t n) {
+     TimeStats before = Time::getOperationStats();
+     size_t expected = 0;
+     for (unsigned threads : threadCounts()) {
+         double seconds = runThreads(threads, n, [](unsigned, size_t count) {
+             alignas(Time) unsigned char storage[sizeof(Time)];
+             long long acc = 0;
+             for (size_t i = 0; i < count; i++) {
+                 Time* t = new (storage) Time(0, 0, static_cast<int>(i & 1023));
+                 ++*t;
+                 acc += t->getTotalSeconds();
+             }
+             benchSink = benchSink + acc;
+         });
+         expected += threads * n;
+         string name = "time/counter/sharded x" + to_string(threads);
+         report(name, threads * n, seconds);
+     }
+     TimeStats after = Time::getOperationStats();
+     if (after.constructions - before.constructions != expected) {
+         cerr << "Счетчик конструкций расходится: ожидалось " << expected
+              << ", получено " << after.constructions - before.constructions << endl;
+         exit(1);
+     }
+ }
+ 
+ // Базовая линия: один общий атомарный счетчик на все потоки
+ static void benchCounterSharedAtomic(size_t n) {
+     static atomic<size_t> shared{0};
+     for (unsigned threads : threadCounts()) {
+         double seconds = runThreads(threads, n, [](unsigned, size_t count) {
+             for (size_t i = 0; i < count; i++) {
+                 shared.fetch_add(1, memory_order_relaxed);
+             }
+         });
+         string name = "time/counter/shared-atomic x" + to_string(threads);
+         report(name, threads * n, seconds);
+     }
+ }
+ 
+ // Прежняя раскладка расписания: массив указателей на отдельные объекты
+ struct LegacyEvent {
+     string name;
+     Time startTime;
+     Time endTime;
+     Time plannedDuration;
+     Time actualDuration;
+ };
+ 
+ // Случайное мероприятие: начало, конец и план в пределах суток
+ struct EventSample {
+     int start;
+     int end;
+     int planned;
+ };
+ 
+ static vector<EventSample> makeEvents(size_t n, unsigned seed = 42) {
+     mt19937 rng(seed);
+     uniform_int_distribution<int> second(0, 86399);
+     uniform_int_distribution<int> length(60, 4 * 3600);
+     vector<EventSample> events(n);
+     for (EventSample& e : events) {
+         e.start = second(rng);
+         e.end = (e.start + length(rng)) % 86400;
+         e.planned = length(rng);
+     }
+     return events;
+ }
+ 
+ // Полный проход отчёта "план/факт" по обеим раскладкам
+ static void benchScheduleScan(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     size_t reps = max<size_t>(1, 20000000 / n);
+     
+     vector<LegacyEvent*> legacy(n);
+     {
+         SilenceCout silence;
+         for (size_t i = 0; i < n; i++) {
+             legacy[i] = new LegacyEvent;
+             legacy[i]->name = "Event " + to_string(i);
+             legacy[i]->startTime.setTime(0, 0, samples[i].start);
+             legacy[i]->endTime.setTime(0, 0, samples[i].end);
+             legacy[i]->plannedDuration.setTime(0, 0, samples[i].planned);
+             legacy[i]->actualDuration.setTime(0, 0, actualDurationSeconds(samples[i].start, samples[i].end));
+         }
+     }
+     // После правок и удалений порядок в массиве не совпадает с порядком в куче
+     shuffle(legacy.begin(), legacy.end(), mt19937(7));
+     
+     ScheduleStore store;
+     for (size_t i = 0; i < n; i++) {
+         store.add("Event " + to_string(i), samples[i].start, samples[i].end, samples[i].planned);
+     }
+     
+     long long legacyOverrun = 0;
+     auto start = chrono::steady_clock::now();
+     for (size_t r = 0; r < reps; r++) {
+         for (const LegacyEvent* e : legacy) {
+             if (e->actualDuration > e->plannedDuration) {
+                 legacyOverrun += e->actualDuration.getTotalSeconds() - e->plannedDuration.getTotalSeconds();
+             }
+         }
+     }
+     string name = "schedule/scan/Event** n=" + to_string(n);
+     report(name, n * reps, secondsSince(start));
+     
+     long long storeOverrun = 0;
+     const int32_t* actual = store.actualColumn();
+     const int32_t* planned = store.plannedColumn();
+     start = chrono::steady_clock::now();
+     for (size_t r = 0; r < reps; r++) {
+         for (int i = 0; i < store.size(); i++) {
+             if (actual[i] > planned[i]) storeOverrun += actual[i] - planned[i];
+         }
+     }
+     name = "schedule/scan/ScheduleStore n=" + to_string(n);
+     report(name, n * reps, secondsSince(start));
+     
+     if (legacyOverrun != storeOverrun) {
+         cerr << "Результаты проходов расходятся" << endl;
+         exit(1);
+     }
+     benchSink = benchSink + storeOverrun;
+     
+     SilenceCout silence;
+     for (LegacyEvent* e : legacy) delete e;
+ }
+ 
+ // Запрос "что идёт в момент T": индекс интервалов против линейного прохода
+ static void benchScheduleQuery(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     for (size_t i = 0; i < n; i++) {
+         store.add("", samples[i].start, samples[i].end, samples[i].planned);
+     }
+     // Короткие мероприятия: на каждый момент приходится немного совпадений
+     for (int i = 0; i < store.size(); i++) {
+         store.setEnd(i, (store.start(i) + 60 + i % 600) % 86400);
+     }
+     
+     size_t queries = 2000;
+     mt19937 rng(3);
+     vector<int> moments(queries);
+     for (int& t : moments) t = static_cast<int>(rng() % 86400);
+     
+     size_t indexed = 0;
+     vector<EventHandle> found;
+     auto start = chrono::steady_clock::now();
+     for (int t : moments) {
+         found.clear();
+         store.intervals().activeAt(t, found);
+         indexed += found.size();
+     }
+     string name = "schedule/query/index n=" + to_string(n);
+     report(name, queries, secondsSince(start));
+     
+     size_t scanned = 0;
+     const int32_t* startCol = store.startColumn();
+     const int32_t* endCol = store.endColumn();
+     start = chrono::steady_clock::now();
+     for (int t : moments) {
+         for (int i = 0; i < store.size(); i++) {
+             int from = startCol[i];
+             int to = from + actualDurationSeconds(from, endCol[i]);
+             if ((from <= t && t < to) || (from <= t + 86400 && t + 86400 < to)) scanned++;
+         }
+     }
+     name = "schedule/query/linear n=" + to_string(n);
+     report(name, queries, secondsSince(start));
+     
+     if (indexed != scanned) {
+         cerr << "Индекс и линейный проход нашли разное число мероприятий" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Проверка пересечений: заметающая прямая против попарного сравнения.
+ // n мероприятий по 1-2 секунды равномерно по суткам: при 10^6 на каждую
+ // секунду приходится около дюжины мероприятий.
+ static void benchConflicts(size_t n) {
+     ScheduleStore store;
+     for (size_t i = 0; i < n; i++) {
+         int start = static_cast<int>(i * 86400 / n);
+         store.add("", start, (start + 1 + (i % 7 == 0)) % 86400, 1);
+     }
+     
+     ConflictOptions options;
+     options.minGapSeconds = 60;
+     for (unsigned threads : threadCounts()) {
+         options.threads = threads;
+         options.parallelThreshold = 0;
+         auto start = chrono::steady_clock::now();
+         ConflictReport result = findConflicts(store, options);
+         string name = "schedule/conflicts/sweep n=" + to_string(n) + " x" + to_string(threads);
+         report(name, n, secondsSince(start));
+         benchSink = benchSink + static_cast<long long>(result.overlaps.size());
+     }
+     
+     // Попарная проверка на префиксе, который она успевает обработать
+     int m = static_cast<int>(min<size_t>(n, 20000));
+     ScheduleStore prefix;
+     for (int i = 0; i < m; i++) prefix.add("", store.start(i), store.end(i), 1);
+     size_t pairs = 0;
+     auto start = chrono::steady_clock::now();
+     for (int i = 0; i < m; i++) {
+         for (int j = i + 1; j < m; j++) {
+             if (circularOverlapSeconds(prefix.start(i), prefix.end(i), prefix.start(j), prefix.end(j)) > 0) pairs++;
+         }
+     }
+     string name = "schedule/conflicts/pairwise n=" + to_string(m);
+     report(name, m, secondsSince(start));
+     
+     if (findConflicts(prefix, options).overlaps.size() != pairs) {
+         cerr << "Заметающая прямая и попарная проверка нашли разное число пересечений" << endl;
+         exit(1);
+     }
+     
+     // Мероприятие на двое суток (конец 49:00:00) занимает весь суточный круг
+     ScheduleStore multiDay;
+     multiDay.add("Двое суток", 3600, 49 * 3600, 0);
+     multiDay.add("Час", 10 * 3600, 11 * 3600, 3600);
+     multiDay.add("Ночь", 23 * 3600, 2 * 3600, 3 * 3600);
+     ConflictReport multiDayReport = findConflicts(multiDay, ConflictOptions());
+     vector<EventHandle> activeAtNight;
+     multiDay.intervals().activeAt(1800, activeAtNight);
+     bool multiDayOk = multiDayReport.overlaps.size() == 2 && activeAtNight.size() == 2;
+     for (const EventConflict& c : multiDayReport.overlaps) {
+         multiDayOk = multiDayOk && c.first == 0 && c.overlapSeconds == multiDay.actual(c.second);
+     }
+     if (!multiDayOk) {
+         cerr << "schedule/conflicts: мероприятие длиннее суток не учтено" << endl;
+         exit(1);
+     }
+ }
+ 
+ static const char* isaName(TimeBatchIsa isa) {
+     switch (isa) {
+         case TimeBatchIsa::Avx2: return "avx2";
+         case TimeBatchIsa::Sse2: return "sse2";
+         default: return "scalar";
+     }
+ }
+ 
+ // Сверка пакетных операций с операторами Time на случайных данных:
+ // для каждого доступного набора инструкций и длин, не кратных ширине регистра.
+ // Часть раундов берёт значения у границ int32 и большие множители, чтобы
+ // проверить насыщение
+ static void verifyTimeBatch() {
+     SilenceCout silence;
+     mt19937 rng(11);
+     uniform_int_distribution<int> value(-1000000, 10000000);
+     uniform_int_distribution<int32_t> anyValue(INT32_MIN, INT32_MAX);
+     uniform_int_distribution<int> nearLimit(0, 1000);
+     uniform_real_distribution<double> factor(-3.0, 3.0);
+     uniform_real_distribution<double> largeFactor(-5000.0, 5000.0);
+     auto draw = [&](int round) -> int32_t {
+         switch (round % 3) {
+             case 0: return value(rng);
+             case 1: return anyValue(rng);
+             default: return rng() % 2 ? INT32_MAX - nearLimit(rng) : INT32_MIN + nearLimit(rng);
+         }
+     };
+     TimeBatchIsa saved = timeBatchIsa();
+     
+     for (TimeBatchIsa isa : {TimeBatchIsa::Scalar, TimeBatchIsa::Sse2, TimeBatchIsa::Avx2}) {
+         if (!setTimeBatchIsa(isa)) continue;
+         for (int round = 0; round < 200; round++) {
+             size_t n = rng() % 67;
+             vector<int32_t> a(n), b(n), out(n), h(n), m(n), sec(n);
+             vector<int8_t> cmp(n);
+             for (size_t i = 0; i < n; i++) {
+                 a[i] = draw(round);
+                 b[i] = round % 5 == 0 ? a[i] : draw(round);
+             }
+             double k = round % 7 == 0 ? 0.5 : round % 3 == 0 ? factor(rng) : largeFactor(rng);
+             if (round % 29 == 0) k = round % 58 == 0 ? NAN : -INFINITY;
+             
+             bool ok = true;
+             addTimes(a.data(), b.data(), out.data(), n);
+             for (size_t i = 0; i < n; i++) ok &= (Time(0, 0, a[i]) += Time(0, 0, b[i])).getTotalSeconds() == out[i];
+             subtractTimes(a.data(), b.data(), out.data(), n);
+             for (size_t i = 0; i < n; i++) ok &= (Time(0, 0, a[i]) -= Time(0, 0, b[i])).getTotalSeconds() == out[i];
+             scaleTimes(a.data(), k, out.data(), n);
+             for (size_t i = 0; i < n; i++) ok &= (Time(0, 0, a[i]) *= k).getTotalSeconds() == out[i];
+             compareTimes(a.data(), b.data(), cmp.data(), n);
+             for (size_t i = 0; i < n; i++) {
+                 Time x(0, 0, a[i]), y(0, 0, b[i]);
+                 ok &= cmp[i] == (x < y ? -1 : x > y ? 1 : 0);
+             }
+             splitTimes(a.data(), h.data(), m.data(), sec.data(), n);
+             for (size_t i = 0; i < n; i++) {
+                 Time x(0, 0, a[i]);
+                 ok &= x.getHours() == h[i] && x.getMinutes() == m[i] && x.getSeconds() == sec[i];
+             }
+             if (!ok) {
+                 setTimeBatchIsa(saved);
+                 cerr << "Пакетные операции (" << isaName(isa) << ") расходятся с операторами Time" << endl;
+                 exit(1);
+             }
+         }
+     }
+     setTimeBatchIsa(saved);
+ }
+ 
+ // Пакетные операции над столбцом секунд для каждого набора инструкций
+ static void benchTimeBatch(size_t n) {
+     verifyTimeBatch();
+     
+     mt19937 rng(5);
+     vector<int32_t> a(n), b(n), out(n), h(n), m(n), sec(n);
+     vector<int8_t> cmp(n);
+     for (size_t i = 0; i < n; i++) {
+         a[i] = static_cast<int32_t>(rng() % 86400);
+         b[i] = static_cast<int32_t>(rng() % 86400);
+     }
+     size_t reps = max<size_t>(1, 50000000 / n);
+     TimeBatchIsa saved = timeBatchIsa();
+     
+     for (TimeBatchIsa isa : {TimeBatchIsa::Scalar, TimeBatchIsa::Sse2, TimeBatchIsa::Avx2}) {
+         if (!setTimeBatchIsa(isa)) continue;
+         string suffix = string(" ") + isaName(isa);
+         
+         auto start = chrono::steady_clock::now();
+         for (size_t r = 0; r < reps; r++) addTimes(a.data(), b.data(), out.data(), n);
+         report("time/batch/add" + suffix, n * reps, secondsSince(start));
+         
+         start = chrono::steady_clock::now();
+         for (size_t r = 0; r < reps; r++) subtractTimes(a.data(), b.data(), out.data(), n);
+         report("time/batch/subtract" + suffix, n * reps, secondsSince(start));
+         
+         start = chrono::steady_clock::now();
+         for (size_t r = 0; r < reps; r++) scaleTimes(a.data(), 1.25, out.data(), n);
+         report("time/batch/scale" + suffix, n * reps, secondsSince(start));
+         
+         start = chrono::steady_clock::now();
+         for (size_t r = 0; r < reps; r++) compareTimes(a.data(), b.data(), cmp.data(), n);
+         report("time/batch/compare" + suffix, n * reps, secondsSince(start));
+         
+         start = chrono::steady_clock::now();
+         for (size_t r = 0; r < reps; r++) splitTimes(a.data(), h.data(), m.data(), sec.data(), n);
+         report("time/batch/split" + suffix, n * reps, secondsSince(start));
+         
+         benchSink = benchSink + out[n / 2] + cmp[n / 3] + sec[n / 4];
+     }
+     setTimeBatchIsa(saved);
+ }
+ 
+ // Прежний print(): отдельная вставка в поток на каждую часть времени
+ static void legacyPrint(ostream& os, int totalSeconds) {
+     int hours = totalSeconds / 3600;
+     int minutes = (totalSeconds % 3600) / 60;
+     int seconds = totalSeconds % 60;
+     os << hours << ":";
+     if (minutes < 10) os << "0";
+     os << minutes << ":";
+     if (seconds < 10) os << "0";
+     os << seconds;
+ }
+ 
+ // Форматирование столбца времён: потоковые вставки, print() и formatTimes
+ static void benchFormat(size_t n) {
+     mt19937 rng(9);
+     vector<int32_t> values(n);
+     for (int32_t& v : values) v = static_cast<int32_t>(rng() % (100 * 3600));
+     
+     // formatSeconds должен совпадать с прежним выводом, включая отрицательные значения
+     for (int v : {0, 9, 59, 60, 3599, 3600, 35999, 360000, -1, -61, -3601, -2147483647 - 1, 2147483647}) {
+         ostringstream expected;
+         legacyPrint(expected, v);
+         char buffer[Time::maxFormattedLength];
+         if (string(buffer, Time::formatSeconds(v, buffer)) != expected.str()) {
+             cerr << "formatSeconds(" << v << ") расходится с прежним print()" << endl;
+             exit(1);
+         }
+     }
+     
+     double seconds;
+     auto start = chrono::steady_clock::now();
+     {
+         SilenceCout silence;
+         for (int32_t v : values) {
+             legacyPrint(cout, v);
+             cout << '\n';
+         }
+     }
+     report("time/format/iostream", n, secondsSince(start));
+     
+     start = chrono::steady_clock::now();
+     {
+         SilenceCout silence;
+         for (int32_t v : values) {
+             TimeValue::fromSeconds(v).print();
+             cout << '\n';
+         }
+     }
+     report("time/format/print", n, secondsSince(start));
+     
+     vector<char> text(n * (Time::maxFormattedLength + 1));
+     start = chrono::steady_clock::now();
+     char* end = formatTimes(values.data(), n, text.data(), '\n');
+     seconds = secondsSince(start);
+     report("time/format/formatTimes", n, seconds);
+     reportRate("time/format/formatTimes MB/s", static_cast<size_t>(end - text.data()), seconds);
+ }
+ 
+ // Разбор столбца времён: istringstream >> h >> m >> s против parseTimes
+ static void benchParse(size_t n) {
+     mt19937 rng(10);
+     vector<int32_t> values(n);
+     for (int32_t& v : values) v = static_cast<int32_t>(rng() % (24 * 3600));
+ 
+     // Половина строк "Ч:ММ:СС", половина "Ч М С" - как вводит пользователь
+     string colon(n * (Time::maxFormattedLength + 1), '\0');
+     colon.resize(formatTimes(values.data(), n, &colon[0], '\n') - colon.data());
+     string text;
+     text.reserve(colon.size());
+     string spaced;
+     spaced.reserve(colon.size());
+     size_t line = 0;
+     for (size_t i = 0; i < colon.size(); i++) {
+         char c = colon[i];
+         if (c == '\n') line++;
+         text.push_back(c == ':' && line % 2 == 1 ? ' ' : c);
+         spaced.push_back(c == ':' ? ' ' : c);
+     }
+ 
+     // Ошибочные строки не должны сбивать разбор соседних
+     const char sample[] = "1:02:03\n\n 4 5 6 \n9 75 0\n1:2 3\nx\n99999999999 0 0\n7:08:09";
+     int32_t parsed[8];
+     vector<TimeLineError> errors;
+     size_t count = parseTimes(sample, sample + sizeof(sample) - 1, parsed, 8, &errors);
+     if (count != 3 || parsed[0] != 3723 || parsed[1] != 14706 || parsed[2] != 25689 || errors.size() != 4
+         || errors[0].line != 4 || errors[0].error != TimeParseError::MinutesOutOfRange
+         || errors[3].error != TimeParseError::Overflow) {
+         cerr << "parseTimes неверно обрабатывает ошибочные строки" << endl;
+         exit(1);
+     }
+ 
+     auto start = chrono::steady_clock::now();
+     vector<int32_t> legacy;
+     legacy.reserve(n);
+     {
+         istringstream in(spaced);
+         int h, m, s;
+         while (in >> h >> m >> s) legacy.push_back(h * 3600 + m * 60 + s);
+     }
+     report("time/parse/istringstream", n, secondsSince(start));
+ 
+     vector<int32_t> fast(n);
+     start = chrono::steady_clock::now();
+     count = parseTimes(text.data(), text.data() + text.size(), fast.data(), n);
+     double seconds = secondsSince(start);
+     report("time/parse/parseTimes", n, seconds);
+     reportRate("time/parse/parseTimes MB/s", text.size(), seconds);
+ 
+     if (count != n || legacy != values || fast != values) {
+         cerr << "time/parse: результаты расходятся" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Эталон для civilFromDays: алгоритм Хиннанта (days_from_civil/civil_from_days)
+ // с делениями по эрам - другой вывод тех же формул
+ static CivilDate referenceCivil(int64_t days) {
+     days += 719468;
+     int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+     int64_t dayOfEra = days - era * 146097;
+     int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+     int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+     int64_t mp = (5 * dayOfYear + 2) / 153;
+     int64_t day = dayOfYear - (153 * mp + 2) / 5 + 1;
+     int64_t month = mp < 10 ? mp + 3 : mp - 9;
+     return CivilDate{static_cast<int32_t>(yearOfEra + era * 400 + (month <= 2)),
+                      static_cast<uint32_t>(month), static_cast<uint32_t>(day)};
+ }
+ 
+ // Даты: проверка перевода на всём диапазоне DateTime и сравнение
+ // пакетного перевода и вывода с gmtime_r и strftime
+ static void benchDateTime(size_t n) {
+     // Все дни диапазона: туда и обратно и против эталона
+     for (int32_t d = DateTime::minDay; d <= DateTime::maxDay; d++) {
+         CivilDate date = civilFromDays(d);
+         if (date != referenceCivil(d) || daysFromCivil(date.year, date.month, date.day) != d
+             || date.day > daysInMonth(date.year, date.month)) {
+             cerr << "time/datetime: перевод дня " << d << " расходится с эталоном" << endl;
+             exit(1);
+         }
+     }
+     
+     // Моменты с 1 по 9999 год: как у gmtime_r
+     mt19937_64 rng(23);
+     const int64_t first = DateTime::fromCivil(1, 1, 1).unixSeconds();
+     const int64_t last = DateTime::fromCivil(9999, 12, 31, 23, 59, 59).unixSeconds();
+     vector<int64_t> moments(n);
+     for (int64_t& m : moments) m = first + static_cast<int64_t>(rng() % static_cast<uint64_t>(last - first + 1));
+     vector<int32_t> days(n);
+     for (size_t i = 0; i < n; i++) days[i] = DateTime::fromUnixSeconds(moments[i]).day();
+     
+     vector<struct tm> parts(n);
+     auto start = chrono::steady_clock::now();
+     for (size_t i = 0; i < n; i++) {
+         time_t t = static_cast<time_t>(moments[i]);
+         gmtime_r(&t, &parts[i]);
+     }
+     report("time/datetime/gmtime_r", n, secondsSince(start));
+     
+     vector<int32_t> years(n), months(n), daysOfMonth(n);
+     start = chrono::steady_clock::now();
+     splitDates(days.data(), years.data(), months.data(), daysOfMonth.data(), n);
+     report("time/datetime/splitDates", n, secondsSince(start));
+     
+     for (size_t i = 0; i < n; i++) {
+         DateTime moment = DateTime::fromUnixSeconds(moments[i]);
+         if (years[i] != parts[i].tm_year + 1900 || months[i] != parts[i].tm_mon + 1
+             || daysOfMonth[i] != parts[i].tm_mday || moment.secondsOfDay() != parts[i].tm_hour * 3600
+                 + parts[i].tm_min * 60 + parts[i].tm_sec
+             || static_cast<int>(moment.weekday() % 7) != parts[i].tm_wday) {
+             cerr << "time/datetime: момент " << moments[i] << " расходится с gmtime_r" << endl;
+             exit(1);
+         }
+     }
+     
+     // Вывод: gmtime_r + strftime против formatDateTimes
+     vector<char> expected(n * (DateTime::maxFormattedLength + 1));
+     char* end = expected.data();
+     start = chrono::steady_clock::now();
+     for (size_t i = 0; i < n; i++) {
+         time_t t = static_cast<time_t>(moments[i]);
+         struct tm part;
+         gmtime_r(&t, &part);
+         end += strftime(end, DateTime::maxFormattedLength + 1, "%Y-%m-%d %H:%M:%S", &part);
+         *end++ = '\n';
+     }
+     double seconds = secondsSince(start);
+     report("time/datetime/strftime", n, seconds);
+     size_t expectedSize = static_cast<size_t>(end - expected.data());
+     
+     vector<char> text(n * (DateTime::maxFormattedLength + 1));
+     start = chrono::steady_clock::now();
+     end = formatDateTimes(moments.data(), n, text.data(), '\n');
+     seconds = secondsSince(start);
+     report("time/datetime/formatDateTimes", n, seconds);
+     reportRate("time/datetime/formatDateTimes MB/s", static_cast<size_t>(end - text.data()), seconds);
+     
+     // Годы 1..999 strftime пишет без ведущих нулей, formatTo - с ними
+     bool same = true;
+     const char* a = expected.data();
+     const char* b = text.data();
+     for (size_t i = 0; i < n && same; i++) {
+         const char* lineEndA = static_cast<const char*>(memchr(a, '\n', expected.data() + expectedSize - a));
+         const char* lineEndB = static_cast<const char*>(memchr(b, '\n', end - b));
+         string left(a, lineEndA), right(b, lineEndB);
+         while (right.size() > left.size() && right[0] == '0') right.erase(0, 1);
+         same = left == right;
+         a = lineEndA + 1;
+         b = lineEndB + 1;
+     }
+     if (!same) {
+         cerr << "time/datetime: formatDateTimes расходится со strftime" << endl;
+         exit(1);
+     }
+     
+     // Длительности через сутки: разность моментов против поправки на 86400
+     vector<int32_t> starts(n), ends(n);
+     for (size_t i = 0; i < n; i++) {
+         starts[i] = static_cast<int32_t>(rng() % 86400);
+         ends[i] = static_cast<int32_t>(rng() % 86400);
+     }
+     long long total = 0, expectedTotal = 0;
+     start = chrono::steady_clock::now();
+     for (size_t i = 0; i < n; i++) {
+         DateTime from(0, starts[i]);
+         total += (from.nextAt(ends[i]) - from).ticks();
+     }
+     report("time/datetime/nextAt duration", n, secondsSince(start));
+     for (size_t i = 0; i < n; i++) expectedTotal += actualDurationSeconds(starts[i], ends[i]);
+     if (total != expectedTotal) {
+         cerr << "time/datetime: nextAt расходится с actualDurationSeconds" << endl;
+         exit(1);
+     }
+     benchSink = benchSink + total;
+ }
+ 
+ // Сценарий пакетного режима: добавления, правки и удаления, как в меню
+ // создания мероприятий. Размер расписания держится около 10 тысяч.
+ static void benchCommands(size_t n) {
+     mt19937 rng(11);
+     uniform_int_distribution<int> second(0, 86399);
+     uniform_int_distribution<int> length(60, 4 * 3600);
+     const size_t target = 10000;
+     string script;
+     size_t live = 0;
+     char buffer[Time::maxFormattedLength];
+     auto appendTime = [&](int seconds) { script.append(buffer, Time::formatSeconds(seconds, buffer)); };
+     
+     for (size_t i = 0; i < n; i++) {
+         unsigned kind = rng() % 100;
+         if (live == 0 || (live < target && kind < 50) || kind < 30) {
+             script += "add ";
+             appendTime(second(rng));
+             script += ' ';
+             appendTime(second(rng));
+             script += ' ';
+             appendTime(length(rng));
+             script += " Event ";
+             script += to_string(i);
+             live++;
+         } else if (kind < 80) {
+             static const char* const fields[] = {"start", "end", "planned"};
+             script += "edit ";
+             script += to_string(rng() % live + 1);
+             if (kind < 45) {
+                 script += " name Renamed ";
+                 script += to_string(i);
+             } else {
+                 script += ' ';
+                 script += fields[kind % 3];
+                 script += ' ';
+                 appendTime(second(rng));
+             }
+         } else {
+             script += "delete ";
+             script += to_string(rng() % live + 1);
+             live--;
+         }
+         script += '\n';
+     }
+     
+     ScheduleStore store;
+     ostringstream out;
+     vector<CommandError> errors;
+     auto start = chrono::steady_clock::now();
+     CommandStats stats = runCommands(store, script.data(), script.data() + script.size(), out, &errors);
+     report("schedule/commands", n, secondsSince(start));
+     
+     if (stats.commands != n || !errors.empty() || static_cast<size_t>(store.size()) != live) {
+         cerr << "schedule/commands: выполнено " << stats.commands << " из " << n << " команд, ошибок "
+              << errors.size() << ", мероприятий " << store.size() << " вместо " << live << endl;
+         exit(1);
+     }
+ }
+ 
+ // Сохранение и загрузка двоичного файла расписания
+ static void benchScheduleFile(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     for (size_t i = 0; i < n; i++) {
+         store.add("Event " + to_string(i), samples[i].start, samples[i].end, samples[i].planned);
+     }
+     // Правки и удаления оставляют мусор в буфере названий, в файл он не попадает
+     for (size_t i = 0; i < n / 10; i++) store.setName(static_cast<int>(i * 7 % n), "Renamed event " + to_string(i));
+     // Правила повторения сохраняются вместе с мероприятиями (часть - у удаляемых)
+     int32_t firstDay = daysFromCivil(2026, 10, 19);
+     for (size_t i = 0; i < n; i += 13) {
+         int index = static_cast<int>(i);
+         switch (i % 3) {
+             case 0: store.setRecurrence(index, RecurrenceRule::everyMinutes(30 + i % 7, firstDay)); break;
+             case 1: store.setRecurrence(index, RecurrenceRule::daily(1 + i % 5, firstDay, firstDay + 90)); break;
+             default: store.setRecurrence(index, RecurrenceRule::weekly(1 + i % 2, static_cast<uint8_t>(i % 128), firstDay)); break;
+         }
+     }
+     for (size_t i = 0; i < n / 100; i++) store.remove(static_cast<int>(store.size() - 1 - i % 64));
+     
+     const char* path = "bench-schedule.bin";
+     auto start = chrono::steady_clock::now();
+     ScheduleFileError error = saveSchedule(store, path);
+     report("schedule/file/save", store.size(), secondsSince(start));
+     
+     start = chrono::steady_clock::now();
+     ScheduleFile file;
+     if (error == ScheduleFileError::None) error = file.open(path);
+     report("schedule/file/open (mmap)", store.size(), secondsSince(start));
+     if (error != ScheduleFileError::None) {
+         cerr << "schedule/file: " << scheduleFileErrorText(error) << endl;
+         exit(1);
+     }
+     
+     ScheduleStore loaded;
+     start = chrono::steady_clock::now();
+     file.copyTo(loaded);
+     report("schedule/file/load", loaded.size(), secondsSince(start));
+     
+     start = chrono::steady_clock::now();
+     size_t indexed = loaded.intervals().size();
+     report("schedule/file/index rebuild", indexed, secondsSince(start));
+     
+     bool same = loaded.size() == store.size() && file.size() == store.size() && indexed == store.intervals().size();
+     for (int i = 0; same && i < store.size(); i++) {
+         same = loaded.name(i) == store.name(i) && file.name(i) == store.name(i)
+             && loaded.start(i) == store.start(i) && loaded.end(i) == store.end(i)
+             && loaded.planned(i) == store.planned(i) && loaded.actual(i) == store.actual(i);
+         const RecurrenceRule* saved = store.recurrence(i);
+         const RecurrenceRule* restored = loaded.recurrence(i);
+         same = same && (saved && restored ? *saved == *restored : saved == restored);
+     }
+     same = same && loaded.recurrences().size() == store.recurrences().size()
+         && file.ruleCount() == static_cast<int>(store.recurrences().size());
+     // Запросы к перестроенному индексу совпадают с построенным вставками
+     for (int32_t t = 0; same && t < 86400; t += 3607) {
+         vector<EventHandle> expected, actual;
+         store.intervals().activeAt(t, expected);
+         loaded.intervals().activeAt(t, actual);
+         vector<int> a, b;
+         for (EventHandle h : expected) a.push_back(store.indexOf(h));
+         for (EventHandle h : actual) b.push_back(loaded.indexOf(h));
+         sort(a.begin(), a.end());
+         sort(b.begin(), b.end());
+         EventHandle nextA, nextB;
+         same = a == b && store.intervals().nextAfter(t, nextA) == loaded.intervals().nextAfter(t, nextB)
+             && store.start(store.indexOf(nextA)) == loaded.start(loaded.indexOf(nextB));
+     }
+     file.close();
+     remove(path);
+     if (!same) {
+         cerr << "schedule/file: загруженное расписание отличается от сохранённого" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Экспорт и потоковый импорт CSV/JSONL. Названия с запятыми, кавычками и
+ // переводами строк проверяют разбор записей на границах блоков.
+ static void benchScheduleIo(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     for (size_t i = 0; i < n; i++) {
+         string name = "Event " + to_string(i);
+         if (i % 5 == 1) name += ", room \"B\"";
+         if (i % 11 == 3) name += "\nsecond line";
+         store.add(name, samples[i].start, samples[i].end, samples[i].planned);
+     }
+     
+     for (ScheduleFormat format : {ScheduleFormat::Csv, ScheduleFormat::Jsonl}) {
+         const char* label = format == ScheduleFormat::Csv ? "csv" : "jsonl";
+         ostringstream out;
+         auto start = chrono::steady_clock::now();
+         exportSchedule(store, format, out);
+         double seconds = secondsSince(start);
+         string text = out.str();
+         report(string("schedule/io/export ") + label, n, seconds);
+         
+         // Испорченная запись в середине не должна мешать остальным. Она
+         // вставляется перед первым со второй половины мероприятием, название
+         // которого пишется как есть (без кавычек и экранирования): его запись
+         // начинается с названия, и её легко найти в тексте
+         int target = -1;
+         for (int k = 0; k < store.size() && target < 0; k++) {
+             int i = (store.size() / 2 + k) % store.size();
+             if (store.name(i).find_first_of(",\"\\\r\n") == string_view::npos) target = i;
+         }
+         if (target < 0) {
+             cerr << "schedule/io: нет мероприятия с простым названием" << endl;
+             exit(1);
+         }
+         string name(store.name(target));
+         string record = format == ScheduleFormat::Csv ? name + "," : "{\"name\":\"" + name + "\"";
+         size_t middle = text.compare(0, record.size(), record) == 0 ? 0 : text.find("\n" + record);
+         if (middle == string::npos) {
+             cerr << "schedule/io: запись \"" << name << "\" не найдена в " << label << endl;
+             exit(1);
+         }
+         if (middle > 0) middle++;
+         text.insert(middle, format == ScheduleFormat::Csv ? "broken,25:61:00,,\n" : "{\"name\":\"broken\"\n");
+         
+         istringstream in(text);
+         ScheduleStore loaded;
+         vector<ImportError> errors;
+         start = chrono::steady_clock::now();
+         ImportStats stats = importSchedule(in, format, loaded, &errors);
+         seconds = secondsSince(start);
+         report(string("schedule/io/import ") + label, n, seconds);
+         reportRate(string("schedule/io/import ") + label + " MB/s", text.size(), seconds);
+         
+         bool same = stats.imported == n && stats.rejected == 1 && errors.size() == 1 && loaded.size() == store.size();
+         for (int i = 0; same && i < store.size(); i++) {
+             same = loaded.name(i) == store.name(i) && loaded.start(i) == store.start(i)
+                 && loaded.end(i) == store.end(i) && loaded.planned(i) == store.planned(i)
+                 && loaded.actual(i) == store.actual(i);
+         }
+         if (!same) {
+             cerr << "schedule/io: импорт " << label << " расходится с экспортом" << endl;
+             exit(1);
+         }
+     }
+     
+     // Базовая линия: построчное чтение getline и разбор полей через istringstream
+     ostringstream plain;
+     plain << "name,startTime,endTime,plannedDuration,actualDuration\n";
+     for (size_t i = 0; i < n; i++) {
+         plain << "Event " << i << ',' << samples[i].start / 3600 << ':' << samples[i].start / 60 % 60 << ':'
+               << samples[i].start % 60 << ",0:00:00,1:00:00,1:00:00\n";
+     }
+     string plainText = plain.str();
+     istringstream in(plainText);
+     size_t rows = 0;
+     auto start = chrono::steady_clock::now();
+     string line, field;
+     getline(in, line);
+     while (getline(in, line)) {
+         istringstream fields(line);
+         getline(fields, field, ',');
+         getline(fields, field, ',');
+         istringstream time(field);
+         int h, m, s;
+         char colon;
+         if (time >> h >> colon >> m >> colon >> s) rows++;
+     }
+     report("schedule/io/import csv (getline)", rows, secondsSince(start));
+     
+     // Глубоко вложенное значение - ошибка строки, а не переполнение стека
+     string deep = "{\"x\":" + string(1000000, '[') + "}\n"
+                   "{\"name\":\"A\",\"startTime\":\"9:00:00\",\"endTime\":\"10:00:00\",\"plannedDuration\":\"1:00:00\"}\n";
+     istringstream deepIn(deep);
+     ScheduleStore deepLoaded;
+     ImportStats deepStats = importSchedule(deepIn, ScheduleFormat::Jsonl, deepLoaded);
+     if (deepStats.imported != 1 || deepStats.rejected != 1) {
+         cerr << "schedule/io: вложенный JSON сорвал импорт" << endl;
+         exit(1);
+     }
+     
+     // Незакрытая кавычка во второй строке: запись отклоняется по пределу
+     // длины, остальные строки файла (больше предела) принимаются
+     string unclosed = "name,startTime,endTime,plannedDuration,actualDuration\n\"Broken,9:00:00,10:00:00,1:00:00,1:00:00\n";
+     const size_t rowsAfter = 150000;
+     for (size_t i = 0; i < rowsAfter; i++) unclosed += "Event " + to_string(i) + ",9:00:00,10:00:00,1:00:00,1:00:00\n";
+     istringstream unclosedIn(unclosed);
+     ScheduleStore unclosedLoaded;
+     vector<ImportError> unclosedErrors;
+     ImportStats unclosedStats = importSchedule(unclosedIn, ScheduleFormat::Csv, unclosedLoaded, &unclosedErrors);
+     if (unclosedStats.imported != rowsAfter || unclosedStats.rejected != 1 || unclosedErrors[0].line != 2
+         || unclosedLoaded.name(0) != "Event 0") {
+         cerr << "schedule/io: незакрытая кавычка сорвала импорт CSV" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Частые добавления, переименования и удаления: прежние new/delete Event
+ // с std::string против хранилища со списками свободных блоков названий.
+ // Удаляются недавние мероприятия, поэтому сдвиг массивов мал и замер
+ // показывает стоимость выделения памяти.
+ static void benchChurn(size_t n) {
+     const size_t live = 10000;
+     mt19937 rng(12);
+     uniform_int_distribution<int> second(0, 86399);
+     uniform_int_distribution<int> nameLength(16, 48);
+     string pattern(64, 'x');
+     struct Op { unsigned kind; size_t recent; int start, end, length; };
+     vector<Op> ops(n);
+     for (Op& op : ops) op = Op{static_cast<unsigned>(rng() % 3), rng() % 64, second(rng), second(rng), nameLength(rng)};
+     
+     double seconds;
+     {
+         SilenceCout silence;
+         vector<LegacyEvent*> legacy;
+         for (size_t i = 0; i < live; i++) {
+             legacy.push_back(new LegacyEvent{pattern.substr(0, 20), Time(), Time(), Time(), Time()});
+         }
+         auto start = chrono::steady_clock::now();
+         for (const Op& op : ops) {
+             if (op.kind == 0) {
+                 LegacyEvent* e = new LegacyEvent;
+                 e->name.assign(pattern, 0, op.length);
+                 e->startTime.setTime(0, 0, op.start);
+                 e->endTime.setTime(0, 0, op.end);
+                 legacy.push_back(e);
+             } else if (op.kind == 1) {
+                 legacy[legacy.size() - 1 - op.recent]->name = pattern.substr(0, op.length);
+             } else if (legacy.size() > live / 2) {
+                 size_t index = legacy.size() - 1 - op.recent;
+                 delete legacy[index];
+                 legacy.erase(legacy.begin() + index);
+             }
+         }
+         seconds = secondsSince(start);
+         for (LegacyEvent* e : legacy) delete e;
+     }
+     report("schedule/churn/new-delete", n, seconds);
+     
+     // С индексом интервалов и без него (deferIndex): индекс - отдельная
+     // стоимость, которой у прежнего массива указателей не было
+     for (bool indexed : {true, false}) {
+         ScheduleStore store;
+         if (!indexed) store.deferIndex();
+         for (size_t i = 0; i < live; i++) store.add(string_view(pattern.data(), 20), 0, 0, 0);
+         auto start = chrono::steady_clock::now();
+         for (const Op& op : ops) {
+             if (op.kind == 0) {
+                 store.add(string_view(pattern.data(), op.length), op.start, op.end, 0);
+             } else if (op.kind == 1) {
+                 store.setName(store.size() - 1 - static_cast<int>(op.recent), string_view(pattern.data(), op.length));
+             } else if (static_cast<size_t>(store.size()) > live / 2) {
+                 store.remove(store.size() - 1 - static_cast<int>(op.recent));
+             }
+         }
+         report(indexed ? "schedule/churn/store" : "schedule/churn/store (deferIndex)", n, secondsSince(start));
+         
+         start = chrono::steady_clock::now();
+         store.clear();
+         if (!indexed) report("schedule/churn/store clear", 1, secondsSince(start));
+     }
+ }
+ 
+ // Удаление 10% и 90% расписания: по позициям, по дескрипторам и одним
+ // removeIf. Для сравнения - прежнее удаление со сдвигом массива
+ // указателей (только первые 1000 удалений: целиком оно квадратично).
+ static void benchDelete(size_t n) {
+     vector<EventSample> events = makeEvents(n);
+     auto fill = [&](ScheduleStore& store) {
+         store.deferIndex();
+         for (size_t i = 0; i < n; i++) {
+             // План хранит номер мероприятия, чтобы проверить оставшиеся
+             store.add("Мероприятие", events[i].start, events[i].end, static_cast<int32_t>(i));
+         }
+         store.intervals();
+     };
+     
+     double seconds;
+     size_t legacyOps = min<size_t>(1000, n / 2);
+     {
+         SilenceCout silence;
+         vector<LegacyEvent*> legacy;
+         legacy.reserve(n);
+         for (size_t i = 0; i < n; i++) legacy.push_back(new LegacyEvent{"Мероприятие", Time(), Time(), Time(), Time()});
+         mt19937 rng(7);
+         auto start = chrono::steady_clock::now();
+         for (size_t k = 0; k < legacyOps; k++) {
+             size_t index = rng() % legacy.size();
+             delete legacy[index];
+             legacy.erase(legacy.begin() + index);
+         }
+         seconds = secondsSince(start);
+         for (LegacyEvent* e : legacy) delete e;
+     }
+     report("schedule/delete/legacy shift (first 1000)", legacyOps, seconds);
+     
+     for (int percent : {10, 90}) {
+         size_t count = n * percent / 100;
+         vector<uint32_t> order(n);
+         for (size_t i = 0; i < n; i++) order[i] = static_cast<uint32_t>(i);
+         mt19937 rng(percent);
+         shuffle(order.begin(), order.end(), rng);
+         order.resize(count);
+         vector<uint8_t> doomed(n, 0);
+         for (uint32_t i : order) doomed[i] = 1;
+         string prefix = "schedule/delete/" + to_string(percent) + "% ";
+         
+         // Оставшиеся мероприятия - ровно не отмеченные, в прежнем порядке
+         auto check = [&](const ScheduleStore& store, const char* what) {
+             bool same = static_cast<size_t>(store.size()) == n - count && store.intervals().size() == n - count;
+             size_t next = 0;
+             for (int i = 0; same && i < store.size(); i++) {
+                 while (doomed[next]) next++;
+                 same = store.planned(i) == static_cast<int32_t>(next) && store.indexOf(store.handleAt(i)) == i;
+                 next++;
+             }
+             if (!same) {
+                 cerr << "schedule/delete: " << what << " оставил не те мероприятия" << endl;
+                 exit(1);
+             }
+         };
+         
+         {
+             ScheduleStore store;
+             fill(store);
+             vector<EventHandle> handles;
+             for (uint32_t i : order) handles.push_back(store.handleAt(static_cast<int>(i)));
+             auto start = chrono::steady_clock::now();
+             for (EventHandle h : handles) store.remove(h);
+             report(prefix + "remove(handle)", count, secondsSince(start));
+             check(store, "remove(handle)");
+         }
+         {
+             // Номер каждого удаляемого мероприятия находится через indexOf
+             // перед удалением: предыдущие удаления его сдвигают
+             ScheduleStore store;
+             fill(store);
+             vector<EventHandle> handles;
+             for (uint32_t i : order) handles.push_back(store.handleAt(static_cast<int>(i)));
+             auto start = chrono::steady_clock::now();
+             for (EventHandle h : handles) store.remove(store.indexOf(h));
+             report(prefix + "remove(index)", count, secondsSince(start));
+             check(store, "remove(index)");
+         }
+         {
+             ScheduleStore store;
+             fill(store);
+             auto start = chrono::steady_clock::now();
+             size_t removed = store.removeIf([&](int i) { return doomed[store.planned(i)] != 0; });
+             report(prefix + "removeIf", removed, secondsSince(start));
+             check(store, "removeIf");
+         }
+     }
+ }
+ 
+ // Статистика "план/факт": analyzeSchedule в 1..N потоках против прямого
+ // расчёта с сортировкой всех отклонений. Результаты должны совпадать.
+ static void benchStats(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     store.deferIndex();
+     for (size_t i = 0; i < n; i++) {
+         // Каждое сотое мероприятие - с планом больше суток (отклонение вне гистограммы)
+         int32_t planned = i % 100 == 0 ? samples[i].planned + 2 * 86400 : samples[i].planned;
+         store.add("Мероприятие", samples[i].start, samples[i].end, planned);
+     }
+     ScheduleStatsOptions options;
+     options.percentiles = {0, 50, 90, 99, 99.9, 100};
+     
+     auto start = chrono::steady_clock::now();
+     vector<int32_t> deviations(n);
+     vector<ScheduleOverrun> overruns;
+     long long total = 0;
+     for (size_t i = 0; i < n; i++) {
+         deviations[i] = store.actual(static_cast<int>(i)) - store.planned(static_cast<int>(i));
+         total += deviations[i];
+         if (deviations[i] > 0) overruns.push_back(ScheduleOverrun{static_cast<int>(i), deviations[i]});
+     }
+     sort(deviations.begin(), deviations.end());
+     sort(overruns.begin(), overruns.end(), [](const ScheduleOverrun& a, const ScheduleOverrun& b) {
+         return a.overrunSeconds != b.overrunSeconds ? a.overrunSeconds > b.overrunSeconds : a.position < b.position;
+     });
+     vector<int32_t> expected;
+     for (double p : options.percentiles) {
+         size_t rank = max<size_t>(1, static_cast<size_t>(ceil(p / 100.0 * static_cast<double>(n))));
+         expected.push_back(deviations[rank - 1]);
+     }
+     string name = "schedule/stats/sort n=" + to_string(n);
+     report(name, n, secondsSince(start));
+     
+     for (unsigned threads : threadCounts()) {
+         options.threads = threads;
+         options.parallelThreshold = 0;
+         start = chrono::steady_clock::now();
+         ScheduleStats stats = analyzeSchedule(store, options);
+         name = "schedule/stats/analyze threads=" + to_string(threads);
+         report(name, n, secondsSince(start));
+         
+         size_t inHistogram = stats.histogram.below + stats.histogram.above;
+         for (size_t c : stats.histogram.counts) inHistogram += c;
+         bool same = stats.events == n && stats.totalDeviationSeconds == total && stats.percentiles == expected
+             && stats.overrunCount == overruns.size() && inHistogram == n
+             && stats.minDeviationSeconds == deviations.front() && stats.maxDeviationSeconds == deviations.back()
+             && stats.worst.size() == min(options.topCount, overruns.size());
+         for (size_t k = 0; same && k < stats.worst.size(); k++) {
+             same = stats.worst[k].position == overruns[k].position
+                 && stats.worst[k].overrunSeconds == overruns[k].overrunSeconds;
+         }
+         if (!same) {
+             cerr << "schedule/stats: результат расходится с прямым расчётом" << endl;
+             exit(1);
+         }
+     }
+     
+     // Сумма опозданий за границами int32_t выводится целиком, а корзина
+     // около INT32_MAX не переполняет число корзин
+     ScheduleStore late;
+     for (int i = 0; i < 30000; i++) late.add("Опоздание", 0, 23 * 3600 + 59 * 60, 0);
+     ScheduleStatsOptions wide;
+     wide.bucketSeconds = INT32_MAX;
+     ScheduleStats lateStats = analyzeSchedule(late, wide);
+     ostringstream lateText;
+     writeScheduleStats(late, lateStats, wide, lateText);
+     size_t inWide = lateStats.histogram.below + lateStats.histogram.above;
+     for (size_t c : lateStats.histogram.counts) inWide += c;
+     if (lateText.str().find("Суммарное опоздание: +719500:00:00,") == string::npos
+         || lateStats.histogram.counts.size() != 2 || inWide != 30000) {
+         cerr << "schedule/stats: сумма опозданий или широкая корзина посчитаны неверно" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Итоги расписания: чтение поддерживаемых итогов против полного прохода.
+ // После случайных правок итоги сверяются с пересчётом.
+ static void benchTotals(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     store.deferIndex();
+     for (size_t i = 0; i < n; i++) store.add("Мероприятие", samples[i].start, samples[i].end, samples[i].planned);
+     
+     mt19937 rng(15);
+     uniform_int_distribution<int> second(0, 86399);
+     size_t edits = min<size_t>(n, 200000);
+     auto start = chrono::steady_clock::now();
+     for (size_t k = 0; k < edits; k++) {
+         int index = static_cast<int>(rng() % static_cast<unsigned>(store.size()));
+         switch (k % 5) {
+             case 0: store.setStart(index, second(rng)); break;
+             case 1: store.setEnd(index, second(rng)); break;
+             case 2: store.setPlanned(index, second(rng)); break;
+             case 3: store.setActual(index, actualDurationSeconds(store.start(index), store.end(index))); break;
+             default: store.remove(index); store.add("Новое", second(rng), second(rng), second(rng)); break;
+         }
+     }
+     report("schedule/totals/edits", edits, secondsSince(start));
+     store.removeIf([&](int i) { return store.start(i) < 3600; });
+     
+     size_t reps = max<size_t>(1, 10000000 / n);
+     long long sink = 0;
+     start = chrono::steady_clock::now();
+     for (size_t r = 0; r < reps; r++) {
+         const ScheduleTotals& t = store.totals();
+         sink += t.plannedSeconds() + t.actualSeconds() + static_cast<long long>(t.overrunCount())
+               + t.earliestStart() + t.latestEnd();
+     }
+     report("schedule/totals/query totals()", reps, secondsSince(start));
+     
+     long long planned = 0, actual = 0;
+     size_t overruns = 0;
+     int32_t earliest = 0, latest = 0;
+     start = chrono::steady_clock::now();
+     for (size_t r = 0; r < reps; r++) {
+         const int32_t* s = store.startColumn();
+         const int32_t* p = store.plannedColumn();
+         const int32_t* a = store.actualColumn();
+         planned = actual = 0;
+         overruns = 0;
+         earliest = INT32_MAX;
+         latest = INT32_MIN;
+         for (int i = 0; i < store.size(); i++) {
+             planned += p[i];
+             actual += a[i];
+             overruns += a[i] > p[i];
+             earliest = min(earliest, s[i]);
+             latest = max(latest, saturatingAdd(s[i], a[i]));
+         }
+         sink += planned;
+     }
+     string name = "schedule/totals/query scan n=" + to_string(store.size());
+     report(name, reps, secondsSince(start));
+     benchSink = benchSink + sink;
+     
+     const ScheduleTotals& t = store.totals();
+     if (t.count() != static_cast<size_t>(store.size()) || t.plannedSeconds() != planned || t.actualSeconds() != actual
+         || t.overrunCount() != overruns || t.earliestStart() != earliest || t.latestEnd() != latest) {
+         cerr << "schedule/totals: итоги расходятся с пересчётом" << endl;
+         exit(1);
+     }
+     
+     // Суммы больше INT32_MAX: итоги и их вывод не должны обрезаться до int
+     ScheduleStore large;
+     for (int i = 0; i < 3; i++) {
+         large.add("Долгое", 0, 3600, 2000000000);
+         large.setActual(i, 1500000000);
+     }
+     ostringstream text;
+     writeTotals(large, text);
+     if (large.totals().plannedSeconds() != 6000000000LL || large.totals().actualSeconds() != 4500000000LL
+         || text.str().find("Сумма плана: 1666666:40:00 | Сумма факта: 1250000:00:00") == string::npos) {
+         cerr << "schedule/totals: неверные итоги больше INT32_MAX:\n" << text.str();
+         exit(1);
+     }
+     
+     // Конец после полуночи позже дневного конца
+     ScheduleStore night;
+     night.add("Ночь", 23 * 3600, 4 * 3600, 5 * 3600);
+     night.add("День", 10 * 3600, 11 * 3600, 3600);
+     if (night.totals().latestEnd() != 28 * 3600) {
+         cerr << "schedule/totals: самый поздний конец без учёта перехода через полночь" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Пути расписания из меню: добавление, полный список (writeSchedule),
+ // пересчёт фактической длительности (updateActualDuration в main.cpp)
+ // и удаление по номеру
+ static void benchSchedulePaths(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     auto start = chrono::steady_clock::now();
+     for (size_t i = 0; i < n; i++) store.add("Мероприятие", samples[i].start, samples[i].end, samples[i].planned);
+     report("schedule/paths/add", n, secondsSince(start));
+     
+     NullBuffer null;
+     ostream out(&null);
+     start = chrono::steady_clock::now();
+     writeSchedule(store, out);
+     report("schedule/paths/list", n, secondsSince(start));
+     
+     start = chrono::steady_clock::now();
+     for (int i = 0; i < store.size(); i++) {
+         store.setActual(i, actualDurationSeconds(store.start(i), store.end(i)));
+     }
+     report("schedule/paths/updateActualDuration", n, secondsSince(start));
+     
+     // Удаляется половина, каждое - с произвольной позиции
+     mt19937 rng(20);
+     size_t removals = n / 2;
+     start = chrono::steady_clock::now();
+     for (size_t k = 0; k < removals; k++) {
+         store.remove(static_cast<int>(rng() % static_cast<unsigned>(store.size())));
+     }
+     report("schedule/paths/delete", max<size_t>(removals, 1), secondsSince(start));
+     
+     if (static_cast<size_t>(store.size()) != n - removals || store.totals().count() != n - removals) {
+         cerr << "schedule/paths: размер после удаления не совпадает" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Правка мероприятий в установившемся режиме: названия из набора разной
+ // длины читаются в один буфер (как nameInput в меню) и пишутся на место
+ // прежних, время меняется в столбцах. Цикл не должен выделять память.
+ static void benchEdit(size_t n) {
+     static const char* const names[] = {
+         "Планёрка", "Разбор полётов", "Обед", "Созвон с подрядчиком по смете на третий квартал",
+         "Ревью", "Демонстрация заказчику", "Перерыв", "Обучение новых сотрудников работе с расписанием",
+     };
+     const size_t nameCount = sizeof(names) / sizeof(names[0]);
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     store.reserve(n, n * 16);
+     for (size_t i = 0; i < n; i++) store.add(names[i % nameCount], samples[i].start, samples[i].end, samples[i].planned);
+     
+     string nameInput;
+     auto editPass = [&](size_t pass) {
+         for (size_t i = 0; i < n; i++) {
+             int index = static_cast<int>(i);
+             nameInput.assign(names[(i + pass) % nameCount]);
+             store.setName(index, nameInput);
+             store.setStart(index, samples[(i + pass) % n].start);
+             store.setEnd(index, samples[(i + pass) % n].end);
+             store.setPlanned(index, samples[(i + pass) % n].planned);
+             store.setActual(index, actualDurationSeconds(store.start(index), store.end(index)));
+         }
+     };
+     // Первые проходы наполняют списки свободных блоков всех размеров
+     for (size_t pass = 1; pass <= nameCount; pass++) editPass(pass);
+     
+     const size_t passes = 3;
+     size_t allocationsBefore = threadAllocations();
+     auto start = chrono::steady_clock::now();
+     for (size_t pass = 1; pass <= passes; pass++) editPass(pass);
+     double seconds = secondsSince(start);
+     size_t allocations = threadAllocations() - allocationsBefore;
+     report("schedule/edit (name + 4 columns)", n * passes, seconds);
+     
+     bool same = true;
+     for (size_t i = 0; i < n && same; i++) {
+         int index = static_cast<int>(i);
+         same = store.name(index) == names[(i + passes) % nameCount] && store.start(index) == samples[(i + passes) % n].start;
+     }
+     cout << "schedule/edit: выделений памяти за " << n * passes << " правок: " << allocations << endl;
+     
+     // Рост vector<Time> переносит элементы конструктором перемещения
+     TimeStats before = Time::getOperationStats();
+     {
+         SilenceCout silence;
+         vector<Time> times;
+         for (int i = 0; i < 1000; i++) times.emplace_back(0, 0, i);
+     }
+     TimeStats after = Time::getOperationStats();
+     size_t copies = after.copies - before.copies;
+     size_t moves = after.moves - before.moves;
+     cout << "schedule/edit: рост vector<Time> - копий " << copies << ", перемещений " << moves << endl;
+     
+     // На паре десятков строк буфер названий так мал, что порог уплотнения
+     // (половина буфера) задевают и уравновешенные правки
+     bool steady = n >= 4 * nameCount;
+     if (!same || (steady && allocations != 0) || copies != 0 || moves == 0) {
+         cerr << "schedule/edit: правки выделяют память, дают неверный результат или Time копируется" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Эталон для schedule/recurrence: серия разворачивается шаг за шагом от
+ // первого повторения, недели - перебором дней
+ static void naiveOccurrences(const RecurrenceRule& rule, int32_t startSeconds, int64_t from, int64_t to,
+                              vector<int64_t>& out) {
+     const int64_t day = DateTime::secondsPerDay;
+     int64_t limit = min(to, int64_t(rule.untilDay) * day);
+     if (rule.kind == RecurrenceKind::Weekly) {
+         int64_t weekStart = rule.firstDay - int64_t(weekdayFromDays(rule.firstDay) - 1);
+         for (int64_t d = rule.firstDay; d * day + startSeconds < limit; d++) {
+             uint32_t weekday = weekdayFromDays(static_cast<int32_t>(d));
+             if ((d - weekStart) / 7 % rule.interval != 0 || ((rule.weekdays >> (weekday - 1)) & 1) == 0) continue;
+             if (d * day + startSeconds >= from) out.push_back(d * day + startSeconds);
+         }
+         return;
+     }
+     int64_t period = int64_t(rule.interval) * (rule.kind == RecurrenceKind::EveryMinutes ? 60 : day);
+     for (int64_t t = rule.firstDay * day + startSeconds; t < limit; t += period) {
+         if (t >= from) out.push_back(t);
+     }
+ }
+ 
+ // Повторяющиеся мероприятия: память на серию и запрос повторений за сутки
+ // против наивного развёртывания
+ static void benchRecurrence(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     const int32_t today = daysFromCivil(2026, 10, 19);
+     mt19937 rng(24);
+     vector<RecurrenceRule> rules(n);
+     for (size_t i = 0; i < n; i++) {
+         // Серии начались в прошлом году, у каждой четвёртой есть конец
+         int32_t firstDay = today - static_cast<int32_t>(rng() % 365);
+         int32_t untilDay = i % 4 == 3 ? today + static_cast<int32_t>(rng() % 30) : RecurrenceRule::noEnd;
+         switch (i % 3) {
+             case 0: rules[i] = RecurrenceRule::everyMinutes(60 * (1 + rng() % 12), firstDay, untilDay); break;
+             case 1: rules[i] = RecurrenceRule::daily(1 + rng() % 7, firstDay, untilDay); break;
+             default: rules[i] = RecurrenceRule::weekly(1 + rng() % 3, static_cast<uint8_t>(1 + rng() % 127), firstDay, untilDay); break;
+         }
+     }
+     ScheduleStore store;
+     store.reserve(n, n * 8);
+     for (size_t i = 0; i < n; i++) store.add("Серия", samples[i].start, samples[i].end, samples[i].planned);
+     
+     auto start = chrono::steady_clock::now();
+     for (size_t i = 0; i < n; i++) store.setRecurrence(static_cast<int>(i), rules[i]);
+     report("schedule/recurrence/set", n, secondsSince(start));
+     
+     // Память серии не зависит от числа её повторений
+     double bytesPerSeries = static_cast<double>(store.recurrences().memoryBytes()) / n;
+     cout << "schedule/recurrence: память на серию " << fixed << setprecision(1) << bytesPerSeries << " байт" << endl;
+     
+     // Окно - завтрашние сутки
+     DateTime from(today + 1, 0);
+     DateTime to(today + 2, 0);
+     vector<Occurrence> found;
+     size_t reps = max<size_t>(1, 1000000 / n);
+     start = chrono::steady_clock::now();
+     for (size_t r = 0; r < reps; r++) {
+         found.clear();
+         occurrencesIn(store, from, to, found);
+     }
+     report("schedule/recurrence/window (1 day)", n * reps, secondsSince(start));
+     cout << "schedule/recurrence: повторений за сутки " << found.size() << endl;
+     
+     // Выборка серий: ленивый перебор и запрос по окну против эталона
+     const size_t sampleCount = min<size_t>(n, 300);
+     const size_t step = n / sampleCount;
+     vector<int> sampleOfSlot(n, -1);
+     for (size_t k = 0; k < sampleCount; k++) sampleOfSlot[store.handleAt(static_cast<int>(k * step)).slot] = static_cast<int>(k);
+     vector<vector<int64_t>> windowed(sampleCount);
+     for (const Occurrence& o : found) {
+         if (o.event.slot < n && sampleOfSlot[o.event.slot] >= 0) windowed[sampleOfSlot[o.event.slot]].push_back(o.start.unixSeconds());
+     }
+     
+     bool same = true;
+     vector<int64_t> expected, lazy;
+     double naiveSeconds = 0, lazySeconds = 0;
+     for (size_t k = 0; k < sampleCount && same; k++) {
+         int index = static_cast<int>(k * step);
+         const RecurrenceRule& rule = rules[index];
+         int32_t begin = store.start(index);
+         int32_t duration = actualDurationSeconds(begin, store.end(index));
+         // Повторения, пересекающиеся с окном, начинаются не раньше from - d + 1
+         int64_t earliest = from.unixSeconds() - duration + (duration > 0);
+         
+         expected.clear();
+         start = chrono::steady_clock::now();
+         naiveOccurrences(rule, begin, earliest, to.unixSeconds(), expected);
+         naiveSeconds += secondsSince(start);
+         
+         lazy.clear();
+         start = chrono::steady_clock::now();
+         for (DateTime t : occurrences(rule, begin, DateTime::fromUnixSeconds(earliest), to)) lazy.push_back(t.unixSeconds());
+         lazySeconds += secondsSince(start);
+         
+         // Длинное окно: год вперёд от первого повторения
+         vector<int64_t> yearNaive, yearLazy;
+         DateTime yearFrom(rule.firstDay, 0);
+         DateTime yearTo(rule.firstDay + 366, 0);
+         naiveOccurrences(rule, begin, yearFrom.unixSeconds(), yearTo.unixSeconds(), yearNaive);
+         for (DateTime t : occurrences(rule, begin, yearFrom, yearTo)) yearLazy.push_back(t.unixSeconds());
+         
+         same = lazy == expected && windowed[k] == expected && yearLazy == yearNaive
+             && store.recurrence(index) != nullptr && *store.recurrence(index) == rule;
+     }
+     report("schedule/recurrence/lazy (sample)", sampleCount, lazySeconds);
+     report("schedule/recurrence/naive (sample)", sampleCount, naiveSeconds);
+     
+     // Правила уходят вместе с мероприятиями
+     store.removeIf([](int i) { return i % 2 == 0; });
+     for (int i = 0; i < store.size() && same; i++) {
+         const RecurrenceRule* rule = store.recurrence(i);
+         same = rule != nullptr && *rule == rules[2 * i + 1];
+     }
+     bool removed = same && store.recurrences().size() == n / 2;
+     if (store.size() > 0) {
+         store.clearRecurrence(0);
+         removed = removed && store.recurrence(0) == nullptr && store.recurrences().size() + 1 == n / 2;
+     }
+     store.clear();
+     removed = removed && store.recurrences().empty();
+     
+     if (!same || !removed || bytesPerSeries > 64) {
+         cerr << "schedule/recurrence: повторения расходятся с эталоном, правила не удаляются или память не пропорциональна сериям" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Одинаковые мероприятия в одинаковом порядке
+ static bool sameSchedule(const ScheduleStore& a, const ScheduleStore& b) {
+     if (a.size() != b.size()) return false;
+     size_t count = static_cast<size_t>(a.size());
+     if (!equal(a.startColumn(), a.startColumn() + count, b.startColumn())
+         || !equal(a.endColumn(), a.endColumn() + count, b.endColumn())
+         || !equal(a.plannedColumn(), a.plannedColumn() + count, b.plannedColumn())
+         || !equal(a.actualColumn(), a.actualColumn() + count, b.actualColumn())) {
+         return false;
+     }
+     for (int i = 0; i < a.size(); i++) {
+         if (a.name(i) != b.name(i)) return false;
+     }
+     return a.totals().actualSeconds() == b.totals().actualSeconds();
+ }
+ 
+ // Журнал изменений: цена записи на изменение, снимок против копии,
+ // отмена и повтор всей истории
+ static void benchJournal(size_t n) {
+     vector<EventSample> samples = makeEvents(n);
+     ScheduleStore store;
+     store.reserve(n, n * 8);
+     for (size_t i = 0; i < n; i++) store.add("Событие", samples[i].start, samples[i].end, samples[i].planned);
+     ScheduleJournal journal(store);
+     
+     // Изменение без журнала и через журнал: те же правки начала
+     auto start = chrono::steady_clock::now();
+     for (size_t i = 0; i < n; i++) store.setStart(static_cast<int>(i), samples[(i + 1) % n].start);
+     report("schedule/journal/setStart (store)", n, secondsSince(start));
+     ScheduleStore initial = store;
+     
+     start = chrono::steady_clock::now();
+     for (size_t i = 0; i < n; i++) journal.setStart(static_cast<int>(i), samples[(i + 2) % n].start);
+     report("schedule/journal/setStart (journal)", n, secondsSince(start));
+     cout << "schedule/journal: память на изменение " << fixed << setprecision(1)
+          << static_cast<double>(journal.memoryBytes()) / n << " байт" << endl;
+     
+     // Правка всех полей одним шагом, как в меню
+     size_t edits = min<size_t>(n, 100000);
+     start = chrono::steady_clock::now();
+     for (size_t i = 0; i < edits; i++) {
+         int index = static_cast<int>(i * (n / edits));
+         journal.beginStep();
+         journal.setName(index, i % 2 ? "Планёрка" : "Разбор полётов");
+         journal.setEnd(index, samples[i].start);
+         journal.setPlanned(index, samples[i].planned);
+         journal.setActual(index, actualDurationSeconds(store.start(index), store.end(index)));
+         journal.endStep();
+     }
+     report("schedule/journal/edit step (5 fields)", edits, secondsSince(start));
+     ScheduleSnapshot edited = journal.snapshot();
+     
+     // Снимок - место в истории; копия хранилища - O(n)
+     ScheduleSnapshot latest;
+     const size_t snapshots = 10000000;
+     start = chrono::steady_clock::now();
+     for (size_t i = 0; i < snapshots; i++) {
+         latest = journal.snapshot();
+         benchSink = benchSink + static_cast<long long>(latest.position);
+     }
+     report("schedule/journal/snapshot", snapshots, secondsSince(start));
+     start = chrono::steady_clock::now();
+     ScheduleStore final = store;
+     report("schedule/journal/copy (all events)", 1, secondsSince(start));
+     
+     // Удаления со случайных позиций и их отмена (вставка на место)
+     mt19937 rng(25);
+     size_t removals = min<size_t>(n / 2, 1000);
+     start = chrono::steady_clock::now();
+     for (size_t i = 0; i < removals; i++) journal.remove(static_cast<int>(rng() % static_cast<size_t>(store.size())));
+     report("schedule/journal/remove", removals, secondsSince(start));
+     start = chrono::steady_clock::now();
+     for (size_t i = 0; i < removals; i++) journal.undo();
+     report("schedule/journal/undo remove", removals, secondsSince(start));
+     bool same = sameSchedule(store, final);
+     
+     // Очистка переносит хранилище в журнал, а не копирует его
+     start = chrono::steady_clock::now();
+     journal.clear();
+     bool cleared = store.empty();
+     journal.undo();
+     report("schedule/journal/clear + undo", 1, secondsSince(start));
+     same = same && cleared && sameSchedule(store, final);
+     
+     // Вся история назад и вперёд
+     size_t steps = 0;
+     start = chrono::steady_clock::now();
+     while (journal.undo()) steps++;
+     report("schedule/journal/undo", steps, secondsSince(start));
+     same = same && sameSchedule(store, initial);
+     start = chrono::steady_clock::now();
+     while (journal.redo()) {}
+     report("schedule/journal/redo", steps, secondsSince(start));
+     // Последний шаг истории - очистка
+     same = same && store.empty() && !journal.canRedo() && journal.undo() && sameSchedule(store, final);
+     
+     // Возврат к снимку и отброшенная ветка истории
+     same = same && journal.restore(edited) && sameSchedule(store, final);
+     journal.undo();
+     journal.setPlanned(0, 1);
+     same = same && !journal.restore(latest) && journal.restore(journal.snapshot());
+     journal.clearHistory();
+     same = same && !journal.canUndo() && !journal.restore(edited);
+     
+     if (!same) {
+         cerr << "schedule/journal: отмена, повтор или снимок не восстанавливают расписание" << endl;
+         exit(1);
+     }
+ }
+ 
+ // Базовая линия для schedule/concurrent: одно хранилище под shared_mutex.
+ // Писатель после изменения выполняет отложенную работу, иначе чтение
+ // столбцов под общей блокировкой меняло бы хранилище из нескольких потоков.
+ struct LockedSchedule {
+     mutable shared_mutex lock;
+     ScheduleStore store;
+     
+     template <typename Reader>
+     auto read(Reader reader) const -> decltype(reader(store)) {
+         shared_lock<shared_mutex> guard(lock);
+         return reader(store);
+     }
+     template <typename Writer>
+     void write(Writer writer) {
+         unique_lock<shared_mutex> guard(lock);
+         writer(store);
+         store.prepareForReaders();
+     }
+ };
+ 
+ // Смесь из 90% чтений и 10% записей (правки начала и названия, пары
+ // добавление/удаление) при 1..64 потоках. n - общее число операций,
+ // расписание - 100000 мероприятий.
+ static void benchConcurrent(size_t n) {
+     const size_t events = 100000;
+     vector<EventSample> samples = makeEvents(events);
+     ScheduleStore initial;
+     for (size_t i = 0; i < events; i++) initial.add("Мероприятие", samples[i].start, samples[i].end, samples[i].planned);
+     initial.prepareForReaders();
+     vector<EventHandle> handles(events);
+     for (size_t i = 0; i < events; i++) handles[i] = initial.handleAt(static_cast<int>(i));
+     
+     for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+         size_t perThread = max<size_t>(1, n / threads);
+         
+         ConcurrentSchedule schedule;
+         schedule.assign(initial);
+         size_t batchesBefore = schedule.batchCount();
+         atomic<size_t> writes{0};
+         atomic<long long> sink{0};
+         double seconds = runThreads(threads, perThread, [&](unsigned t, size_t count) {
+             mt19937 rng(1000 + t);
+             long long acc = 0;
+             size_t written = 0;
+             for (size_t i = 0; i < count; i++) {
+                 unsigned kind = rng() % 100;
+                 EventHandle handle = handles[rng() % events];
+                 if (kind < 90) {
+                     acc += schedule.read([&](const ScheduleStore& s) {
+                         int index = static_cast<int>(rng() % static_cast<unsigned>(s.size()));
+                         return s.start(index) + s.end(index) + static_cast<long long>(s.totals().count());
+                     });
+                     continue;
+                 }
+                 written++;
+                 if (kind < 97) {
+                     schedule.setStart(handle, static_cast<int32_t>(rng() % 86400));
+                 } else if (kind < 99) {
+                     schedule.setName(handle, kind == 97 ? "Планёрка" : "Разбор полётов");
+                 } else {
+                     schedule.remove(schedule.add("Временное", 3600, 7200, 3600));
+                 }
+             }
+             writes += written;
+             sink += acc;
+         });
+         string name = "schedule/concurrent/left-right x" + to_string(threads);
+         report(name, threads * perThread, seconds);
+         size_t batches = schedule.batchCount() - batchesBefore;
+         
+         LockedSchedule locked;
+         locked.store = initial;
+         double lockedSeconds = runThreads(threads, perThread, [&](unsigned t, size_t count) {
+             mt19937 rng(1000 + t);
+             long long acc = 0;
+             for (size_t i = 0; i < count; i++) {
+                 unsigned kind = rng() % 100;
+                 EventHandle handle = handles[rng() % events];
+                 if (kind < 90) {
+                     acc += locked.read([&](const ScheduleStore& s) {
+                         int index = static_cast<int>(rng() % static_cast<unsigned>(s.size()));
+                         return s.start(index) + s.end(index) + static_cast<long long>(s.totals().count());
+                     });
+                     continue;
+                 }
+                 locked.write([&](ScheduleStore& s) {
+                     int index = s.indexOf(handle);
+                     if (kind < 97) {
+                         s.setStart(index, static_cast<int32_t>(rng() % 86400));
+                         s.setActual(index, actualDurationSeconds(s.start(index), s.end(index)));
+                     } else if (kind < 99) {
+                         s.setName(index, kind == 97 ? "Планёрка" : "Разбор полётов");
+                     } else {
+                         s.remove(s.indexOf(s.add("Временное", 3600, 7200, 3600)));
+                     }
+                 });
+             }
+             sink += acc;
+         });
+         name = "schedule/concurrent/shared_mutex x" + to_string(threads);
+         report(name, threads * perThread, lockedSeconds);
+         benchSink = benchSink + sink.load();
+         cout << "schedule/concurrent: x" << threads << " записей " << writes.load() << ", пакетов " << batches << endl;
+         
+         // Итоги и столбцы копии для чтения должны сходиться, а размер - не меняться
+         bool same = schedule.read([&](const ScheduleStore& s) {
+             const int32_t* start = s.startColumn();
+             const int32_t* end = s.endColumn();
+             const int32_t* actual = s.actualColumn();
+             long long total = 0;
+             bool ok = s.size() == static_cast<int>(events) && s.totals().count() == events;
+             for (int i = 0; ok && i < s.size(); i++) {
+                 ok = actual[i] == actualDurationSeconds(start[i], end[i]);
+                 total += actual[i];
+             }
+             return ok && total == s.totals().actualSeconds();
+         });
+         if (!same) {
+             cerr << "schedule/concurrent: копия для чтения не согласована" << endl;
+             exit(1);
+         }
+     }
+ }
+ 
+ struct Benchmark {
+     const char* name;          ///< Имя замера (для фильтра)
+     void (*run)(size_t n);     ///< Функция замера
+     size_t defaultSize;        ///< Число операций по умолчанию
+ };
+ 
+ static const Benchmark benchmarks[] = {
+     {"time/arithmetic/Time", benchTimeArithmetic, 1000000},
+     {"time/arithmetic/TimeValue", benchTimeValueArithmetic, 100000000},
+     {"time/span", benchTimeSpan, 100000},
+     {"time/compare", benchTimeCompare, 10000000},
+     {"time/operators", benchTimeOperators, 1000000},
+     {"time/counter/sharded", benchCounterStress, 10000000},
+     {"time/counter/shared-atomic", benchCounterSharedAtomic, 10000000},
+     {"time/batch", benchTimeBatch, 100000},
+     {"time/format", benchFormat, 10000000},
+     {"time/parse", benchParse, 10000000},
+     {"time/datetime", benchDateTime, 1000000},
+     {"schedule/scan", benchScheduleScan, 1000000},
+     {"schedule/query", benchScheduleQuery, 1000000},
+     {"schedule/conflicts", benchConflicts, 1000000},
+     {"schedule/commands", benchCommands, 1000000},
+     {"schedule/file", benchScheduleFile, 1000000},
+     {"schedule/io", benchScheduleIo, 1000000},
+     {"schedule/churn", benchChurn, 1000000},
+     {"schedule/delete", benchDelete, 1000000},
+     {"schedule/stats", benchStats, 1000000},
+     {"schedule/totals", benchTotals, 1000000},
+     {"schedule/paths", benchSchedulePaths, 1000000},
+     {"schedule/edit", benchEdit, 1000000},
+     {"schedule/recurrence", benchRecurrence, 1000000},
+     {"schedule/journal", benchJournal, 1000000},
+     {"schedule/concurrent", benchConcurrent, 200000},
+ };
+ 
+ static void usage() {
+     cerr << "Запуск: bench [--json файл] [--sizes 10,1000,... | --sweep] [фильтр] [размер]" << endl;
+ }
+ 
+ int main(int argc, char* argv[]) {
+     const char* filter = "";
+     vector<size_t> sizes;
+     int positional = 0;
+     for (int i = 1; i < argc; i++) {
+         string arg = argv[i];
+         if (arg == "--json" && i + 1 < argc) {
+             jsonOut.open(argv[++i], ios::app);
+             if (!jsonOut) {
+                 cerr << "Не удалось открыть " << argv[i] << endl;
+                 return 1;
+             }
+         } else if (arg == "--sizes" && i + 1 < argc) {
+             for (const char* p = argv[++i]; *p != '\0';) {
+                 char* next = nullptr;
+                 size_t size = strtoull(p, &next, 10);
+                 if (next == p || size == 0) {
+                     usage();
+                     return 1;
+                 }
+                 sizes.push_back(size);
+                 p = *next == ',' ? next + 1 : next;
+             }
+         } else if (arg == "--sweep") {
+             for (size_t size = 10; size <= 10000000; size *= 10) sizes.push_back(size);
+         } else if (arg == "--help" || arg.compare(0, 2, "--") == 0) {
+             usage();
+             return arg == "--help" ? 0 : 1;
+         } else if (positional == 0) {
+             filter = argv[i];
+             positional++;
+         } else {
+             sizes.assign(1, strtoull(argv[i], nullptr, 10));
+             positional++;
+         }
+     }
+     if (sizes.empty()) sizes.push_back(0);
+     
+     for (size_t size : sizes) {
+         for (const Benchmark& b : benchmarks) {
+             if (strstr(b.name, filter) == nullptr) continue;
+             currentBenchmark = b.name;
+             currentSize = size > 0 ? size : b.defaultSize;
+             if (sizes.size() > 1) cout << "# " << b.name << " n=" << currentSize << endl;
+             b.run(currentSize);
+             if (jsonOut.is_open()) jsonOut.flush();
+         }
+     }
+     return 0;
+ }
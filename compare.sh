@@ -0,0 +1,77 @@
+#!/bin/sh
+# Сравнение конфигураций сборки на замерах с операторами Time.
+#
+#   ./compare.sh [каталог] [размер]
+#
+# Собирает Release, Release + LTO и Release + LTO + PGO (профиль снимается
+# прогоном замеров), запускает на каждой одни и те же замеры и печатает
+# таблицу нс/операцию. Сырые результаты (JSON Lines) остаются в
+# каталог/<конфигурация>.jsonl.
+
+set -e
+
+source_dir=$(cd "$(dirname "$0")" && pwd)
+work=${1:-"$source_dir/_compare"}
+size=${2:-1000000}
+filters="time/operators time/arithmetic time/compare schedule/paths"
+jobs=$(nproc 2>/dev/null || echo 1)
+
+mkdir -p "$work"
+work=$(cd "$work" && pwd)
+
+build() {
+    name=$1
+    shift
+    cmake -S "$source_dir" -B "$work/build-$name" -DCMAKE_BUILD_TYPE=Release "$@" > /dev/null
+    cmake --build "$work/build-$name" -j"$jobs" > /dev/null
+}
+
+run() {
+    name=$1
+    rm -f "$work/$name.jsonl"
+    for filter in $filters; do
+        "$work/build-$name/bench" --json "$work/$name.jsonl" "$filter" "$size" > /dev/null
+    done
+}
+
+echo "Release" >&2
+build release
+run release
+
+echo "Release + LTO" >&2
+build lto -DOOP2_LTO=ON
+run lto
+
+echo "Release + LTO + PGO: сбор профиля" >&2
+rm -rf "$work/pgo"
+build pgo-gen -DOOP2_PGO=GENERATE -DOOP2_PGO_DIR="$work/pgo"
+cmake --build "$work/build-pgo-gen" --target pgo-train > /dev/null
+echo "Release + LTO + PGO" >&2
+build pgo -DOOP2_LTO=ON -DOOP2_PGO=USE -DOOP2_PGO_DIR="$work/pgo"
+run pgo
+
+# Таблица: замер и нс/операцию в каждой конфигурации
+awk '
+    function field(line, key,    rest) {
+        rest = substr(line, index(line, "\"" key "\":") + length(key) + 3)
+        if (substr(rest, 1, 1) == "\"") return substr(rest, 2, index(substr(rest, 2), "\"") - 1)
+        match(rest, /^[^,}]*/)
+        return substr(rest, 1, RLENGTH)
+    }
+    FNR == 1 { config++; names[config] = FILENAME; sub(/.*\//, "", names[config]); sub(/\.jsonl$/, "", names[config]) }
+    index($0, "\"nsPerOp\"") > 0 {
+        name = field($0, "name")
+        if (!(name in seen)) { seen[name] = 1; order[++count] = name }
+        ns[name, config] = field($0, "nsPerOp")
+    }
+    END {
+        printf "%-40s", "ns/op"
+        for (c = 1; c <= config; c++) printf "%12s", names[c]
+        printf "\n"
+        for (i = 1; i <= count; i++) {
+            printf "%-40s", order[i]
+            for (c = 1; c <= config; c++) printf "%12.2f", ns[order[i], c]
+            printf "\n"
+        }
+    }
+' "$work/release.jsonl" "$work/lto.jsonl" "$work/pgo.jsonl"
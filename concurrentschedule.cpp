@@ -0,0 +1,173 @@
+/**
+ * @file concurrentschedule.cpp
+ * @brief Реализация расписания для нескольких потоков
+ */
+
+ #include "concurrentschedule.h"
+ #include <thread>
+ #include <utility>
+
+ using namespace std;
+
+ // Потоки получают шарды по кругу при первом обращении
+ size_t ConcurrentSchedule::localShard() {
+     static atomic<size_t> next{0};
+     static thread_local size_t shard = next.fetch_add(1, memory_order_relaxed) % shardCount;
+     return shard;
+ }
+
+ // Порядок операций в arrive/depart и в смене копии - seq_cst: читатель
+ // должен либо попасть в счётчик, который проверит писатель, либо увидеть
+ // уже новую копию (схема Left-Right)
+ void ConcurrentSchedule::arrive(unsigned version) const {
+     readerShards_[localShard()].readers[version].fetch_add(1);
+ }
+
+ void ConcurrentSchedule::depart(unsigned version) const {
+     readerShards_[localShard()].readers[version].fetch_sub(1);
+ }
+
+ void ConcurrentSchedule::waitForReaders(unsigned version) const {
+     for (const ReaderShard& shard : readerShards_) {
+         while (shard.readers[version].load() != 0) this_thread::yield();
+     }
+ }
+
+ void ConcurrentSchedule::submit(Operation operation) {
+     WriterShard& shard = writerShards_[localShard()];
+     uint64_t ticket;
+     {
+         lock_guard<mutex> guard(shard.lock);
+         shard.queue.push_back(move(operation));
+         ticket = ++shard.submitted;
+     }
+     pendingShards_.fetch_or(uint64_t(1) << localShard());
+     // Пока ждём блокировку, операцию может применить в своём пакете
+     // другой писатель - тогда делать ничего не нужно
+     lock_guard<mutex> writer(writeLock_);
+     if (shard.completed < ticket) applyPending();
+ }
+
+ void ConcurrentSchedule::apply(ScheduleStore& store, Operation& operation, bool report) {
+     if (operation.kind == Operation::Kind::Add) {
+         EventHandle handle = store.add(operation.name, operation.start, operation.end, operation.planned);
+         if (report) *operation.added = handle;
+         return;
+     }
+     int index = store.indexOf(operation.handle);
+     if (report) *operation.applied = index >= 0;
+     if (index < 0) return;
+     switch (operation.kind) {
+         case Operation::Kind::SetName: store.setName(index, operation.name); break;
+         case Operation::Kind::SetStart:
+             store.setStart(index, operation.start);
+             store.setActual(index, actualDurationSeconds(store.start(index), store.end(index)));
+             break;
+         case Operation::Kind::SetEnd:
+             store.setEnd(index, operation.start);
+             store.setActual(index, actualDurationSeconds(store.start(index), store.end(index)));
+             break;
+         case Operation::Kind::SetPlanned: store.setPlanned(index, operation.start); break;
+         case Operation::Kind::Remove: store.remove(index); break;
+         case Operation::Kind::Add: break;
+     }
+ }
+
+ // Вызывается под writeLock_
+ void ConcurrentSchedule::applyPending() {
+     // Обходятся только шарды с отмеченными очередями. Бит, выставленный
+     // после обмена, останется до следующего пакета - пустая очередь не вредит
+     uint64_t drained = pendingShards_.exchange(0);
+     uint64_t taken[shardCount];
+     batch_.clear();
+     for (uint64_t bits = drained; bits != 0; bits &= bits - 1) {
+         size_t s = static_cast<size_t>(__builtin_ctzll(bits));
+         WriterShard& shard = writerShards_[s];
+         lock_guard<mutex> guard(shard.lock);
+         taken[s] = shard.submitted;
+         for (Operation& operation : shard.queue) batch_.push_back(move(operation));
+         shard.queue.clear();
+     }
+     if (batch_.empty()) return;
+
+     // Свободная копия получает пакет и становится видимой читателям
+     unsigned readable = readable_.load();
+     ScheduleStore& spare = replicas_[1 - readable];
+     for (Operation& operation : batch_) apply(spare, operation, true);
+     spare.prepareForReaders();
+     readable_.store(1 - readable);
+
+     // Новые читатели отмечаются в другом счётчике; прежняя копия
+     // освобождается, когда уходят все читатели обоих счётчиков
+     unsigned version = version_.load();
+     waitForReaders(1 - version);
+     version_.store(1 - version);
+     waitForReaders(version);
+
+     ScheduleStore& retired = replicas_[readable];
+     for (Operation& operation : batch_) apply(retired, operation, false);
+     retired.prepareForReaders();
+
+     for (uint64_t bits = drained; bits != 0; bits &= bits - 1) {
+         size_t s = static_cast<size_t>(__builtin_ctzll(bits));
+         writerShards_[s].completed = taken[s];
+     }
+     batches_++;
+ }
+
+ EventHandle ConcurrentSchedule::add(string_view name, int32_t startSeconds, int32_t endSeconds, int32_t plannedSeconds) {
+     EventHandle handle{0, 0};
+     submit(Operation{Operation::Kind::Add, EventHandle{0, 0}, string(name), startSeconds, endSeconds, plannedSeconds,
+                      &handle, nullptr});
+     return handle;
+ }
+
+ bool ConcurrentSchedule::setName(EventHandle handle, string_view name) {
+     bool applied = false;
+     submit(Operation{Operation::Kind::SetName, handle, string(name), 0, 0, 0, nullptr, &applied});
+     return applied;
+ }
+
+ bool ConcurrentSchedule::setStart(EventHandle handle, int32_t seconds) {
+     bool applied = false;
+     submit(Operation{Operation::Kind::SetStart, handle, string(), seconds, 0, 0, nullptr, &applied});
+     return applied;
+ }
+
+ bool ConcurrentSchedule::setEnd(EventHandle handle, int32_t seconds) {
+     bool applied = false;
+     submit(Operation{Operation::Kind::SetEnd, handle, string(), seconds, 0, 0, nullptr, &applied});
+     return applied;
+ }
+
+ bool ConcurrentSchedule::setPlanned(EventHandle handle, int32_t seconds) {
+     bool applied = false;
+     submit(Operation{Operation::Kind::SetPlanned, handle, string(), seconds, 0, 0, nullptr, &applied});
+     return applied;
+ }
+
+ bool ConcurrentSchedule::remove(EventHandle handle) {
+     bool applied = false;
+     submit(Operation{Operation::Kind::Remove, handle, string(), 0, 0, 0, nullptr, &applied});
+     return applied;
+ }
+
+ void ConcurrentSchedule::assign(const ScheduleStore& store) {
+     lock_guard<mutex> writer(writeLock_);
+     // Операции, поставленные до загрузки, применяются к прежнему содержимому
+     applyPending();
+     unsigned readable = readable_.load();
+     replicas_[1 - readable] = store;
+     replicas_[1 - readable].prepareForReaders();
+     readable_.store(1 - readable);
+     unsigned version = version_.load();
+     waitForReaders(1 - version);
+     version_.store(1 - version);
+     waitForReaders(version);
+     replicas_[readable] = replicas_[1 - readable];
+ }
+
+ size_t ConcurrentSchedule::batchCount() {
+     lock_guard<mutex> writer(writeLock_);
+     return batches_;
+ }
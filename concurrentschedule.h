@@ -0,0 +1,137 @@
+/**
+ * @file concurrentschedule.h
+ * @brief Расписание для одновременной работы нескольких читателей и писателей
+ */
+
+ #ifndef CONCURRENTSCHEDULE_H
+ #define CONCURRENTSCHEDULE_H
+
+ #include "schedulestore.h"
+ #include <atomic>
+ #include <cstddef>
+ #include <cstdint>
+ #include <mutex>
+ #include <string>
+ #include <string_view>
+ #include <utility>
+ #include <vector>
+
+ /**
+  * @class ConcurrentSchedule
+  * @brief Две копии ScheduleStore по схеме Left-Right с пакетной записью
+  *
+  * Читатели работают с одной копией, писатель - с другой, затем копии
+  * меняются ролями. Чтение не берёт блокировок и не повторяется: поток
+  * отмечается в своём счётчике читателей (счётчики разнесены по
+  * кэш-линиям, как счетчики Time) и вызывает функцию над неизменной
+  * копией. Поэтому рост столбцов в add() и уплотнение никогда не
+  * происходят под читателем.
+  *
+  * Запись складывается в очередь своего шарда. Поток, захвативший
+  * блокировку записи, применяет за раз все накопившиеся операции всех
+  * шардов: к свободной копии, публикует её, дожидается ухода читателей
+  * со старой и повторяет операции на ней. Стоимость публикации делится
+  * на весь пакет, а сами операции выполняются дважды - по разу на копию.
+  *
+  * Мероприятия для правки и удаления задаются дескрипторами: позиции
+  * могут сдвинуться из-за чужих удалений. Обе копии получают одни и те же
+  * операции в одном порядке, поэтому дескрипторы в них совпадают.
+  */
+ class ConcurrentSchedule {
+ public:
+     static constexpr size_t shardCount = 64; ///< Шарды счётчиков читателей и очередей записи (бит в uint64_t)
+
+ private:
+     // Отложенная операция записи
+     struct Operation {
+         enum class Kind { Add, SetName, SetStart, SetEnd, SetPlanned, Remove };
+         Kind kind;
+         EventHandle handle;     ///< Мероприятие (кроме Add)
+         std::string name;       ///< Название для Add и SetName
+         int32_t start;          ///< Начало для Add, новое значение для SetStart/SetEnd/SetPlanned
+         int32_t end;            ///< Конец для Add
+         int32_t planned;        ///< План для Add
+         EventHandle* added;     ///< Куда записать дескриптор нового мероприятия
+         bool* applied;          ///< Куда записать, действителен ли был дескриптор
+     };
+
+     struct alignas(64) ReaderShard {
+         std::atomic<int64_t> readers[2] = {{0}, {0}}; ///< Читатели по версии
+     };
+
+     struct alignas(64) WriterShard {
+         std::mutex lock;
+         std::vector<Operation> queue; ///< Ожидающие операции
+         uint64_t submitted = 0;       ///< Выдано номеров (под lock)
+         uint64_t completed = 0;       ///< Применено операций (под writeLock_)
+     };
+
+     ScheduleStore replicas_[2];
+     std::atomic<unsigned> readable_{0}; ///< Копия, которую видят читатели
+     std::atomic<unsigned> version_{0};  ///< Набор счётчиков для новых читателей
+     mutable ReaderShard readerShards_[shardCount];
+     WriterShard writerShards_[shardCount];
+     std::atomic<uint64_t> pendingShards_{0}; ///< Бит на каждый шард с непустой очередью
+     std::mutex writeLock_;              ///< Держит применяющий пакет поток
+     std::vector<Operation> batch_;      ///< Пакет (под writeLock_)
+     size_t batches_ = 0;                ///< Число применённых пакетов (под writeLock_)
+
+     static size_t localShard();
+     void arrive(unsigned version) const;
+     void depart(unsigned version) const;
+     void waitForReaders(unsigned version) const;
+     void submit(Operation operation);
+     void applyPending();
+     static void apply(ScheduleStore& store, Operation& operation, bool report);
+
+ public:
+     ConcurrentSchedule() = default;
+     ConcurrentSchedule(const ConcurrentSchedule&) = delete;
+     ConcurrentSchedule& operator=(const ConcurrentSchedule&) = delete;
+
+     /**
+      * @brief Выполнить чтение над согласованной копией расписания
+      * @param reader Функция reader(const ScheduleStore&); не должна
+      *               вызывать методы записи этого же объекта
+      * @return Результат reader
+      *
+      * Без блокировок и повторов. Пока reader работает, писатель не может
+      * применить второй пакет, поэтому долгие отчёты задерживают запись.
+      */
+     template <typename Reader>
+     auto read(Reader reader) const -> decltype(reader(std::declval<const ScheduleStore&>())) {
+         unsigned version = version_.load();
+         arrive(version);
+         struct Departure {
+             const ConcurrentSchedule* owner;
+             unsigned version;
+             ~Departure() { owner->depart(version); }
+         } departure{this, version};
+         return reader(replicas_[readable_.load()]);
+     }
+
+     /**
+      * @brief Добавить мероприятие
+      * @return Дескриптор нового мероприятия
+      */
+     EventHandle add(std::string_view name, int32_t startSeconds, int32_t endSeconds, int32_t plannedSeconds);
+
+     // Правка и удаление; false - дескриптор недействителен
+     bool setName(EventHandle handle, std::string_view name);   ///< Изменить название
+     bool setStart(EventHandle handle, int32_t seconds);        ///< Изменить начало
+     bool setEnd(EventHandle handle, int32_t seconds);          ///< Изменить конец
+     bool setPlanned(EventHandle handle, int32_t seconds);      ///< Изменить план
+     bool remove(EventHandle handle);                           ///< Удалить мероприятие
+
+     /**
+      * @brief Заменить содержимое копией расписания (загрузка)
+      */
+     void assign(const ScheduleStore& store);
+
+     /**
+      * @brief Число применённых пакетов записи (для оценки группировки)
+      */
+     size_t batchCount();
+ };
+
+ #endif
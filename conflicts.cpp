@@ -0,0 +1,136 @@
+/**
+ * @file conflicts.cpp
+ * @brief Реализация пакетной проверки расписания
+ */
+
+ #include "conflicts.h"
+ #include "parallel.h"
+ #include <algorithm>
+
+ using namespace std;
+
+ namespace {
+
+ const int32_t daySeconds = 24 * 3600;
+
+ int32_t dayOffset(int32_t seconds) {
+     int32_t r = seconds % daySeconds;
+     return r < 0 ? r + daySeconds : r;
+ }
+
+ // Длина мероприятия на суточном круге: фактическая длительность по
+ // исходным началу и концу (конец больше суток - мероприятие на несколько
+ // дней), но не больше суток - многодневное мероприятие занимает весь круг
+ int32_t circleLength(int32_t startSeconds, int32_t endSeconds) {
+     return min(max(actualDurationSeconds(startSeconds, endSeconds), 0), daySeconds);
+ }
+
+ // Интервал на прямой: [start, end), end может выходить за полночь
+ struct Span {
+     int32_t start;
+     int32_t end;
+     int position;
+ };
+
+ int32_t linearOverlap(int32_t start1, int32_t end1, int32_t start2, int32_t end2) {
+     return max(0, min(end1, end2) - max(start1, start2));
+ }
+
+ } // namespace
+
+ int32_t circularOverlapSeconds(int32_t start1, int32_t end1, int32_t start2, int32_t end2) {
+     int32_t a = dayOffset(start1);
+     int32_t b = a + circleLength(start1, end1);
+     int32_t c = dayOffset(start2);
+     int32_t d = c + circleLength(start2, end2);
+     // Интервалы не длиннее суток: достаточно сдвигов второго на -1, 0 и +1 сутки
+     return linearOverlap(a, b, c - daySeconds, d - daySeconds)
+          + linearOverlap(a, b, c, d)
+          + linearOverlap(a, b, c + daySeconds, d + daySeconds);
+ }
+
+ ConflictReport findConflicts(const ScheduleStore& schedule, const ConflictOptions& options) {
+     ConflictReport report;
+     int n = schedule.size();
+     if (n == 0) return report;
+
+     unsigned threads = static_cast<size_t>(n) >= options.parallelThreshold ? resolveThreads(options.threads) : 1;
+
+     // Мероприятие через полночь дополнительно занимает утро: копия на сутки раньше
+     vector<Span> spans;
+     spans.reserve(n + n / 8);
+     for (int i = 0; i < n; i++) {
+         int32_t start = dayOffset(schedule.start(i));
+         int32_t end = start + circleLength(schedule.start(i), schedule.end(i));
+         spans.push_back(Span{start, end, i});
+         if (end > daySeconds) spans.push_back(Span{start - daySeconds, end - daySeconds, i});
+     }
+     parallelSort(spans, threads, [](const Span& x, const Span& y) {
+         return x.start != y.start ? x.start < y.start : x.position < y.position;
+     });
+
+     // Пересечения: для каждого интервала - следующие, начинающиеся до его конца
+     vector<vector<EventConflict>> found(threads);
+     parallelFor(spans.size(), threads, [&](size_t begin, size_t end, unsigned part) {
+         vector<EventConflict>& out = found[part];
+         for (size_t i = begin; i < end; i++) {
+             for (size_t j = i + 1; j < spans.size() && spans[j].start < spans[i].end; j++) {
+                 if (spans[j].position == spans[i].position) continue;
+                 if (linearOverlap(spans[i].start, spans[i].end, spans[j].start, spans[j].end) == 0) continue;
+                 int a = min(spans[i].position, spans[j].position);
+                 int b = max(spans[i].position, spans[j].position);
+                 out.push_back(EventConflict{a, b, 0});
+             }
+         }
+     });
+
+     for (vector<EventConflict>& part : found) {
+         report.overlaps.insert(report.overlaps.end(), part.begin(), part.end());
+         vector<EventConflict>().swap(part);
+     }
+     // Пара двух ночных мероприятий находится дважды: по оригиналам и по копиям
+     auto byPair = [](const EventConflict& x, const EventConflict& y) {
+         return x.first != y.first ? x.first < y.first : x.second < y.second;
+     };
+     parallelSort(report.overlaps, threads, byPair);
+     report.overlaps.erase(unique(report.overlaps.begin(), report.overlaps.end(),
+                                  [](const EventConflict& x, const EventConflict& y) {
+                                      return x.first == y.first && x.second == y.second;
+                                  }),
+                           report.overlaps.end());
+     parallelFor(report.overlaps.size(), threads, [&](size_t begin, size_t end, unsigned) {
+         for (size_t k = begin; k < end; k++) {
+             EventConflict& c = report.overlaps[k];
+             c.overlapSeconds = circularOverlapSeconds(schedule.start(c.first), schedule.end(c.first),
+                                                       schedule.start(c.second), schedule.end(c.second));
+         }
+     });
+
+     // Перерывы: разрывы в объединении занятых промежутков. Копии начинаются
+     // раньше полуночи и заканчиваются после неё, поэтому все разрывы
+     // лежат в пределах суток.
+     int32_t coverEnd = spans[0].end;
+     int owner = spans[0].position;
+     for (size_t i = 1; i < spans.size(); i++) {
+         if (spans[i].start > coverEnd) {
+             int32_t gap = spans[i].start - coverEnd;
+             if (gap < options.minGapSeconds) {
+                 report.shortGaps.push_back(ScheduleGap{owner, spans[i].position, gap});
+             }
+         }
+         if (spans[i].end > coverEnd) {
+             coverEnd = spans[i].end;
+             owner = spans[i].position;
+         }
+     }
+     // Если ничто не переходит через полночь (копий нет), остаётся перерыв
+     // до первого мероприятия следующих суток
+     if (coverEnd <= daySeconds) {
+         const Span& first = spans[0];
+         int32_t gap = first.start + daySeconds - coverEnd;
+         if (first.position != owner && gap > 0 && gap < options.minGapSeconds) {
+             report.shortGaps.push_back(ScheduleGap{owner, first.position, gap});
+         }
+     }
+     return report;
+ }
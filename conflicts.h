@@ -0,0 +1,76 @@
+/**
+ * @file conflicts.h
+ * @brief Пакетный поиск пересечений и коротких перерывов в расписании
+ */
+
+ #ifndef CONFLICTS_H
+ #define CONFLICTS_H
+
+ #include "schedulestore.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <vector>
+
+ /**
+  * @struct EventConflict
+  * @brief Пара пересекающихся мероприятий
+  */
+ struct EventConflict {
+     int first;              ///< Позиция первого мероприятия (first < second)
+     int second;             ///< Позиция второго мероприятия
+     int32_t overlapSeconds; ///< Длительность пересечения на суточном круге
+ };
+
+ /**
+  * @struct ScheduleGap
+  * @brief Перерыв между соседними занятыми промежутками
+  */
+ struct ScheduleGap {
+     int before;         ///< Мероприятие, которое заканчивается перед перерывом
+     int after;          ///< Мероприятие, которое начинается после перерыва
+     int32_t gapSeconds; ///< Длительность перерыва
+ };
+
+ /**
+  * @struct ConflictOptions
+  * @brief Параметры проверки расписания
+  */
+ struct ConflictOptions {
+     int32_t minGapSeconds = 0;          ///< Перерывы короче этого попадают в отчёт
+     size_t parallelThreshold = 100000;  ///< С этого числа мероприятий работа делится на потоки
+     unsigned threads = 0;               ///< Число потоков (0 - по числу ядер)
+ };
+
+ /**
+  * @struct ConflictReport
+  * @brief Результат проверки
+  */
+ struct ConflictReport {
+     std::vector<EventConflict> overlaps; ///< Пересечения, упорядочены по (first, second)
+     std::vector<ScheduleGap> shortGaps;  ///< Короткие перерывы в порядке времени суток
+ };
+
+ /**
+  * @brief Длительность пересечения двух мероприятий на суточном круге
+  * @param start1 Начало первого, секунды от полуночи
+  * @param end1 Конец первого (раньше начала - следующие сутки, больше
+  *        суток - мероприятие на несколько дней, занимающее весь круг)
+  * @param start2 Начало второго
+  * @param end2 Конец второго
+  * @return Секунды пересечения
+  */
+ int32_t circularOverlapSeconds(int32_t start1, int32_t end1, int32_t start2, int32_t end2);
+
+ /**
+  * @brief Найти все пересечения и короткие перерывы
+  * @param schedule Расписание
+  * @param options Порог перерыва и параметры распараллеливания
+  * @return Отчёт
+  *
+  * Заметающая прямая по мероприятиям, отсортированным по началу:
+  * O(n log n + k), где k - число пересечений. Мероприятие, переходящее
+  * через полночь, участвует ещё и копией, сдвинутой на сутки назад.
+  */
+ ConflictReport findConflicts(const ScheduleStore& schedule, const ConflictOptions& options);
+
+ #endif
@@ -0,0 +1,285 @@
+/**
+ * @file datetime.h
+ * @brief Момент времени с датой: номер дня и секунды суток, быстрый перевод в календарь
+ */
+
+ #ifndef DATETIME_H
+ #define DATETIME_H
+
+ #include "timespan.h"
+ #include "timevalue.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <type_traits>
+
+ /**
+  * @struct CivilDate
+  * @brief Дата григорианского календаря (пролептического - и до 1582 года)
+  */
+ struct CivilDate {
+     int32_t year;   ///< Год; 0 - это 1 год до н. э.
+     uint32_t month; ///< Месяц, 1..12
+     uint32_t day;   ///< День месяца, 1..31
+
+     constexpr bool operator==(const CivilDate& other) const noexcept {
+         return year == other.year && month == other.month && day == other.day;
+     }
+     constexpr bool operator!=(const CivilDate& other) const noexcept { return !(*this == other); }
+ };
+
+ // Перевод между номером дня (0 - 1970-01-01) и датой без таблиц и без
+ // ветвлений по месяцам: алгоритм Нери и Шнайдера ("Euclidean affine
+ // functions and their application to calendar algorithms", 2022). Год
+ // начинается с марта, так что високосный день - последний; деления на
+ // 4, 100 и 400 заменены умножениями и сдвигами. Дни сдвигаются на 82
+ // цикла по 400 лет, чтобы считать в беззнаковых числах: перевод верен
+ // для годов от -32800 до примерно 2,9 миллиона, DateTime ограничивает
+ // даты годами ±32767.
+
+ namespace civilDetail {
+     constexpr uint32_t shiftYears = 400 * 82;              ///< Сдвиг годов в неотрицательные
+     constexpr uint32_t shiftDays = 719468 + 146097 * 82;   ///< 0000-03-01 + сдвиг -> 1970-01-01
+ }
+
+ /**
+  * @brief Номер дня от 1970-01-01 по дате
+  * @param year Год (от -32800)
+  * @param month Месяц, 1..12
+  * @param day День месяца, 1..31 (не проверяется; 31 февраля - это 2 или 3 марта)
+  */
+ constexpr int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day) noexcept {
+     uint32_t january = month <= 2;
+     uint32_t y = static_cast<uint32_t>(year) + civilDetail::shiftYears - january;
+     uint32_t m = january ? month + 12 : month;
+     uint32_t century = y / 100;
+     uint32_t yearDays = 1461 * y / 4 - century + century / 4;
+     uint32_t monthDays = (979 * m - 2919) / 32;
+     return static_cast<int32_t>(yearDays + monthDays + day - 1 - civilDetail::shiftDays);
+ }
+
+ /**
+  * @brief Дата по номеру дня от 1970-01-01
+  */
+ constexpr CivilDate civilFromDays(int32_t days) noexcept {
+     uint32_t n = static_cast<uint32_t>(days) + civilDetail::shiftDays;
+     // Век и день в нём
+     uint32_t n1 = 4 * n + 3;
+     uint32_t century = n1 / 146097;
+     uint32_t dayOfCentury = n1 % 146097 / 4;
+     // Год в веке и день в году (с 1 марта)
+     uint32_t n2 = 4 * dayOfCentury + 3;
+     uint64_t p2 = uint64_t(2939745) * n2;
+     uint32_t yearOfCentury = static_cast<uint32_t>(p2 >> 32);
+     uint32_t dayOfYear = static_cast<uint32_t>(p2) / 2939745 / 4;
+     // Месяц и день: одно умножение вместо таблицы длин месяцев
+     uint32_t n3 = 2141 * dayOfYear + 197913;
+     uint32_t month = n3 >> 16;
+     uint32_t day = (n3 & 65535) / 2141;
+     uint32_t january = dayOfYear >= 306;
+     return CivilDate{static_cast<int32_t>(100 * century + yearOfCentury - civilDetail::shiftYears + january),
+                      january ? month - 12 : month, day + 1};
+ }
+
+ /**
+  * @brief День недели по номеру дня: 1 - понедельник, ..., 7 - воскресенье (ISO 8601)
+  */
+ constexpr uint32_t weekdayFromDays(int32_t days) noexcept {
+     // 1970-01-01 - четверг; сдвиг на кратное 7 делает делимое неотрицательным
+     return static_cast<uint32_t>((int64_t(days) + 3 + 7 * (int64_t(1) << 31)) % 7) + 1;
+ }
+
+ /**
+  * @brief Високосный ли год
+  */
+ constexpr bool isLeapYear(int32_t year) noexcept {
+     // Кратный 100 год високосен, только если кратен 400, то есть 16
+     return (year & (year % 100 != 0 ? 3 : 15)) == 0;
+ }
+
+ /**
+  * @brief Дней в месяце
+  */
+ constexpr uint32_t daysInMonth(int32_t year, uint32_t month) noexcept {
+     return month == 2 ? (isLeapYear(year) ? 29 : 28) : 30 + ((month ^ (month >> 3)) & 1);
+ }
+
+ /**
+  * @class DateTime
+  * @brief Момент времени: номер дня от 1970-01-01 и секунды от полуночи
+  *
+  * В отличие от Time и столбцов расписания, где хранятся только секунды
+  * суток, момент помнит день, поэтому разность двух моментов - честная
+  * длительность, в том числе через несколько суток, без "прибавить сутки,
+  * если отрицательно". Часовых поясов и секунд координации нет (UTC,
+  * как time_t). Дни ограничены годами ±32767: арифметика за этими
+  * границами насыщается, как у TimeSpan.
+  *
+  * Тип тривиально копируемый, все операции, кроме вывода, - constexpr.
+  */
+ class DateTime {
+ public:
+     static constexpr int32_t secondsPerDay = 24 * 3600;          ///< Секунд в сутках
+     static constexpr int32_t minDay = daysFromCivil(-32767, 1, 1);  ///< Наименьший день
+     static constexpr int32_t maxDay = daysFromCivil(32767, 12, 31); ///< Наибольший день
+
+     /// Длина formatTo: "-32767-12-31 23:59:59"
+     static constexpr size_t maxFormattedLength = 21;
+
+ private:
+     int32_t day_ = 0;     ///< Номер дня от 1970-01-01
+     int32_t seconds_ = 0; ///< Секунды от полуночи, [0, secondsPerDay)
+
+     // Деление с округлением вниз: -1 секунда - это 23:59:59 предыдущего дня
+     static constexpr int64_t floorDiv(int64_t a, int64_t b) noexcept {
+         return a / b - (a % b < 0);
+     }
+
+     static constexpr DateTime fromTotal(int64_t totalSeconds) noexcept {
+         int64_t day = floorDiv(totalSeconds, secondsPerDay);
+         DateTime moment;
+         if (day < minDay) {
+             moment.day_ = minDay;
+         } else if (day > maxDay) {
+             moment.day_ = maxDay;
+             moment.seconds_ = secondsPerDay - 1;
+         } else {
+             moment.day_ = static_cast<int32_t>(day);
+             moment.seconds_ = static_cast<int32_t>(totalSeconds - day * secondsPerDay);
+         }
+         return moment;
+     }
+
+     constexpr int64_t totalSeconds() const noexcept {
+         return int64_t(day_) * secondsPerDay + seconds_;
+     }
+
+ public:
+     /**
+      * @brief Полночь 1970-01-01
+      */
+     constexpr DateTime() noexcept = default;
+
+     /**
+      * @brief Момент по номеру дня и секундам
+      * @param day Номер дня от 1970-01-01
+      * @param seconds Секунды от полуночи этого дня; лишние переходят в
+      *        следующие дни, отрицательные - в предыдущие
+      */
+     constexpr DateTime(int32_t day, int64_t seconds) noexcept
+         : DateTime(fromTotal(saturatingAdd<int64_t>(int64_t(day) * secondsPerDay, seconds))) {}
+
+     /**
+      * @brief Момент по дате и времени суток
+      */
+     static constexpr DateTime fromCivil(int32_t year, uint32_t month, uint32_t day,
+                                         int hours = 0, int minutes = 0, int seconds = 0) noexcept {
+         return DateTime(daysFromCivil(year, month, day),
+                         int64_t(hours) * 3600 + int64_t(minutes) * 60 + seconds);
+     }
+
+     /**
+      * @brief Момент по секундам от 1970-01-01 00:00:00 UTC (time_t)
+      */
+     static constexpr DateTime fromUnixSeconds(int64_t seconds) noexcept {
+         return fromTotal(seconds);
+     }
+
+     constexpr int32_t day() const noexcept { return day_; }                                ///< Номер дня
+     constexpr int32_t secondsOfDay() const noexcept { return seconds_; }                   ///< Секунды от полуночи
+     constexpr int64_t unixSeconds() const noexcept { return totalSeconds(); }              ///< Секунды от 1970-01-01
+     constexpr CivilDate date() const noexcept { return civilFromDays(day_); }              ///< Дата
+     constexpr uint32_t weekday() const noexcept { return weekdayFromDays(day_); }          ///< День недели (1 - понедельник)
+     constexpr TimeValue timeOfDay() const noexcept { return TimeValue::fromSeconds(seconds_); } ///< Время суток
+
+     /**
+      * @brief Ближайший момент не раньше этого с заданным временем суток
+      * @param secondsOfDay Время суток, секунды от полуночи
+      *
+      * Так конец мероприятия, записанный только временем суток,
+      * становится моментом: 04:00 после 23:00 - это 04:00 следующего дня.
+      */
+     constexpr DateTime nextAt(int32_t secondsOfDay) const noexcept {
+         int64_t wait = secondsOfDay - seconds_;
+         return fromTotal(totalSeconds() + wait - floorDiv(wait, secondsPerDay) * secondsPerDay);
+     }
+
+     // Сдвиг на длительность (с насыщением на границах дат)
+     constexpr DateTime& operator+=(TimeSpan64 span) noexcept {
+         return *this = fromTotal(saturatingAdd(totalSeconds(), span.ticks()));
+     }
+     constexpr DateTime& operator-=(TimeSpan64 span) noexcept {
+         return *this = fromTotal(saturatingSub(totalSeconds(), span.ticks()));
+     }
+     constexpr DateTime operator+(TimeSpan64 span) const noexcept { return DateTime(*this) += span; }
+     constexpr DateTime operator-(TimeSpan64 span) const noexcept { return DateTime(*this) -= span; }
+
+     /**
+      * @brief Длительность от other до этого момента (отрицательная, если other позже)
+      */
+     constexpr TimeSpan64 operator-(DateTime other) const noexcept {
+         return TimeSpan64::fromSeconds(totalSeconds() - other.totalSeconds());
+     }
+
+     // Сравнение: сначала день, затем секунды
+ #ifdef __cpp_impl_three_way_comparison
+     constexpr auto operator<=>(const DateTime& other) const noexcept = default; ///< Все шесть сравнений (C++20)
+     constexpr bool operator==(const DateTime& other) const noexcept = default;  ///< Равно
+ #else
+     constexpr bool operator<(DateTime other) const noexcept { return totalSeconds() < other.totalSeconds(); }
+     constexpr bool operator>(DateTime other) const noexcept { return totalSeconds() > other.totalSeconds(); }
+     constexpr bool operator<=(DateTime other) const noexcept { return totalSeconds() <= other.totalSeconds(); }
+     constexpr bool operator>=(DateTime other) const noexcept { return totalSeconds() >= other.totalSeconds(); }
+     constexpr bool operator==(DateTime other) const noexcept { return day_ == other.day_ && seconds_ == other.seconds_; }
+     constexpr bool operator!=(DateTime other) const noexcept { return !(*this == other); }
+ #endif
+
+     /**
+      * @brief Записать момент как ГГГГ-ММ-ДД ЧЧ:ММ:СС без выделения памяти
+      * @param out Буфер не короче maxFormattedLength символов
+      * @return Указатель за последним записанным символом
+      *
+      * Год дополняется нулями до четырёх цифр, отрицательный - со знаком.
+      */
+     char* formatTo(char* out) const noexcept {
+         CivilDate date = civilFromDays(day_);
+         uint32_t year = static_cast<uint32_t>(date.year);
+         if (date.year < 0) {
+             *out++ = '-';
+             year = 0 - year;
+         }
+         if (year >= 10000) *out++ = static_cast<char>('0' + year / 10000);
+         out = writeTwoDigits(out, year / 100 % 100);
+         out = writeTwoDigits(out, year % 100);
+         *out++ = '-';
+         out = writeTwoDigits(out, date.month);
+         *out++ = '-';
+         out = writeTwoDigits(out, date.day);
+         *out++ = ' ';
+         uint32_t seconds = static_cast<uint32_t>(seconds_);
+         out = writeTwoDigits(out, seconds / 3600);
+         *out++ = ':';
+         out = writeTwoDigits(out, seconds / 60 % 60);
+         *out++ = ':';
+         return writeTwoDigits(out, seconds % 60);
+     }
+
+ private:
+     static char* writeTwoDigits(char* out, uint32_t value) noexcept {
+         out[0] = static_cast<char>('0' + value / 10);
+         out[1] = static_cast<char>('0' + value % 10);
+         return out + 2;
+     }
+ };
+
+ static_assert(std::is_trivially_copyable<DateTime>::value, "DateTime должен быть тривиально копируемым");
+ static_assert(sizeof(DateTime) == 2 * sizeof(int32_t), "DateTime - это день и секунды");
+ static_assert(daysFromCivil(1970, 1, 1) == 0 && daysFromCivil(2000, 3, 1) == 11017, "номер дня");
+ static_assert(civilFromDays(-1) == CivilDate{1969, 12, 31} && civilFromDays(11016) == CivilDate{2000, 2, 29},
+               "дата по номеру дня");
+ static_assert(weekdayFromDays(0) == 4 && weekdayFromDays(-1) == 3, "1970-01-01 - четверг");
+ static_assert(DateTime(0, 23 * 3600).nextAt(4 * 3600) - DateTime(0, 23 * 3600) == TimeSpan64::fromSeconds(5 * 3600),
+               "конец раньше начала - следующие сутки");
+ static_assert(DateTime::fromCivil(2024, 2, 28, 22, 0, 0) + TimeSpan64::fromHms(50, 0, 0)
+               == DateTime::fromCivil(2024, 3, 2), "длительность через несколько суток и 29 февраля");
+
+ #endif
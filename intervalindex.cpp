@@ -0,0 +1,236 @@
+/**
+ * @file intervalindex.cpp
+ * @brief Реализация индекса интервалов
+ */
+
+ #include "intervalindex.h"
+ #include <algorithm>
+
+ using namespace std;
+
+ namespace {
+
+ const int32_t daySeconds = 24 * 3600;
+
+ int32_t dayOffset(int32_t seconds) {
+     int32_t r = seconds % daySeconds;
+     return r < 0 ? r + daySeconds : r;
+ }
+
+ // Длина мероприятия на суточном круге: фактическая длительность по
+ // исходным началу и концу, многодневное мероприятие занимает все сутки
+ int32_t circleLength(int32_t startSeconds, int32_t endSeconds) {
+     return min(max(actualDurationSeconds(startSeconds, endSeconds), 0), daySeconds);
+ }
+
+ // Перемешивание номера слота: приоритеты не зависят от порядка вставки
+ uint32_t mixPriority(uint32_t x) {
+     x ^= x >> 16;
+     x *= 0x7feb352dU;
+     x ^= x >> 15;
+     x *= 0x846ca68bU;
+     x ^= x >> 16;
+     return x;
+ }
+
+ } // namespace
+
+ // Ключ узла - пара (начало, слот): одинаковые начала различаются слотом
+ bool IntervalIndex::less(uint32_t a, uint32_t b) const {
+     if (nodes_[a].start != nodes_[b].start) return nodes_[a].start < nodes_[b].start;
+     return a < b;
+ }
+
+ void IntervalIndex::update(uint32_t n) {
+     Node& node = nodes_[n];
+     node.maxEnd = node.end;
+     if (node.left != nil) node.maxEnd = max(node.maxEnd, nodes_[node.left].maxEnd);
+     if (node.right != nil) node.maxEnd = max(node.maxEnd, nodes_[node.right].maxEnd);
+ }
+
+ // Делит поддерево на ключи меньше key и не меньше key
+ void IntervalIndex::split(uint32_t n, uint32_t key, uint32_t& left, uint32_t& right) {
+     if (n == nil) {
+         left = right = nil;
+         return;
+     }
+     if (less(n, key)) {
+         split(nodes_[n].right, key, nodes_[n].right, right);
+         left = n;
+     } else {
+         split(nodes_[n].left, key, left, nodes_[n].left);
+         right = n;
+     }
+     update(n);
+ }
+
+ uint32_t IntervalIndex::merge(uint32_t left, uint32_t right) {
+     if (left == nil) return right;
+     if (right == nil) return left;
+     if (nodes_[left].priority > nodes_[right].priority) {
+         nodes_[left].right = merge(nodes_[left].right, right);
+         update(left);
+         return left;
+     }
+     nodes_[right].left = merge(left, nodes_[right].left);
+     update(right);
+     return right;
+ }
+
+ uint32_t IntervalIndex::eraseFrom(uint32_t n, uint32_t key) {
+     if (n == nil) return nil;
+     if (n == key) return merge(nodes_[n].left, nodes_[n].right);
+     if (less(key, n)) nodes_[n].left = eraseFrom(nodes_[n].left, key);
+     else nodes_[n].right = eraseFrom(nodes_[n].right, key);
+     update(n);
+     return n;
+ }
+
+ void IntervalIndex::setNode(uint32_t n, uint32_t generation, int32_t startSeconds, int32_t endSeconds) {
+     Node& node = nodes_[n];
+     node.start = dayOffset(startSeconds);
+     node.end = node.start + circleLength(startSeconds, endSeconds);
+     node.maxEnd = node.end;
+     node.priority = mixPriority(n);
+     node.left = node.right = nil;
+     node.generation = generation;
+     node.linked = true;
+ }
+
+ void IntervalIndex::insert(EventHandle handle, int32_t startSeconds, int32_t endSeconds) {
+     if (handle.slot >= nodes_.size()) {
+         nodes_.resize(handle.slot + 1, Node{0, 0, 0, 0, nil, nil, 0, false});
+     }
+     uint32_t n = handle.slot;
+     setNode(n, handle.generation, startSeconds, endSeconds);
+
+     uint32_t left, right;
+     split(root_, n, left, right);
+     root_ = merge(merge(left, n), right);
+     size_++;
+ }
+
+ void IntervalIndex::erase(EventHandle handle) {
+     if (handle.slot >= nodes_.size()) return;
+     Node& node = nodes_[handle.slot];
+     if (!node.linked || node.generation != handle.generation) return;
+     root_ = eraseFrom(root_, handle.slot);
+     node.linked = false;
+     size_--;
+ }
+
+ void IntervalIndex::clear() {
+     nodes_.clear();
+     root_ = nil;
+     size_ = 0;
+ }
+
+ void IntervalIndex::rebuild(size_t count, const uint32_t* slots, const uint32_t* generations,
+                             const int32_t* starts, const int32_t* ends) {
+     clear();
+     uint32_t maxSlot = 0;
+     for (size_t i = 0; i < count; i++) maxSlot = max(maxSlot, slots[i]);
+     if (count == 0) return;
+     nodes_.resize(static_cast<size_t>(maxSlot) + 1, Node{0, 0, 0, 0, nil, nil, 0, false});
+     for (size_t i = 0; i < count; i++) {
+         setNode(slots[i], generations[slots[i]], starts[i], ends[i]);
+     }
+
+     // Сортировка подсчётом по началу; слоты перебираются по возрастанию,
+     // поэтому равные начала остаются упорядочены по слоту, как в less()
+     vector<uint32_t> bucket(daySeconds + 1, 0);
+     for (const Node& node : nodes_) {
+         if (node.linked) bucket[node.start + 1]++;
+     }
+     for (int32_t s = 0; s < daySeconds; s++) bucket[s + 1] += bucket[s];
+     vector<uint32_t> order(count);
+     for (uint32_t n = 0; n < nodes_.size(); n++) {
+         if (nodes_[n].linked) order[bucket[nodes_[n].start]++] = n;
+     }
+
+     // Декартово дерево по отсортированным ключам: правая граница на стеке
+     vector<uint32_t> spine;
+     for (uint32_t n : order) {
+         uint32_t last = nil;
+         while (!spine.empty() && nodes_[spine.back()].priority < nodes_[n].priority) {
+             last = spine.back();
+             spine.pop_back();
+         }
+         nodes_[n].left = last;
+         if (!spine.empty()) nodes_[spine.back()].right = n;
+         spine.push_back(n);
+     }
+     root_ = spine.front();
+     size_ = count;
+
+     // Максимумы концов: потомки обрабатываются раньше родителей
+     vector<uint32_t> preorder;
+     preorder.reserve(count);
+     spine.assign(1, root_);
+     while (!spine.empty()) {
+         uint32_t n = spine.back();
+         spine.pop_back();
+         preorder.push_back(n);
+         if (nodes_[n].left != nil) spine.push_back(nodes_[n].left);
+         if (nodes_[n].right != nil) spine.push_back(nodes_[n].right);
+     }
+     for (size_t i = preorder.size(); i-- > 0;) update(preorder[i]);
+ }
+
+ // Обход с отсечением: поддерево пропускается, если все его концы не
+ // дальше from, а правая часть - если начало узла уже не раньше to
+ void IntervalIndex::collect(uint32_t n, int32_t from, int32_t to, vector<EventHandle>& out) const {
+     while (n != nil) {
+         const Node& node = nodes_[n];
+         if (node.maxEnd <= from) return;
+         collect(node.left, from, to, out);
+         if (node.start >= to) return;
+         if (node.end > from) out.push_back(EventHandle{n, node.generation});
+         n = node.right;
+     }
+ }
+
+ void IntervalIndex::activeAt(int32_t seconds, vector<EventHandle>& out) const {
+     // Интервал длиннее нуля и короче суток содержит не больше одного из двух моментов
+     int32_t t = dayOffset(seconds);
+     collect(root_, t, t + 1, out);
+     collect(root_, t + daySeconds, t + daySeconds + 1, out);
+ }
+
+ void IntervalIndex::overlapping(int32_t from, int32_t to, vector<EventHandle>& out) const {
+     int32_t length = to - from;
+     if (length <= 0) length += daySeconds;
+     int32_t a = dayOffset(from);
+     int32_t b = a + min(length, daySeconds);
+
+     // Мероприятия лежат в [0, 2 суток): окно проверяется в трёх сдвигах
+     size_t first = out.size();
+     collect(root_, a, b, out);
+     collect(root_, a + daySeconds, b + daySeconds, out);
+     if (b > daySeconds) collect(root_, a - daySeconds, b - daySeconds, out);
+
+     auto bySlot = [](const EventHandle& x, const EventHandle& y) { return x.slot < y.slot; };
+     sort(out.begin() + first, out.end(), bySlot);
+     out.erase(unique(out.begin() + first, out.end()), out.end());
+ }
+
+ bool IntervalIndex::nextAfter(int32_t seconds, EventHandle& out) const {
+     if (root_ == nil) return false;
+     int32_t t = dayOffset(seconds);
+     uint32_t best = nil;
+     uint32_t first = root_;
+     for (uint32_t n = root_; n != nil;) {
+         if (nodes_[n].start > t) {
+             best = n;
+             n = nodes_[n].left;
+         } else {
+             n = nodes_[n].right;
+         }
+     }
+     if (best == nil) {
+         while (nodes_[first].left != nil) first = nodes_[first].left;
+         best = first;
+     }
+     out = EventHandle{best, nodes_[best].generation};
+     return true;
+ }
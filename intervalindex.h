@@ -0,0 +1,121 @@
+/**
+ * @file intervalindex.h
+ * @brief Индекс интервалов мероприятий для поиска по времени за O(log n)
+ */
+
+ #ifndef INTERVALINDEX_H
+ #define INTERVALINDEX_H
+
+ #include "scheduletypes.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <vector>
+
+ /**
+  * @class IntervalIndex
+  * @brief Декартово дерево интервалов [начало, конец) с максимумом конца в поддереве
+  *
+  * Узлы лежат в массиве и нумеруются слотами EventHandle, поэтому индекс
+  * копируется вместе с хранилищем без перестройки указателей. Время
+  * суточное: начало приводится к [0, 86400), а мероприятие, кончающееся
+  * раньше начала (23:00 → 04:00), хранится как [82800, 100800) - так же,
+  * как updateActualDuration добавляет сутки к отрицательной длительности.
+  */
+ class IntervalIndex {
+ private:
+     struct Node {
+         int32_t start;       ///< Начало, [0, 86400)
+         int32_t end;         ///< Конец, [start, start + 86400] (многодневное - весь круг)
+         int32_t maxEnd;      ///< Максимальный конец в поддереве
+         uint32_t priority;   ///< Приоритет кучи
+         uint32_t left;       ///< Левый потомок (меньшие ключи)
+         uint32_t right;      ///< Правый потомок (большие ключи)
+         uint32_t generation; ///< Поколение слота
+         bool linked;         ///< Узел входит в дерево
+     };
+
+     static constexpr uint32_t nil = UINT32_MAX;
+
+     std::vector<Node> nodes_; ///< Узлы по номерам слотов
+     uint32_t root_ = nil;
+     size_t size_ = 0;
+
+     void setNode(uint32_t n, uint32_t generation, int32_t startSeconds, int32_t endSeconds);
+     bool less(uint32_t a, uint32_t b) const;
+     void update(uint32_t n);
+     void split(uint32_t n, uint32_t key, uint32_t& left, uint32_t& right);
+     uint32_t merge(uint32_t left, uint32_t right);
+     uint32_t eraseFrom(uint32_t n, uint32_t key);
+     void collect(uint32_t n, int32_t from, int32_t to, std::vector<EventHandle>& out) const;
+
+ public:
+     /**
+      * @brief Добавить интервал мероприятия
+      * @param handle Дескриптор (слот не должен уже быть в индексе)
+      * @param startSeconds Начало, секунды от полуночи
+      * @param endSeconds Конец, секунды от полуночи
+      */
+     void insert(EventHandle handle, int32_t startSeconds, int32_t endSeconds);
+
+     /**
+      * @brief Убрать интервал мероприятия (если он есть в индексе)
+      */
+     void erase(EventHandle handle);
+
+     /**
+      * @brief Очистить индекс
+      */
+     void clear();
+
+     /**
+      * @brief Зарезервировать узлы под слоты 0..slots-1
+      */
+     void reserve(size_t slots) { nodes_.reserve(slots); }
+
+     /**
+      * @brief Построить индекс заново по столбцам расписания за O(n)
+      * @param count Число мероприятий
+      * @param slots Слот каждого мероприятия
+      * @param generations Поколения, индексированные слотом
+      * @param starts Начало каждого мероприятия
+      * @param ends Конец каждого мероприятия
+      *
+      * Быстрее count вызовов insert: ключи упорядочиваются сортировкой
+      * подсчётом по секундам суток, дерево собирается одним проходом.
+      */
+     void rebuild(size_t count, const uint32_t* slots, const uint32_t* generations,
+                  const int32_t* starts, const int32_t* ends);
+
+     /**
+      * @brief Количество интервалов
+      */
+     size_t size() const { return size_; }
+
+     /**
+      * @brief Мероприятия, идущие в момент времени
+      * @param seconds Момент, секунды от полуночи
+      * @param out Сюда дописываются дескрипторы
+      */
+     void activeAt(int32_t seconds, std::vector<EventHandle>& out) const;
+
+     /**
+      * @brief Мероприятия, пересекающиеся с [from, to)
+      * @param from Начало окна, секунды от полуночи
+      * @param to Конец окна; если to <= from, окно переходит через полночь
+      * @param out Сюда дописываются дескрипторы (без повторов)
+      */
+     void overlapping(int32_t from, int32_t to, std::vector<EventHandle>& out) const;
+
+     /**
+      * @brief Ближайшее мероприятие, начинающееся строго после момента
+      * @param seconds Момент, секунды от полуночи
+      * @param out Дескриптор найденного мероприятия
+      * @return false, если индекс пуст
+      *
+      * Если после момента в этих сутках ничего нет, возвращается самое
+      * раннее мероприятие (следующие сутки).
+      */
+     bool nextAfter(int32_t seconds, EventHandle& out) const;
+ };
+
+ #endif
@@ -4,26 +4,42 @@
  */
 
  #include "time.h"
+ #include "timevalue.h"
+ #include "datetime.h"
+ #include "schedulestore.h"
+ #include "conflicts.h"
+ #include "scheduleanalytics.h"
+ #include "schedulecommands.h"
+ #include "schedulefile.h"
+ #include "schedulejournal.h"
+ #include "scheduleio.h"
+ #include "tracing.h"
+ #include <chrono>
+ #include <cstring>
+ #include <fstream>
  #include <iostream>
  #include <limits>
  #include <vector>
  #include <string>
+ #include <unistd.h>
  
  using namespace std;
  
- struct Event {
-     string name;
-     Time startTime;
-     Time endTime;
-     Time plannedDuration;
-     Time actualDuration;
- };
- 
- Event** schedule = nullptr; // Указатель на массив указателей на мероприятия
- int scheduleSize = 0;       // Количество мероприятий
- int scheduleCapacity = 0;   // Вместимость массива
+ ScheduleStore schedule; // Мероприятия: столбцы секунд и буфер названий
+ ScheduleJournal journal(schedule); // Изменения из меню: отмена и повтор
+ string scheduleFile;    // Файл расписания из --file (пусто - только в памяти)
+ #ifdef SCHEDULE_TRACING
+ string traceFile;       // Трасса операций из --trace (формат chrome://tracing)
+ string traceStatsFile;  // Гистограммы задержек из --trace-stats (JSON)
+ #endif
  
  // Вспомогательные функции
+ // Очистка экрана управляющей последовательностью терминала - без запуска
+ // оболочки через system("clear") на каждом экране
+ void clearScreen() {
+     cout << "\033[H\033[2J\033[3J" << flush;
+ }
+ 
  void clearInputBuffer() {
      cin.clear();
      cin.ignore(numeric_limits<streamsize>::max(), '\n');
@@ -35,19 +51,40 @@
      cin.get();
  }
  
+ // Чтение времени "часы минуты секунды" или "Ч:ММ:СС" с проверкой
+ // (минуты и секунды меньше 60, значения неотрицательные). Как и прежний
+ // cin >> h >> m >> s, оставляет конец строки в потоке.
+ bool readTime(int& totalSeconds) {
+     string text;
+     cin >> text;
+     if (!cin.fail() && text.find(':') == string::npos) {
+         string minutes, seconds;
+         cin >> minutes >> seconds;
+         text += ' ';
+         text += minutes;
+         text += ' ';
+         text += seconds;
+     }
+     if (cin.fail() || Time::parse(text.data(), text.data() + text.size(), totalSeconds).error != TimeParseError::None) {
+         clearInputBuffer();
+         return false;
+     }
+     return true;
+ }
+ 
  // Выбор мероприятия
  int selectEvent(const string& prompt) {
-     if (scheduleSize == 0) {
+     if (schedule.empty()) {
          cout << "\nРасписание пусто! Создайте мероприятие в пункте 1.\n";
          return -1;
      }
      
      cout << prompt;
-     for (int i = 0; i < scheduleSize; i++) {
-         cout << i + 1 << ". " << schedule[i]->name << " (";
-         schedule[i]->startTime.print();
+     for (int i = 0; i < schedule.size(); i++) {
+         cout << i + 1 << ". " << schedule.name(i) << " (";
+         TimeValue::fromSeconds(schedule.start(i)).print();
          cout << " - ";
-         schedule[i]->endTime.print();
+         TimeValue::fromSeconds(schedule.end(i)).print();
          cout << ")" << endl;
      }
      
@@ -55,7 +92,7 @@
      cout << "Выберите (0 - отмена): ";
      cin >> choice;
      
-     if (cin.fail() || choice < 0 || choice > scheduleSize) {
+     if (cin.fail() || choice < 0 || choice > schedule.size()) {
          clearInputBuffer();
          cout << "Ошибка ввода!\n";
          return -1;
@@ -64,57 +101,57 @@
      return choice - 1;
  }
  
- // Обновление фактической длительности с учётом перехода через сутки
- void updateActualDuration(Event* event) {
-     int startSec = event->startTime.getTotalSeconds();
-     int endSec = event->endTime.getTotalSeconds();
-     int actualSec = endSec - startSec;
-     
-     // Если конец меньше начала (например, 23:00 → 04:00), добавляем сутки
-     if (actualSec < 0) {
-         actualSec += 24 * 3600; // 86400 секунд
+ // Вывод списка мероприятий по дескрипторам из индекса интервалов
+ void printEventList(const vector<EventHandle>& handles) {
+     for (EventHandle handle : handles) {
+         int i = schedule.indexOf(handle);
+         cout << i + 1 << ". " << schedule.name(i) << " (";
+         TimeValue::fromSeconds(schedule.start(i)).print();
+         cout << " - ";
+         TimeValue::fromSeconds(schedule.end(i)).print();
+         cout << ")" << endl;
      }
-     
-     event->actualDuration.setTime(0, 0, actualSec);
  }
  
- // Добавление мероприятия в расписание
- void addEventToSchedule(Event* newEvent) {
-     if (scheduleSize >= scheduleCapacity) {
-         // Увеличиваем capacity
-         int newCapacity = (scheduleCapacity == 0) ? 5 : scheduleCapacity * 2;
-         Event** newSchedule = new Event*[newCapacity];
-         
-         // Копируем существующие указатели
-         for (int i = 0; i < scheduleSize; i++) {
-             newSchedule[i] = schedule[i];
-         }
-         
-         // Освобождаем старый массив
-         if (schedule != nullptr) {
-             delete[] schedule;
-         }
-         
-         schedule = newSchedule;
-         scheduleCapacity = newCapacity;
-     }
-     
-     schedule[scheduleSize] = newEvent;
-     scheduleSize++;
+ // Обновление фактической длительности с учётом перехода через сутки
+ // (если конец меньше начала, например 23:00 → 04:00, добавляются сутки)
+ void updateActualDuration(int index) {
+     journal.setActual(index, actualDurationSeconds(schedule.start(index), schedule.end(index)));
+ }
+ 
+ // Запись времени начала из демонстраций операторов: вместе с фактической
+ // длительностью одним шагом журнала; неизменное время не записывается
+ void applyStart(int index, int seconds) {
+     if (schedule.start(index) == seconds) return;
+     journal.beginStep();
+     journal.setStart(index, seconds);
+     updateActualDuration(index);
+     journal.endStep();
  }
  
  // Пункт 1: Создание/изменение мероприятий
  void manageSchedule() {
      int choice;
+     // Буфер ввода названий: ёмкость сохраняется между добавлениями и
+     // правками, а setName пишет название на место прежнего
+     string nameInput;
      do {
-         system("clear");
+         clearScreen();
          cout << "=== СОЗДАНИЕ/ИЗМЕНЕНИЕ МЕРОПРИЯТИЙ ===\n\n";
-         cout << "Количество мероприятий: " << scheduleSize << endl << endl;
+         cout << "Количество мероприятий: " << schedule.size() << endl << endl;
          
          cout << "1. Добавить новое мероприятие\n";
          cout << "2. Редактировать мероприятие\n";
          cout << "3. Удалить мероприятие\n";
          cout << "4. Просмотреть все мероприятия\n";
+         cout << "5. Сохранить расписание в файл\n";
+         cout << "6. Загрузить расписание из файла\n";
+         cout << "7. Импорт из CSV/JSONL\n";
+         cout << "8. Экспорт в CSV/JSONL\n";
+         cout << "9. Повторение мероприятия\n";
+         cout << "10. Повторения за период\n";
+         cout << "11. Отменить последнее изменение" << (journal.canUndo() ? "" : " (нечего отменять)") << "\n";
+         cout << "12. Повторить отменённое" << (journal.canRedo() ? "" : " (нечего повторять)") << "\n";
          cout << "0. Назад\n";
          cout << "Выберите: ";
          cin >> choice;
@@ -128,40 +165,27 @@
          
          switch (choice) {
              case 1: {
-                 Event* newEvent = new Event;
                  cout << "\nВведите название мероприятия: ";
                  clearInputBuffer();
-                 getline(cin, newEvent->name);
+                 getline(cin, nameInput);
                  
-                 int h, m, s;
+                 int startSec, endSec, plannedSec;
                  cout << "Введите время начала (часы минуты секунды): ";
-                 cin >> h >> m >> s;
-                 if (cin.fail() || h < 0 || m < 0 || s < 0 || m >= 60 || s >= 60) {
+                 if (!readTime(startSec)) {
                      cout << "Ошибка ввода времени!\n";
-                     clearInputBuffer();
-                     delete newEvent; // Освобождаем память при ошибке
                  } else {
-                     newEvent->startTime.setTime(h, m, s);
-                     
                      cout << "Введите время окончания (часы минуты секунды): ";
-                     cin >> h >> m >> s;
-                     if (cin.fail() || h < 0 || m < 0 || s < 0 || m >= 60 || s >= 60) {
+                     if (!readTime(endSec)) {
                          cout << "Ошибка ввода времени!\n";
-                         clearInputBuffer();
-                         delete newEvent;
                      } else {
-                         newEvent->endTime.setTime(h, m, s);
-                         
                          cout << "Введите планируемую длительность (часы минуты секунды): ";
-                         cin >> h >> m >> s;
-                         if (cin.fail() || h < 0 || m < 0 || s < 0 || m >= 60 || s >= 60) {
+                         if (!readTime(plannedSec)) {
                              cout << "Ошибка ввода времени!\n";
-                             clearInputBuffer();
-                             delete newEvent;
                          } else {
-                             newEvent->plannedDuration.setTime(h, m, s);
-                             updateActualDuration(newEvent);
-                             addEventToSchedule(newEvent);
+                             {
+                                 TRACE_OPERATION(Add);
+                                 journal.add(nameInput, startSec, endSec, plannedSec);
+                             }
                              cout << "\nМероприятие успешно добавлено!\n";
                          }
                      }
@@ -173,28 +197,34 @@
                  int idx = selectEvent("\nВыберите мероприятие для редактирования:\n");
                  if (idx < 0) continue;
                  
-                 Event* event = schedule[idx];
-                 cout << "\nТекущее название: " << event->name << endl;
+                 cout << "\nТекущее название: " << schedule.name(idx) << endl;
                  cout << "Введите новое название (Enter - оставить): ";
                  clearInputBuffer();
-                 string newName;
-                 getline(cin, newName);
-                 if (!newName.empty()) event->name = newName;
+                 getline(cin, nameInput);
                  
-                 int h, m, s;
+                 // Сначала ввод, затем правка одним блоком: в замер правки
+                 // не попадает ожидание пользователя
+                 int startSec, endSec, plannedSec;
                  cout << "Введите новое время начала (часы минуты секунды): ";
-                 cin >> h >> m >> s;
-                 if (!cin.fail()) event->startTime.setTime(h, m, s);
+                 bool newStart = readTime(startSec);
                  
                  cout << "Введите новое время окончания (часы минуты секунды): ";
-                 cin >> h >> m >> s;
-                 if (!cin.fail()) event->endTime.setTime(h, m, s);
+                 bool newEnd = readTime(endSec);
                  
                  cout << "Введите новую план. длительность (часы минуты секунды): ";
-                 cin >> h >> m >> s;
-                 if (!cin.fail()) event->plannedDuration.setTime(h, m, s);
+                 bool newPlanned = readTime(plannedSec);
                  
-                 updateActualDuration(event);
+                 {
+                     TRACE_OPERATION(Edit);
+                     // Все поля - один шаг отмены
+                     journal.beginStep();
+                     if (!nameInput.empty()) journal.setName(idx, nameInput);
+                     if (newStart) journal.setStart(idx, startSec);
+                     if (newEnd) journal.setEnd(idx, endSec);
+                     if (newPlanned) journal.setPlanned(idx, plannedSec);
+                     updateActualDuration(idx);
+                     journal.endStep();
+                 }
                  cout << "\nМероприятие отредактировано!\n";
                  waitForEnter();
                  break;
@@ -202,36 +232,158 @@
              case 3: {
                  int idx = selectEvent("\nВыберите мероприятие для удаления:\n");
                  if (idx >= 0) {
-                     delete schedule[idx]; // Освобождаем память мероприятия
-                     
-                     // Сдвигаем оставшиеся указатели
-                     for (int i = idx; i < scheduleSize - 1; i++) {
-                         schedule[i] = schedule[i + 1];
+                     {
+                         TRACE_OPERATION(Delete);
+                         journal.remove(idx);
                      }
-                     scheduleSize--;
                      cout << "\nМероприятие удалено!\n";
                  }
                  waitForEnter();
                  break;
              }
              case 4: {
-                 if (scheduleSize == 0) {
+                 if (schedule.empty()) {
                      cout << "\nРасписание пусто!\n";
                  } else {
                      cout << "\n=== ПОЛНОЕ РАСПИСАНИЕ ===\n\n";
-                     for (int i = 0; i < scheduleSize; i++) {
-                         cout << i + 1 << ". " << schedule[i]->name << endl;
-                         cout << "   Начало: ";
-                         schedule[i]->startTime.print();
-                         cout << " | Конец: ";
-                         schedule[i]->endTime.print();
-                         cout << endl;
-                         cout << "   План: ";
-                         schedule[i]->plannedDuration.print();
-                         cout << " | Факт: ";
-                         schedule[i]->actualDuration.print();
-                         cout << endl << endl;
+                     TRACE_OPERATION(List);
+                     writeSchedule(schedule, cout);
+                 }
+                 waitForEnter();
+                 break;
+             }
+             case 5:
+             case 6: {
+                 string path;
+                 cout << "\nВведите путь к файлу";
+                 if (!scheduleFile.empty()) cout << " (Enter - " << scheduleFile << ")";
+                 cout << ": ";
+                 clearInputBuffer();
+                 getline(cin, path);
+                 if (path.empty()) path = scheduleFile;
+                 
+                 ScheduleFileError result = ScheduleFileError::OpenFailed;
+                 if (!path.empty() && choice == 5) {
+                     result = saveSchedule(schedule, path.c_str());
+                 } else if (!path.empty()) {
+                     // Прежнее расписание остаётся в журнале для отмены
+                     ScheduleStore loaded;
+                     result = loadSchedule(path.c_str(), loaded);
+                     if (result == ScheduleFileError::None) journal.replace(std::move(loaded));
+                 }
+                 if (result == ScheduleFileError::None) {
+                     cout << (choice == 5 ? "\nРасписание сохранено!\n" : "\nРасписание загружено!\n");
+                 } else {
+                     cout << "\nОшибка: " << scheduleFileErrorText(result) << endl;
+                 }
+                 waitForEnter();
+                 break;
+             }
+             case 7:
+             case 8: {
+                 string path;
+                 cout << "\nВведите путь к файлу (.csv или .jsonl): ";
+                 clearInputBuffer();
+                 getline(cin, path);
+                 
+                 ScheduleFormat format;
+                 if (!scheduleFormatFromPath(path, format)) {
+                     cout << "\nОшибка: ожидался файл .csv или .jsonl\n";
+                 } else if (choice == 8) {
+                     ofstream file(path, ios::binary);
+                     if (file) exportSchedule(schedule, format, file);
+                     cout << (file ? "\nРасписание экспортировано!\n" : "\nОшибка записи файла!\n");
+                     if (file && !schedule.recurrences().empty()) {
+                         cout << "Внимание: правила повторения (" << schedule.recurrences().size()
+                              << ") не входят в CSV и JSON Lines, их сохраняет только пункт 5\n";
+                     }
+                 } else {
+                     ifstream file(path, ios::binary);
+                     if (!file) {
+                         cout << "\nОшибка: не удалось открыть файл\n";
+                     } else {
+                         const size_t shownErrors = 20;
+                         vector<ImportError> errors;
+                         // Импорт в отдельное хранилище и добавление одним шагом журнала;
+                         // фактическую длительность add вычисляет так же, как импорт
+                         ScheduleStore imported;
+                         ImportStats stats = importSchedule(file, format, imported, &errors, shownErrors);
+                         journal.beginStep();
+                         for (int i = 0; i < imported.size(); i++) {
+                             journal.add(imported.name(i), imported.start(i), imported.end(i), imported.planned(i));
+                         }
+                         journal.endStep();
+                         cout << "\nПринято мероприятий: " << stats.imported
+                              << ", отклонено строк: " << stats.rejected << endl;
+                         for (const ImportError& e : errors) {
+                             cout << "  строка " << e.line << ": " << e.message << endl;
+                         }
+                         if (stats.rejected > errors.size()) cout << "  ...\n";
+                     }
+                 }
+                 waitForEnter();
+                 break;
+             }
+             case 9: {
+                 int idx = selectEvent("\nВыберите мероприятие:\n");
+                 if (idx < 0) continue;
+                 
+                 cout << "\nПравило: вид (minutes, daily, weekly), шаг, первый день ГГГГ-ММ-ДД,\n"
+                      << "для weekly - дни недели цифрами (1 - понедельник), until ГГГГ-ММ-ДД - конец серии.\n"
+                      << "Например: weekly 1 2026-10-19 135 until 2026-12-31\n";
+                 cout << (schedule.recurrence(idx) ? "Мероприятие повторяется. " : "Мероприятие разовое. ");
+                 cout << "Введите правило (off - не повторять, Enter - оставить): ";
+                 clearInputBuffer();
+                 getline(cin, nameInput);
+                 
+                 RecurrenceRule rule;
+                 string error;
+                 if (nameInput.empty()) {
+                     cout << "\nПовторение не изменено.\n";
+                 } else if (nameInput == "off") {
+                     journal.clearRecurrence(idx);
+                     cout << "\nМероприятие больше не повторяется.\n";
+                 } else if (!parseRecurrenceRule(nameInput, rule, error)) {
+                     cout << "\nОшибка: " << error << endl;
+                 } else {
+                     {
+                         TRACE_OPERATION(Edit);
+                         journal.setRecurrence(idx, rule);
                      }
+                     cout << "\nПовторение задано!\n";
+                 }
+                 waitForEnter();
+                 break;
+             }
+             case 10: {
+                 if (schedule.recurrences().empty()) {
+                     cout << "\nНет повторяющихся мероприятий (пункт 9).\n";
+                     waitForEnter();
+                     break;
+                 }
+                 string date;
+                 int days;
+                 int32_t day;
+                 cout << "\nВведите первый день (ГГГГ-ММ-ДД) и число дней: ";
+                 cin >> date >> days;
+                 if (cin.fail() || days <= 0 || !parseDate(date, day)) {
+                     clearInputBuffer();
+                     cout << "Ошибка ввода!\n";
+                 } else {
+                     cout << endl;
+                     TRACE_OPERATION(Report);
+                     writeOccurrences(schedule, DateTime(day, 0), DateTime(day, int64_t(days) * DateTime::secondsPerDay), cout);
+                 }
+                 waitForEnter();
+                 break;
+             }
+             case 11:
+             case 12: {
+                 bool done = choice == 11 ? journal.undo() : journal.redo();
+                 if (!done) {
+                     cout << (choice == 11 ? "\nНечего отменять.\n" : "\nНечего повторять.\n");
+                 } else {
+                     cout << (choice == 11 ? "\nИзменение отменено!\n" : "\nИзменение повторено!\n");
                  }
                  waitForEnter();
                  break;
@@ -251,13 +403,15 @@
      int idx = selectEvent("\nВыберите мероприятие для демонстрации унарных операторов:\n");
      if (idx < 0) return;
      
+     Time temp; // Рабочая копия времени начала, записывается обратно после операции
      int operatorChoice;
      do {
-         system("clear");
+         clearScreen();
+         temp.setTime(0, 0, schedule.start(idx));
          cout << "=== ДЕМОНСТРАЦИЯ УНАРНЫХ ОПЕРАТОРОВ ===\n\n";
-         cout << "Мероприятие: " << schedule[idx]->name << endl;
+         cout << "Мероприятие: " << schedule.name(idx) << endl;
          cout << "Время начала: ";
-         schedule[idx]->startTime.print();
+         temp.print();
          cout << endl << endl;
          
          cout << "Выберите оператор:\n";
@@ -276,8 +430,6 @@
              continue;
          }
          
-         Time& temp = schedule[idx]->startTime; 
-         
          switch (operatorChoice) {
              case 1:
                  cout << "\nПрефиксный инкремент:\n";
@@ -322,6 +474,7 @@
                  waitForEnter();
                  break;
          }
+         applyStart(idx, temp.getTotalSeconds());
      } while (operatorChoice != 0);
  }
  
@@ -329,13 +482,15 @@
      int idx = selectEvent("\nВыберите мероприятие:\n");
      if (idx < 0) return;
      
+     Time start; // Рабочая копия времени начала, записывается обратно после операции
      int choice;
      do {
-         system("clear");
+         clearScreen();
+         start.setTime(0, 0, schedule.start(idx));
          cout << "=== АРИФМЕТИЧЕСКОЕ ПРИСВАИВАНИЕ ===\n\n";
-         cout << "Мероприятие: " << schedule[idx]->name << endl;
+         cout << "Мероприятие: " << schedule.name(idx) << endl;
          cout << "Время начала: ";
-         schedule[idx]->startTime.print();
+         start.print();
          cout << endl << endl;
          
          cout << "Выберите операцию:\n";
@@ -356,42 +511,38 @@
          
          switch (choice) {
              case 1: {
-                 int h, m, s;
+                 int seconds;
                  cout << "Введите время для прибавления (часы минуты секунды): ";
-                 cin >> h >> m >> s;
-                 if (cin.fail() || h < 0 || m < 0 || s < 0 || m >= 60 || s >= 60) {
+                 if (!readTime(seconds)) {
                      cout << "Ошибка ввода!\n";
-                     clearInputBuffer();
                  } else {
-                     Time delta(h, m, s);
+                     Time delta(0, 0, seconds);
                      cout << "\nДо: ";
-                     schedule[idx]->startTime.print();
-                     schedule[idx]->startTime += delta;
+                     start.print();
+                     start += delta;
                      cout << "\nПосле += ";
                      delta.print();
                      cout << ": ";
-                     schedule[idx]->startTime.print();
+                     start.print();
                      cout << endl;
                  }
                  waitForEnter();
                  break;
              }
              case 2: {
-                 int h, m, s;
+                 int seconds;
                  cout << "Введите время для вычитания (часы минуты секунды): ";
-                 cin >> h >> m >> s;
-                 if (cin.fail() || h < 0 || m < 0 || s < 0 || m >= 60 || s >= 60) {
+                 if (!readTime(seconds)) {
                      cout << "Ошибка ввода!\n";
-                     clearInputBuffer();
                  } else {
-                     Time delta(h, m, s);
+                     Time delta(0, 0, seconds);
                      cout << "\nДо: ";
-                     schedule[idx]->startTime.print();
-                     schedule[idx]->startTime -= delta;
+                     start.print();
+                     start -= delta;
                      cout << "\nПосле -= ";
                      delta.print();
                      cout << ": ";
-                     schedule[idx]->startTime.print();
+                     start.print();
                      cout << endl;
                  }
                  waitForEnter();
@@ -406,10 +557,10 @@
                      clearInputBuffer();
                  } else {
                      cout << "\nДо: ";
-                     schedule[idx]->startTime.print();
-                     schedule[idx]->startTime *= scalar;
+                     start.print();
+                     start *= scalar;
                      cout << "\nПосле *= " << scalar << ": ";
-                     schedule[idx]->startTime.print();
+                     start.print();
                      cout << endl;
                  }
                  waitForEnter();
@@ -426,10 +577,10 @@
                      cout << "Ошибка: деление на ноль!\n";
                  } else {
                      cout << "\nДо: ";
-                     schedule[idx]->startTime.print();
-                     schedule[idx]->startTime /= scalar;
+                     start.print();
+                     start /= scalar;
                      cout << "\nПосле /= " << scalar << ": ";
-                     schedule[idx]->startTime.print();
+                     start.print();
                      cout << endl;
                  }
                  waitForEnter();
@@ -442,6 +593,7 @@
                  waitForEnter();
                  break;
          }
+         applyStart(idx, start.getTotalSeconds());
      } while (choice != 0);
  }
  
@@ -452,15 +604,17 @@
      int idx2 = selectEvent("\nВыберите второе мероприятие:\n");
      if (idx2 < 0) return;
      
+     Time time1(0, 0, schedule.start(idx1));
+     Time time2(0, 0, schedule.start(idx2));
      int choice;
      do {
-         system("clear");
+         clearScreen();
          cout << "=== БИНАРНЫЕ ОПЕРАТОРЫ ===\n\n";
-         cout << schedule[idx1]->name << " (начало): ";
-         schedule[idx1]->startTime.print();
+         cout << schedule.name(idx1) << " (начало): ";
+         time1.print();
          cout << endl;
-         cout << schedule[idx2]->name << " (начало): ";
-         schedule[idx2]->startTime.print();
+         cout << schedule.name(idx2) << " (начало): ";
+         time2.print();
          cout << endl << endl;
          
          cout << "Выберите операцию:\n";
@@ -481,7 +635,7 @@
          
          switch (choice) {
              case 1: {
-                 Time result = schedule[idx1]->startTime + schedule[idx2]->startTime;
+                 Time result = time1 + time2;
                  cout << "\nРезультат сложения: ";
                  result.print();
                  cout << endl;
@@ -489,7 +643,7 @@
                  break;
              }
              case 2: {
-                 Time result = schedule[idx1]->startTime - schedule[idx2]->startTime;
+                 Time result = time1 - time2;
                  cout << "\nРезультат вычитания: ";
                  result.print();
                  cout << endl;
@@ -504,7 +658,7 @@
                      cout << "Ошибка ввода!\n";
                      clearInputBuffer();
                  } else {
-                     Time result = schedule[idx1]->startTime * scalar;
+                     Time result = time1 * scalar;
                      cout << "\nРезультат умножения: ";
                      result.print();
                      cout << endl;
@@ -522,7 +676,7 @@
                  } else if (scalar == 0) {
                      cout << "Ошибка: деление на ноль!\n";
                  } else {
-                     Time result = schedule[idx1]->startTime / scalar;
+                     Time result = time1 / scalar;
                      cout << "\nРезультат деления: ";
                      result.print();
                      cout << endl;
@@ -547,23 +701,26 @@
      int idx2 = selectEvent("\nВыберите второе мероприятие:\n");
      if (idx2 < 0) return;
      
-     system("clear");
+     Time time1(0, 0, schedule.start(idx1));
+     Time time2(0, 0, schedule.start(idx2));
+     
+     clearScreen();
      cout << "=== ОПЕРАТОРЫ СРАВНЕНИЯ ===\n\n";
      
-     cout << schedule[idx1]->name << " (начало): ";
-     schedule[idx1]->startTime.print();
+     cout << schedule.name(idx1) << " (начало): ";
+     time1.print();
      cout << endl;
-     cout << schedule[idx2]->name << " (начало): ";
-     schedule[idx2]->startTime.print();
+     cout << schedule.name(idx2) << " (начало): ";
+     time2.print();
      cout << endl << endl;
      
      cout << "Результаты сравнения:\n";
-     cout << "time1 < time2:  " << (schedule[idx1]->startTime < schedule[idx2]->startTime ? "true" : "false") << endl;
-     cout << "time1 > time2:  " << (schedule[idx1]->startTime > schedule[idx2]->startTime ? "true" : "false") << endl;
-     cout << "time1 <= time2: " << (schedule[idx1]->startTime <= schedule[idx2]->startTime ? "true" : "false") << endl;
-     cout << "time1 >= time2: " << (schedule[idx1]->startTime >= schedule[idx2]->startTime ? "true" : "false") << endl;
-     cout << "time1 == time2: " << (schedule[idx1]->startTime == schedule[idx2]->startTime ? "true" : "false") << endl;
-     cout << "time1 != time2: " << (schedule[idx1]->startTime != schedule[idx2]->startTime ? "true" : "false") << endl;
+     cout << "time1 < time2:  " << (time1 < time2 ? "true" : "false") << endl;
+     cout << "time1 > time2:  " << (time1 > time2 ? "true" : "false") << endl;
+     cout << "time1 <= time2: " << (time1 <= time2 ? "true" : "false") << endl;
+     cout << "time1 >= time2: " << (time1 >= time2 ? "true" : "false") << endl;
+     cout << "time1 == time2: " << (time1 == time2 ? "true" : "false") << endl;
+     cout << "time1 != time2: " << (time1 != time2 ? "true" : "false") << endl;
      
      waitForEnter();
  }
@@ -571,11 +728,14 @@
  void demonstrateScheduleAndStatic() {
      int choice;
      do {
-         system("clear");
+         clearScreen();
          cout << "=== РАСПИСАНИЕ И СТАТИСТИКА ===\n\n";
-         cout << "1. Вывести полное расписание\n";
+         cout << "1. Итоги план/факт и полное расписание\n";
          cout << "2. Статистика программы\n";
          cout << "3. Посчитать интервал между мероприятиями\n";
+         cout << "4. Мероприятия в заданное время\n";
+         cout << "5. Мероприятия в промежутке времени\n";
+         cout << "6. Проверить пересечения и короткие перерывы\n";
          cout << "0. Назад\n";
          cout << "Выберите: ";
          cin >> choice;
@@ -589,30 +749,48 @@
          
          switch (choice) {
              case 1: {
-                 if (scheduleSize == 0) {
+                 if (schedule.empty()) {
                      cout << "\nРасписание пусто!\n";
                  } else {
-                     cout << "\n=== ПОЛНОЕ РАСПИСАНИЕ ===\n\n";
-                     for (int i = 0; i < scheduleSize; i++) {
-                         cout << i + 1 << ". " << schedule[i]->name << endl;
+                     // Сводка считается по столбцам; вывод по мероприятиям - по запросу
+                     ScheduleStatsOptions options;
+                     cout << "\n=== ИТОГИ ПЛАН/ФАКТ ===\n\n";
+                     {
+                         TRACE_OPERATION(Report);
+                         writeScheduleStats(schedule, analyzeSchedule(schedule, options), options, cout);
+                     }
+                     
+                     int details = 0;
+                     cout << "\nВывести каждое мероприятие? (1 - да, 0 - нет): ";
+                     cin >> details;
+                     if (cin.fail()) {
+                         clearInputBuffer();
+                         details = 0;
+                     }
+                     if (details == 1) cout << "\n=== ПОЛНОЕ РАСПИСАНИЕ ===\n\n";
+                     for (int i = 0; details == 1 && i < schedule.size(); i++) {
+                         TimeValue actual = TimeValue::fromSeconds(schedule.actual(i));
+                         TimeValue planned = TimeValue::fromSeconds(schedule.planned(i));
+                         
+                         cout << i + 1 << ". " << schedule.name(i) << endl;
                          cout << "   Начало: ";
-                         schedule[i]->startTime.print();
+                         TimeValue::fromSeconds(schedule.start(i)).print();
                          cout << " | Конец: ";
-                         schedule[i]->endTime.print();
+                         TimeValue::fromSeconds(schedule.end(i)).print();
                          cout << endl;
                          cout << "   План: ";
-                         schedule[i]->plannedDuration.print();
+                         planned.print();
                          cout << " | Факт: ";
-                         schedule[i]->actualDuration.print();
+                         actual.print();
                          cout << endl;
                          
-                         Time diff = schedule[i]->actualDuration - schedule[i]->plannedDuration;
+                         TimeValue diff = actual - planned;
                          cout << "   Разница: ";
                          diff.print();
                          cout << " (";
-                         if (schedule[i]->actualDuration > schedule[i]->plannedDuration) 
+                         if (actual > planned) 
                              cout << "опоздание";
-                         else if (schedule[i]->actualDuration < schedule[i]->plannedDuration)
+                         else if (actual < planned)
                              cout << "ускорение";
                          else
                              cout << "точно";
@@ -623,10 +801,16 @@
                  break;
              }
              case 2: {
-                 system("clear");
+                 clearScreen();
                  cout << "=== СТАТИСТИКА ===\n\n";
-                 cout << "Всего мероприятий: " << scheduleSize << endl;
+                 {
+                     TRACE_OPERATION(Report);
+                     writeTotals(schedule, cout);
+                 }
                  cout << "Всего операций с Time: " << Time::getOperationCount() << endl;
+ #ifdef SCHEDULE_TRACING
+                 writeTraceSummary(cout);
+ #endif
                  waitForEnter();
                  break;
              }
@@ -638,24 +822,102 @@
                  if (idx2 < 0) break;
                  
                  cout << "\nИнтервал между мероприятиями:\n";
-                 cout << "Конец \"" << schedule[idx1]->name << "\": ";
-                 schedule[idx1]->endTime.print();
+                 TimeValue end1 = TimeValue::fromSeconds(schedule.end(idx1));
+                 TimeValue start2 = TimeValue::fromSeconds(schedule.start(idx2));
+                 
+                 cout << "Конец \"" << schedule.name(idx1) << "\": ";
+                 end1.print();
                  cout << endl;
-                 cout << "Начало \"" << schedule[idx2]->name << "\": ";
-                 schedule[idx2]->startTime.print();
+                 cout << "Начало \"" << schedule.name(idx2) << "\": ";
+                 start2.print();
                  cout << endl;
                  
-                 Time interval = schedule[idx2]->startTime - schedule[idx1]->endTime;
-                 if (interval.getTotalSeconds() < 0) {
-                     interval += Time(24, 0, 0); 
-                 }
+                 // Начало второго - ближайшее после конца первого, при
+                 // необходимости на следующий день
+                 DateTime afterFirst(0, schedule.end(idx1));
+                 TimeSpan64 interval = afterFirst.nextAt(schedule.start(idx2)) - afterFirst;
                  
                  cout << "Интервал: ";
-                 interval.print();
+                 TimeValue::fromSeconds(static_cast<int>(interval.totalSeconds())).print();
                  cout << endl;
                  waitForEnter();
                  break;
              }
+             case 4: {
+                 int moment;
+                 cout << "Введите время (часы минуты секунды): ";
+                 if (!readTime(moment)) {
+                     cout << "Ошибка ввода времени!\n";
+                 } else {
+                     vector<EventHandle> found;
+                     schedule.intervals().activeAt(moment, found);
+                     
+                     if (found.empty()) {
+                         cout << "\nВ это время мероприятий нет.\n";
+                     } else {
+                         cout << "\nИдут в это время:\n";
+                         printEventList(found);
+                     }
+                     
+                     EventHandle next;
+                     if (schedule.intervals().nextAfter(moment, next)) {
+                         found.assign(1, next);
+                         cout << "\nСледующее мероприятие:\n";
+                         printEventList(found);
+                     }
+                 }
+                 waitForEnter();
+                 break;
+             }
+             case 5: {
+                 int from, to;
+                 cout << "Введите начало промежутка (часы минуты секунды): ";
+                 if (!readTime(from)) {
+                     cout << "Ошибка ввода времени!\n";
+                 } else {
+                     cout << "Введите конец промежутка (часы минуты секунды): ";
+                     if (!readTime(to)) {
+                         cout << "Ошибка ввода времени!\n";
+                     } else {
+                         vector<EventHandle> found;
+                         schedule.intervals().overlapping(from, to, found);
+                         
+                         if (found.empty()) {
+                             cout << "\nВ этом промежутке мероприятий нет.\n";
+                         } else {
+                             cout << "\nПересекаются с промежутком:\n";
+                             printEventList(found);
+                         }
+                     }
+                 }
+                 waitForEnter();
+                 break;
+             }
+             case 6: {
+                 ConflictOptions options;
+                 cout << "Введите минимальный перерыв (часы минуты секунды): ";
+                 if (!readTime(options.minGapSeconds)) {
+                     cout << "Ошибка ввода времени!\n";
+                 } else {
+                     TRACE_OPERATION(Report);
+                     ConflictReport report = findConflicts(schedule, options);
+                     
+                     cout << "\nПересечений: " << report.overlaps.size() << endl;
+                     for (const EventConflict& c : report.overlaps) {
+                         cout << "  \"" << schedule.name(c.first) << "\" и \"" << schedule.name(c.second) << "\": ";
+                         TimeValue::fromSeconds(c.overlapSeconds).print();
+                         cout << endl;
+                     }
+                     cout << "Коротких перерывов: " << report.shortGaps.size() << endl;
+                     for (const ScheduleGap& g : report.shortGaps) {
+                         cout << "  после \"" << schedule.name(g.before) << "\" до \"" << schedule.name(g.after) << "\": ";
+                         TimeValue::fromSeconds(g.gapSeconds).print();
+                         cout << endl;
+                     }
+                 }
+                 waitForEnter();
+                 break;
+             }
              case 0:
                  break;
              default:
@@ -666,20 +928,159 @@
      } while (choice != 0);
  }
  
+ // Запись расписания обратно в файл из --file при выходе
+ bool saveScheduleFile() {
+     if (scheduleFile.empty()) return true;
+     ScheduleFileError result = saveSchedule(schedule, scheduleFile.c_str());
+     if (result == ScheduleFileError::None) return true;
+     cerr << scheduleFile << ": " << scheduleFileErrorText(result) << endl;
+     return false;
+ }
+ 
  void cleanupSchedule() {
-     for (int i = 0; i < scheduleSize; i++) {
-         delete schedule[i];
+     schedule.clear();
+ }
+ 
+ #ifdef SCHEDULE_TRACING
+ // Запись замеров из --trace и --trace-stats при выходе
+ bool saveTraceFiles() {
+     bool ok = true;
+     if (!traceFile.empty()) {
+         ofstream file(traceFile, ios::binary);
+         writeTraceChrome(file);
+         if (!file) {
+             cerr << "Ошибка записи " << traceFile << endl;
+             ok = false;
+         }
+     }
+     if (!traceStatsFile.empty()) {
+         ofstream file(traceStatsFile, ios::binary);
+         writeTraceJson(file);
+         if (!file) {
+             cerr << "Ошибка записи " << traceStatsFile << endl;
+             ok = false;
+         }
+     }
+     return ok;
+ }
+ #endif
+ 
+ // Пакетный режим: команды из файла или стандартного ввода, без меню,
+ // очистки экрана и ожидания Enter. Итог и ошибки выводятся в cerr.
+ int runScript(const char* path, bool quiet) {
+     ifstream file;
+     istream* in = &cin;
+     if (strcmp(path, "-") != 0) {
+         file.open(path, ios::binary);
+         if (!file) {
+             cerr << "Не удалось открыть сценарий: " << path << endl;
+             return 2;
+         }
+         in = &file;
      }
-     if (schedule != nullptr) {
-         delete[] schedule;
+     
+     ofstream discard; // Не открыт: вывод отчётов отбрасывается
+     ostream& out = quiet ? static_cast<ostream&>(discard) : cout;
+     vector<CommandError> errors;
+     
+     auto start = chrono::steady_clock::now();
+     CommandStats stats = runCommandStream(schedule, *in, out, &errors);
+     double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+     out << flush;
+     
+     for (const CommandError& e : errors) {
+         cerr << "Строка " << e.line << ": " << e.message << endl;
      }
+     cerr << "Команд: " << stats.commands << ", ошибок: " << stats.errors
+          << ", мероприятий: " << schedule.size() << ", время: " << seconds << " с";
+     if (seconds > 0) cerr << " (" << static_cast<long long>(stats.commands / seconds) << " команд/с)";
+     cerr << endl;
+     return stats.errors == 0 ? 0 : 1;
  }
  
- int main() {
+ // Перевод между CSV и JSONL потоком, без загрузки мероприятий в память
+ int runConvert(const char* from, const char* to) {
+     ScheduleFormat inFormat, outFormat;
+     if (!scheduleFormatFromPath(from, inFormat) || !scheduleFormatFromPath(to, outFormat)) {
+         cerr << "Ожидались файлы .csv или .jsonl" << endl;
+         return 2;
+     }
+     ifstream in(from, ios::binary);
+     if (!in) {
+         cerr << "Не удалось открыть " << from << endl;
+         return 2;
+     }
+     ofstream out(to, ios::binary);
+     vector<ImportError> errors;
+     ImportStats stats = convertSchedule(in, inFormat, out, outFormat, &errors);
+     out.close();
+     if (!out) {
+         cerr << "Ошибка записи " << to << endl;
+         return 2;
+     }
+     for (const ImportError& e : errors) {
+         cerr << "Строка " << e.line << ": " << e.message << endl;
+     }
+     cerr << "Записей: " << stats.records << ", принято: " << stats.imported
+          << ", отклонено: " << stats.rejected << endl;
+     return stats.rejected == 0 ? 0 : 1;
+ }
+ 
+ int main(int argc, char* argv[]) {
+     const char* script = nullptr;
+     const char* convertFrom = nullptr;
+     const char* convertTo = nullptr;
+     bool quiet = false;
+     for (int i = 1; i < argc; i++) {
+         if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+             script = argv[++i];
+         } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+             scheduleFile = argv[++i];
+         } else if (strcmp(argv[i], "--convert") == 0 && i + 2 < argc) {
+             convertFrom = argv[++i];
+             convertTo = argv[++i];
+         } else if (strcmp(argv[i], "--quiet") == 0) {
+             quiet = true;
+ #ifdef SCHEDULE_TRACING
+         } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+             traceFile = argv[++i];
+         } else if (strcmp(argv[i], "--trace-stats") == 0 && i + 1 < argc) {
+             traceStatsFile = argv[++i];
+ #endif
+         } else {
+             cerr << "Использование: " << argv[0] << " [--file <расписание>] [--script <файл>|-] [--quiet]"
+ #ifdef SCHEDULE_TRACING
+                  << " [--trace <трасса.json>] [--trace-stats <замеры.json>]"
+ #endif
+                  << "\n"
+                  << "       " << argv[0] << " --convert <вход.csv|.jsonl> <выход.csv|.jsonl>" << endl;
+             return 2;
+         }
+     }
+     if (convertFrom) return runConvert(convertFrom, convertTo);
+     
+     // Расписание из файла; отсутствующий файл - новое пустое расписание
+     if (!scheduleFile.empty() && access(scheduleFile.c_str(), F_OK) == 0) {
+         ScheduleFileError result = loadSchedule(scheduleFile.c_str(), schedule);
+         if (result != ScheduleFileError::None) {
+             cerr << scheduleFile << ": " << scheduleFileErrorText(result) << endl;
+             return 2;
+         }
+     }
+     if (script) {
+         int status = runScript(script, quiet);
+         if (!saveScheduleFile()) status = 2;
+ #ifdef SCHEDULE_TRACING
+         if (!saveTraceFiles()) status = 2;
+ #endif
+         cleanupSchedule();
+         return status;
+     }
+     
      int choice;
      
      do {
-         system("clear");
+         clearScreen();
          cout << "=== ПРОГРАММА \"РАСПИСАНИЕ НА ДЕНЬ\" ===\n";
          cout << "1. Создать/изменить мероприятия\n";
          cout << "2. Демонстрация унарных операторов\n";
@@ -727,7 +1128,11 @@
          }
      } while (choice != 0);
      
+     int status = saveScheduleFile() ? 0 : 2;
+ #ifdef SCHEDULE_TRACING
+     if (!saveTraceFiles()) status = 2;
+ #endif
      cleanupSchedule();
      
-     return 0;
- }
\ No newline at end of file
+     return status;
+ }
@@ -0,0 +1,89 @@
+/**
+ * @file namearena.cpp
+ * @brief Реализация буфера названий
+ */
+
+ #include "namearena.h"
+ #include <cstring>
+ #include <string>
+ #include <utility>
+
+ using namespace std;
+
+ uint32_t NameArena::allocate(size_t size) {
+     uint32_t block = blockSize(size);
+     if (block > 0 && block <= maxPooledSize) {
+         uint32_t& head = freeHeads_[block / granule - 1];
+         if (head != nil) {
+             // Следующий свободный блок записан в начале текущего
+             uint32_t offset = head;
+             memcpy(&head, data_.data() + offset, sizeof(head));
+             freeBytes_ -= block;
+             return offset;
+         }
+     }
+     uint32_t offset = static_cast<uint32_t>(data_.size());
+     data_.resize(data_.size() + block);
+     return offset;
+ }
+
+ uint32_t NameArena::store(string_view text) {
+     if (!data_.empty() && text.data() >= data_.data() && text.data() < data_.data() + data_.size()) {
+         // Название из этого же буфера: выделение может его переместить
+         string copy(text);
+         return store(copy);
+     }
+     uint32_t offset = allocate(text.size());
+     if (!text.empty()) memcpy(data_.data() + offset, text.data(), text.size());
+     return offset;
+ }
+
+ void NameArena::release(uint32_t offset, size_t size) {
+     if (size == 0) return;
+     if (offset < packedEnd_) {
+         garbageBytes_ += size;
+         return;
+     }
+     uint32_t block = blockSize(size);
+     if (block > maxPooledSize) {
+         garbageBytes_ += block;
+         return;
+     }
+     uint32_t& head = freeHeads_[block / granule - 1];
+     memcpy(data_.data() + offset, &head, sizeof(head));
+     head = offset;
+     freeBytes_ += block;
+ }
+
+ void NameArena::shrink(uint32_t offset, size_t oldSize, size_t newSize) {
+     if (offset < packedEnd_) {
+         garbageBytes_ += oldSize - newSize;
+         return;
+     }
+     uint32_t oldBlock = blockSize(oldSize);
+     uint32_t newBlock = blockSize(newSize);
+     if (oldBlock > newBlock) release(offset + newBlock, oldBlock - newBlock);
+ }
+
+ void NameArena::assignPacked(const char* text, size_t size, size_t liveBytes) {
+     clear();
+     data_.assign(text, text + size);
+     packedEnd_ = size;
+     garbageBytes_ = size - liveBytes;
+ }
+
+ void NameArena::clear() {
+     data_.clear();
+     for (uint32_t& head : freeHeads_) head = nil;
+     freeBytes_ = 0;
+     garbageBytes_ = 0;
+     packedEnd_ = 0;
+ }
+
+ void NameArena::swap(NameArena& other) noexcept {
+     data_.swap(other.data_);
+     for (uint32_t c = 0; c < classCount; c++) std::swap(freeHeads_[c], other.freeHeads_[c]);
+     std::swap(freeBytes_, other.freeBytes_);
+     std::swap(garbageBytes_, other.garbageBytes_);
+     std::swap(packedEnd_, other.packedEnd_);
+ }
@@ -0,0 +1,123 @@
+/**
+ * @file namearena.h
+ * @brief Буфер названий мероприятий с повторным использованием освобождённых блоков
+ */
+
+ #ifndef NAMEARENA_H
+ #define NAMEARENA_H
+
+ #include <cstddef>
+ #include <cstdint>
+ #include <string_view>
+ #include <vector>
+
+ /**
+  * @class NameArena
+  * @brief Непрерывный буфер символов: выделение сдвигом конца и списки свободных блоков
+  *
+  * Названия адресуются смещением, поэтому рост буфера не портит ссылки.
+  * Блоки выделяются кратно granule байтам; освобождённый блок до
+  * maxPooledSize байт попадает в список своего размера и отдаётся
+  * следующему названию той же длины, так что частые добавления и
+  * удаления не растят буфер. Более длинные блоки и названия, загруженные
+  * плотно (assignPacked), при освобождении становятся мусором до
+  * уплотнения, которое выполняет владелец. clear() освобождает всё за O(1).
+  */
+ class NameArena {
+ public:
+     static constexpr uint32_t granule = 8;          ///< Кратность размера блока
+     static constexpr uint32_t maxPooledSize = 256;  ///< Наибольший блок в списках свободных
+
+ private:
+     static constexpr uint32_t classCount = maxPooledSize / granule;
+     static constexpr uint32_t nil = UINT32_MAX;
+
+     std::vector<char> data_;                 ///< Символы всех блоков
+     uint32_t freeHeads_[classCount];         ///< Первый свободный блок каждого размера
+     size_t freeBytes_ = 0;                   ///< Байты в списках свободных
+     size_t garbageBytes_ = 0;                ///< Байты, которые нельзя выделить до уплотнения
+     size_t packedEnd_ = 0;                   ///< Конец плотно загруженной части
+
+     static uint32_t blockSize(size_t size) {
+         return static_cast<uint32_t>((size + granule - 1) / granule * granule);
+     }
+
+ public:
+     NameArena() { clear(); }
+
+     /**
+      * @brief Выделить место под название
+      * @param size Длина названия
+      * @return Смещение блока
+      */
+     uint32_t allocate(size_t size);
+
+     /**
+      * @brief Выделить место и скопировать название
+      * @param text Название (может лежать в этом же буфере)
+      * @return Смещение блока
+      */
+     uint32_t store(std::string_view text);
+
+     /**
+      * @brief Вернуть блок названия длины size
+      */
+     void release(uint32_t offset, size_t size);
+
+     /**
+      * @brief Поместится ли новое название в блок прежнего
+      */
+     bool fitsInPlace(uint32_t offset, size_t oldSize, size_t newSize) const {
+         return newSize <= oldSize || (offset >= packedEnd_ && blockSize(newSize) <= blockSize(oldSize));
+     }
+
+     /**
+      * @brief Занимают ли названия длины a и b блоки одного размера
+      */
+     static bool sameBlock(size_t a, size_t b) { return blockSize(a) == blockSize(b); }
+
+     /**
+      * @brief Есть ли в списках свободных блок под название длины size
+      */
+     bool hasPooled(size_t size) const {
+         uint32_t block = blockSize(size);
+         return block > 0 && block <= maxPooledSize && freeHeads_[block / granule - 1] != nil;
+     }
+
+     /**
+      * @brief Укоротить название на месте, вернув лишние гранулы
+      */
+     void shrink(uint32_t offset, size_t oldSize, size_t newSize);
+
+     /**
+      * @brief Заменить содержимое плотно уложенными названиями (загрузка из файла)
+      * @param text Символы
+      * @param size Размер
+      * @param liveBytes Сколько из них принадлежит названиям
+      */
+     void assignPacked(const char* text, size_t size, size_t liveBytes);
+
+     /**
+      * @brief Освободить всё (O(1), ёмкость буфера сохраняется)
+      */
+     void clear();
+
+     /**
+      * @brief Зарезервировать место под size байт
+      */
+     void reserve(size_t size) { data_.reserve(size); }
+
+     /**
+      * @brief Обменяться содержимым с другим буфером
+      */
+     void swap(NameArena& other) noexcept;
+
+     char* data() { return data_.data(); }                        ///< Начало буфера
+     const char* data() const { return data_.data(); }            ///< Начало буфера
+     size_t size() const { return data_.size(); }                 ///< Занятый размер
+     size_t capacity() const { return data_.capacity(); }         ///< Ёмкость
+     size_t unusedBytes() const { return freeBytes_ + garbageBytes_; } ///< Байты не под названиями
+     size_t garbageBytes() const { return garbageBytes_; }        ///< Байты, ждущие уплотнения
+ };
+
+ #endif
@@ -0,0 +1,85 @@
+/**
+ * @file parallel.h
+ * @brief Простейшие параллельные циклы и сортировка на std::thread
+ */
+
+ #ifndef PARALLEL_H
+ #define PARALLEL_H
+
+ #include <algorithm>
+ #include <cstddef>
+ #include <thread>
+ #include <vector>
+
+ /**
+  * @brief Число потоков для работы
+  * @param requested Запрошенное число (0 - по числу ядер)
+  * @return Не меньше 1
+  */
+ inline unsigned resolveThreads(unsigned requested) {
+     if (requested > 0) return requested;
+     return std::max(1u, std::thread::hardware_concurrency());
+ }
+
+ /**
+  * @brief Разбить [0, count) на threads непрерывных частей и обработать параллельно
+  * @param count Число элементов
+  * @param threads Число потоков (1 - выполнить в текущем потоке)
+  * @param body Функция body(begin, end, part)
+  */
+ template <typename Body>
+ void parallelFor(size_t count, unsigned threads, Body body) {
+     threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(count, 1)));
+     if (threads <= 1) {
+         body(size_t(0), count, 0u);
+         return;
+     }
+     std::vector<std::thread> workers;
+     workers.reserve(threads - 1);
+     for (unsigned part = 1; part < threads; part++) {
+         size_t begin = count * part / threads;
+         size_t end = count * (part + 1) / threads;
+         workers.emplace_back([=, &body] { body(begin, end, part); });
+     }
+     body(size_t(0), count / threads, 0u);
+     for (std::thread& w : workers) w.join();
+ }
+
+ /**
+  * @brief Сортировка частями в потоках с последующим попарным слиянием
+  */
+ template <typename T, typename Less>
+ void parallelSort(std::vector<T>& data, unsigned threads, Less less) {
+     size_t n = data.size();
+     threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(n / 1024, 1)));
+     if (threads <= 1) {
+         std::sort(data.begin(), data.end(), less);
+         return;
+     }
+     std::vector<size_t> bounds(threads + 1);
+     for (unsigned part = 0; part <= threads; part++) bounds[part] = n * part / threads;
+
+     parallelFor(threads, threads, [&](size_t begin, size_t end, unsigned) {
+         for (size_t part = begin; part < end; part++) {
+             std::sort(data.begin() + bounds[part], data.begin() + bounds[part + 1], less);
+         }
+     });
+
+     // Слияние соседних частей, на каждом уровне - параллельно
+     for (size_t width = 1; width < threads; width *= 2) {
+         size_t merges = (threads + 2 * width - 1) / (2 * width);
+         parallelFor(merges, static_cast<unsigned>(merges), [&](size_t begin, size_t end, unsigned) {
+             for (size_t m = begin; m < end; m++) {
+                 size_t lo = m * 2 * width;
+                 size_t mid = std::min<size_t>(lo + width, threads);
+                 size_t hi = std::min<size_t>(lo + 2 * width, threads);
+                 if (mid < hi) {
+                     std::inplace_merge(data.begin() + bounds[lo], data.begin() + bounds[mid],
+                                        data.begin() + bounds[hi], less);
+                 }
+             }
+         });
+     }
+ }
+
+ #endif
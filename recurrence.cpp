@@ -0,0 +1,309 @@
+/**
+ * @file recurrence.cpp
+ * @brief Реализация повторяющихся мероприятий
+ */
+
+ #include "recurrence.h"
+ #include "schedulestore.h"
+ #include <algorithm>
+ #include <charconv>
+
+ using namespace std;
+
+ namespace {
+
+ constexpr int64_t secondsPerDay = DateTime::secondsPerDay;
+
+ // Деление с округлением вниз и вверх (делитель положителен)
+ int64_t floorDiv(int64_t a, int64_t b) {
+     return a / b - (a % b < 0);
+ }
+
+ int64_t ceilDiv(int64_t a, int64_t b) {
+     return -floorDiv(-a, b);
+ }
+
+ // Маска дней недели правила; пустая - день недели первого повторения
+ uint32_t weekdayMask(const RecurrenceRule& rule) {
+     uint32_t mask = rule.weekdays & 0x7Fu;
+     return mask != 0 ? mask : 1u << (weekdayFromDays(rule.firstDay) - 1);
+ }
+
+ // Шаг повторений EveryMinutes и Daily, секунды
+ int64_t periodSeconds(const RecurrenceRule& rule) {
+     return int64_t(rule.interval) * (rule.kind == RecurrenceKind::EveryMinutes ? 60 : secondsPerDay);
+ }
+
+ bool isBlank(char c) {
+     return c == ' ' || c == '\t' || c == '\r';
+ }
+
+ // Следующее слово текста; пустое, если текст закончился
+ string_view nextWord(string_view& text) {
+     size_t begin = 0;
+     while (begin < text.size() && isBlank(text[begin])) begin++;
+     size_t end = begin;
+     while (end < text.size() && !isBlank(text[end])) end++;
+     string_view word = text.substr(begin, end - begin);
+     text.remove_prefix(end);
+     return word;
+ }
+
+ // Число, занимающее всё слово
+ bool parseNumber(string_view word, uint32_t& value) {
+     auto result = from_chars(word.data(), word.data() + word.size(), value);
+     return !word.empty() && result.ec == errc() && result.ptr == word.data() + word.size();
+ }
+
+ } // namespace
+
+ RecurrenceRule RecurrenceRule::everyMinutes(uint32_t minutes, int32_t firstDay, int32_t untilDay) {
+     return RecurrenceRule{RecurrenceKind::EveryMinutes, 0, max(minutes, 1u), firstDay, untilDay};
+ }
+
+ RecurrenceRule RecurrenceRule::daily(uint32_t days, int32_t firstDay, int32_t untilDay) {
+     return RecurrenceRule{RecurrenceKind::Daily, 0, max(days, 1u), firstDay, untilDay};
+ }
+
+ RecurrenceRule RecurrenceRule::weekly(uint32_t weeks, uint8_t weekdays, int32_t firstDay, int32_t untilDay) {
+     RecurrenceRule rule{RecurrenceKind::Weekly, static_cast<uint8_t>(weekdays & 0x7F), max(weeks, 1u), firstDay, untilDay};
+     rule.weekdays = static_cast<uint8_t>(weekdayMask(rule));
+     return rule;
+ }
+
+ bool parseDate(string_view text, int32_t& day) {
+     const char* p = text.data();
+     const char* last = p + text.size();
+     int32_t year = 0;
+     uint32_t month = 0, dayOfMonth = 0;
+     auto result = from_chars(p, last, year);
+     if (result.ec != errc() || result.ptr == last || *result.ptr != '-') return false;
+     result = from_chars(result.ptr + 1, last, month);
+     if (result.ec != errc() || result.ptr == last || *result.ptr != '-') return false;
+     result = from_chars(result.ptr + 1, last, dayOfMonth);
+     if (result.ec != errc() || result.ptr != last) return false;
+     if (year < 1 || year > 32767 || month < 1 || month > 12) return false;
+     if (dayOfMonth < 1 || dayOfMonth > daysInMonth(year, month)) return false;
+     day = daysFromCivil(year, month, dayOfMonth);
+     return true;
+ }
+
+ bool parseRecurrenceRule(string_view text, RecurrenceRule& rule, string& error) {
+     string_view kind = nextWord(text);
+     RecurrenceKind parsedKind;
+     if (kind == "minutes") {
+         parsedKind = RecurrenceKind::EveryMinutes;
+     } else if (kind == "daily") {
+         parsedKind = RecurrenceKind::Daily;
+     } else if (kind == "weekly") {
+         parsedKind = RecurrenceKind::Weekly;
+     } else {
+         error = "неизвестный вид повторения \"";
+         error += kind;
+         error += "\" (ожидалось minutes, daily или weekly)";
+         return false;
+     }
+
+     uint32_t interval = 0;
+     string_view word = nextWord(text);
+     if (!parseNumber(word, interval) || interval == 0) {
+         error = "шаг повторения должен быть положительным числом";
+         return false;
+     }
+     int32_t firstDay = 0;
+     word = nextWord(text);
+     if (!parseDate(word, firstDay)) {
+         error = "ожидалась дата первого повторения ГГГГ-ММ-ДД";
+         return false;
+     }
+
+     uint8_t weekdays = 0;
+     word = nextWord(text);
+     if (parsedKind == RecurrenceKind::Weekly && !word.empty() && word != "until") {
+         for (char c : word) {
+             if (c < '1' || c > '7') {
+                 error = "дни недели записываются цифрами от 1 (понедельник) до 7";
+                 return false;
+             }
+             weekdays |= static_cast<uint8_t>(1u << (c - '1'));
+         }
+         word = nextWord(text);
+     }
+
+     int32_t untilDay = RecurrenceRule::noEnd;
+     if (word == "until") {
+         if (!parseDate(nextWord(text), untilDay)) {
+             error = "ожидалась дата конца серии ГГГГ-ММ-ДД";
+             return false;
+         }
+         if (untilDay <= firstDay) {
+             error = "конец серии должен быть позже первого повторения";
+             return false;
+         }
+         word = nextWord(text);
+     }
+     if (!word.empty()) {
+         error = "лишнее слово в правиле: ";
+         error += word;
+         return false;
+     }
+
+     switch (parsedKind) {
+         case RecurrenceKind::EveryMinutes: rule = RecurrenceRule::everyMinutes(interval, firstDay, untilDay); break;
+         case RecurrenceKind::Daily: rule = RecurrenceRule::daily(interval, firstDay, untilDay); break;
+         case RecurrenceKind::Weekly: rule = RecurrenceRule::weekly(interval, weekdays, firstDay, untilDay); break;
+     }
+     return true;
+ }
+
+ int64_t firstOccurrenceAtOrAfter(const RecurrenceRule& rule, int32_t startSeconds, int64_t seconds) {
+     int64_t first = int64_t(rule.firstDay) * secondsPerDay + startSeconds;
+     if (rule.kind != RecurrenceKind::Weekly) {
+         if (seconds <= first) return first;
+         int64_t period = periodSeconds(rule);
+         return first + ceilDiv(seconds - first, period) * period;
+     }
+
+     // Первый день, в который повторение начнётся не раньше момента
+     int64_t day = max(ceilDiv(seconds - startSeconds, secondsPerDay), int64_t(rule.firstDay));
+     // Циклы по interval недель от понедельника недели первого повторения;
+     // повторения бывают только в первой неделе цикла
+     int64_t weekStart = rule.firstDay - int64_t(weekdayFromDays(rule.firstDay) - 1);
+     int64_t cycle = 7 * int64_t(rule.interval);
+     int64_t cycleStart = weekStart + floorDiv(day - weekStart, cycle) * cycle;
+     int64_t inCycle = day - cycleStart;
+     uint32_t mask = weekdayMask(rule);
+     if (inCycle < 7) {
+         uint32_t rest = mask & (0x7Fu << inCycle);
+         if (rest != 0) return (cycleStart + __builtin_ctz(rest)) * secondsPerDay + startSeconds;
+     }
+     return (cycleStart + cycle + __builtin_ctz(mask)) * secondsPerDay + startSeconds;
+ }
+
+ OccurrenceIterator::OccurrenceIterator(const RecurrenceRule& rule, int32_t startSeconds, DateTime from, DateTime to)
+     : rule_(rule), startSeconds_(startSeconds) {
+     limit_ = min(to.unixSeconds(), int64_t(rule.untilDay) * secondsPerDay);
+     current_ = firstOccurrenceAtOrAfter(rule, startSeconds, from.unixSeconds());
+     done_ = current_ >= limit_;
+ }
+
+ OccurrenceIterator& OccurrenceIterator::operator++() {
+     if (rule_.kind == RecurrenceKind::Weekly) {
+         current_ = firstOccurrenceAtOrAfter(rule_, startSeconds_, current_ + 1);
+     } else {
+         current_ += periodSeconds(rule_);
+     }
+     done_ = current_ >= limit_;
+     return *this;
+ }
+
+ void RecurrenceTable::set(EventHandle owner, const RecurrenceRule& rule) {
+     if (owner.slot >= ruleOfSlot_.size()) ruleOfSlot_.resize(owner.slot + size_t(1), npos);
+     uint32_t& r = ruleOfSlot_[owner.slot];
+     if (r == npos) {
+         r = static_cast<uint32_t>(rules_.size());
+         rules_.push_back(rule);
+         owners_.push_back(owner);
+     } else {
+         rules_[r] = rule;
+         owners_[r] = owner;
+     }
+ }
+
+ const RecurrenceRule* RecurrenceTable::find(EventHandle owner) const {
+     if (owner.slot >= ruleOfSlot_.size()) return nullptr;
+     uint32_t r = ruleOfSlot_[owner.slot];
+     if (r == npos || owners_[r] != owner) return nullptr;
+     return &rules_[r];
+ }
+
+ bool RecurrenceTable::erase(uint32_t slot) {
+     if (slot >= ruleOfSlot_.size() || ruleOfSlot_[slot] == npos) return false;
+     uint32_t r = ruleOfSlot_[slot];
+     // На место удалённого правила переезжает последнее
+     size_t last = rules_.size() - 1;
+     if (r != last) {
+         rules_[r] = rules_[last];
+         owners_[r] = owners_[last];
+         ruleOfSlot_[owners_[r].slot] = r;
+     }
+     rules_.pop_back();
+     owners_.pop_back();
+     ruleOfSlot_[slot] = npos;
+     return true;
+ }
+
+ void RecurrenceTable::clear() {
+     for (EventHandle owner : owners_) ruleOfSlot_[owner.slot] = npos;
+     rules_.clear();
+     owners_.clear();
+ }
+
+ namespace {
+
+ // Обходит серии расписания: visit(мероприятие, длительность, повторения,
+ // пересекающиеся с окном). visit возвращает false, чтобы прекратить обход.
+ template <typename Visit>
+ void visitSeries(const ScheduleStore& schedule, DateTime from, DateTime to, Visit visit) {
+     const RecurrenceTable& table = schedule.recurrences();
+     if (table.empty() || !(from < to)) return;
+     // После обращения к столбцам надгробий нет, и indexOf - O(1)
+     const int32_t* starts = schedule.startColumn();
+     const int32_t* ends = schedule.endColumn();
+
+     for (size_t r = 0; r < table.size(); r++) {
+         EventHandle owner = table.owner(r);
+         int i = schedule.indexOf(owner);
+         int32_t duration = actualDurationSeconds(starts[i], ends[i]);
+         // Повторение длительности d пересекает окно, если начинается
+         // не раньше from - d + 1 секунды
+         DateTime earliest = duration > 0 ? from - TimeSpan64::fromSeconds(duration - 1) : from;
+         if (!visit(owner, TimeSpan64::fromSeconds(duration), occurrences(table.rule(r), starts[i], earliest, to))) return;
+     }
+ }
+
+ bool startsEarlier(const Occurrence& a, const Occurrence& b) {
+     return a.start < b.start;
+ }
+
+ } // namespace
+
+ size_t occurrencesIn(const ScheduleStore& schedule, DateTime from, DateTime to,
+                      vector<Occurrence>& out, size_t limit) {
+     size_t added = 0;
+     if (limit == 0) return 0;
+     visitSeries(schedule, from, to, [&](EventHandle owner, TimeSpan64 length, OccurrenceRange range) {
+         for (DateTime start : range) {
+             out.push_back(Occurrence{owner, start, start + length});
+             if (++added == limit) return false;
+         }
+         return true;
+     });
+     return added;
+ }
+
+ bool earliestOccurrencesIn(const ScheduleStore& schedule, DateTime from, DateTime to, size_t count,
+                            vector<Occurrence>& out) {
+     // Куча с самым поздним из отобранных повторений наверху
+     vector<Occurrence> heap;
+     bool more = false;
+     visitSeries(schedule, from, to, [&](EventHandle owner, TimeSpan64 length, OccurrenceRange range) {
+         for (DateTime start : range) {
+             if (heap.size() < count) {
+                 heap.push_back(Occurrence{owner, start, start + length});
+                 push_heap(heap.begin(), heap.end(), startsEarlier);
+                 continue;
+             }
+             more = true;
+             // Дальше повторения серии только позже
+             if (count == 0 || !(start < heap.front().start)) break;
+             pop_heap(heap.begin(), heap.end(), startsEarlier);
+             heap.back() = Occurrence{owner, start, start + length};
+             push_heap(heap.begin(), heap.end(), startsEarlier);
+         }
+         return true;
+     });
+     sort_heap(heap.begin(), heap.end(), startsEarlier);
+     out.insert(out.end(), heap.begin(), heap.end());
+     return more;
+ }
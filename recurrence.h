@@ -0,0 +1,268 @@
+/**
+ * @file recurrence.h
+ * @brief Повторяющиеся мероприятия: правила повторения и ленивый перебор повторений
+ */
+
+ #ifndef RECURRENCE_H
+ #define RECURRENCE_H
+
+ #include "datetime.h"
+ #include "scheduletypes.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <iterator>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+
+ class ScheduleStore;
+
+ /**
+  * @brief Вид повторения
+  */
+ enum class RecurrenceKind : uint8_t {
+     EveryMinutes, ///< Каждые interval минут
+     Daily,        ///< Каждые interval дней
+     Weekly        ///< По дням недели weekdays каждые interval недель
+ };
+
+ /**
+  * @struct RecurrenceRule
+  * @brief Правило повторения мероприятия
+  *
+  * Правило не хранит ни времени, ни длительности: повторение начинается
+  * в секунды начала мероприятия и длится его фактическую длительность.
+  * Повторения не разворачиваются в память, поэтому серия любой длины
+  * занимает 16 байт; нужные повторения вычисляет OccurrenceIterator.
+  */
+ struct RecurrenceRule {
+     static constexpr int32_t noEnd = INT32_MAX; ///< untilDay бессрочной серии
+
+     RecurrenceKind kind = RecurrenceKind::Daily;
+     uint8_t weekdays = 0;   ///< Weekly: бит 0 - понедельник, ..., бит 6 - воскресенье
+     uint32_t interval = 1;  ///< Шаг в минутах, днях или неделях (не меньше 1)
+     int32_t firstDay = 0;   ///< День первого повторения (номер дня от 1970-01-01)
+     int32_t untilDay = noEnd; ///< Повторения начинаются раньше этого дня
+
+     /**
+      * @brief Каждые minutes минут начиная с дня firstDay
+      */
+     static RecurrenceRule everyMinutes(uint32_t minutes, int32_t firstDay, int32_t untilDay = noEnd);
+
+     /**
+      * @brief Каждые days дней начиная с дня firstDay
+      */
+     static RecurrenceRule daily(uint32_t days, int32_t firstDay, int32_t untilDay = noEnd);
+
+     /**
+      * @brief По дням недели weekdays каждые weeks недель
+      *
+      * Недели отсчитываются от понедельника недели, в которую попадает
+      * firstDay; повторений раньше firstDay нет. Пустая маска - день
+      * недели firstDay.
+      */
+     static RecurrenceRule weekly(uint32_t weeks, uint8_t weekdays, int32_t firstDay, int32_t untilDay = noEnd);
+
+     bool operator==(const RecurrenceRule& other) const {
+         return kind == other.kind && weekdays == other.weekdays && interval == other.interval
+             && firstDay == other.firstDay && untilDay == other.untilDay;
+     }
+     bool operator!=(const RecurrenceRule& other) const { return !(*this == other); }
+ };
+
+ static_assert(sizeof(RecurrenceRule) == 16, "Правило повторения должно занимать 16 байт");
+
+ /**
+  * @brief Разбор даты ГГГГ-ММ-ДД (год от 1 до 32767)
+  * @param text Дата без пробелов
+  * @param day Номер дня от 1970-01-01
+  */
+ bool parseDate(std::string_view text, int32_t& day);
+
+ /**
+  * @brief Разбор правила повторения из текста
+  * @param text Правило: вид, шаг, первый день, для weekly - дни недели
+  *        цифрами (1 - понедельник), необязательный конец серии:
+  *        "minutes 30 2026-10-19", "daily 2 2026-10-19 until 2026-12-31",
+  *        "weekly 1 2026-10-19 135"
+  * @param rule Разобранное правило
+  * @param error Текст ошибки, если разбор не удался
+  *
+  * Конец серии (until) - первый день, в который повторений уже нет.
+  */
+ bool parseRecurrenceRule(std::string_view text, RecurrenceRule& rule, std::string& error);
+
+ /**
+  * @brief Начало первого повторения не раньше момента
+  * @param rule Правило
+  * @param startSeconds Начало мероприятия, секунды от полуночи
+  * @param seconds Момент, секунды от 1970-01-01
+  * @return Начало повторения в секундах от 1970-01-01 (может быть за untilDay)
+  *
+  * O(1) для любого вида: номер повторения вычисляется делением, а для
+  * Weekly день внутри недели - по младшему биту маски.
+  */
+ int64_t firstOccurrenceAtOrAfter(const RecurrenceRule& rule, int32_t startSeconds, int64_t seconds);
+
+ /**
+  * @class OccurrenceIterator
+  * @brief Входной итератор по началам повторений серии в окне [from, to)
+  *
+  * Хранит правило и текущее повторение; следующее вычисляется при ++ за
+  * O(1), так что перебор k повторений стоит O(k) независимо от того,
+  * сколько повторений у серии до и после окна. Итератор по умолчанию -
+  * конец перебора.
+  */
+ class OccurrenceIterator {
+ private:
+     RecurrenceRule rule_;
+     int32_t startSeconds_ = 0; ///< Начало мероприятия, секунды от полуночи
+     int64_t current_ = 0;      ///< Начало текущего повторения, секунды от 1970-01-01
+     int64_t limit_ = 0;        ///< Повторения начинаются раньше limit_
+     bool done_ = true;
+
+ public:
+     using iterator_category = std::input_iterator_tag;
+     using value_type = DateTime;
+     using difference_type = std::ptrdiff_t;
+     using pointer = const DateTime*;
+     using reference = DateTime;
+
+     OccurrenceIterator() = default;
+
+     /**
+      * @brief Первое повторение не раньше from, начинающееся раньше to
+      */
+     OccurrenceIterator(const RecurrenceRule& rule, int32_t startSeconds, DateTime from, DateTime to);
+
+     DateTime operator*() const { return DateTime::fromUnixSeconds(current_); } ///< Начало повторения
+
+     OccurrenceIterator& operator++();
+     OccurrenceIterator operator++(int) {
+         OccurrenceIterator previous = *this;
+         ++*this;
+         return previous;
+     }
+
+     bool operator==(const OccurrenceIterator& other) const {
+         return done_ == other.done_ && (done_ || current_ == other.current_);
+     }
+     bool operator!=(const OccurrenceIterator& other) const { return !(*this == other); }
+ };
+
+ /**
+  * @class OccurrenceRange
+  * @brief Повторения серии в окне для range-based for
+  */
+ class OccurrenceRange {
+ private:
+     OccurrenceIterator begin_;
+
+ public:
+     OccurrenceRange(const RecurrenceRule& rule, int32_t startSeconds, DateTime from, DateTime to)
+         : begin_(rule, startSeconds, from, to) {}
+
+     OccurrenceIterator begin() const { return begin_; }
+     OccurrenceIterator end() const { return OccurrenceIterator(); }
+ };
+
+ /**
+  * @brief Начала повторений серии в окне [from, to)
+  * @param rule Правило
+  * @param startSeconds Начало мероприятия, секунды от полуночи
+  */
+ inline OccurrenceRange occurrences(const RecurrenceRule& rule, int32_t startSeconds, DateTime from, DateTime to) {
+     return OccurrenceRange(rule, startSeconds, from, to);
+ }
+
+ /**
+  * @class RecurrenceTable
+  * @brief Правила повторения мероприятий хранилища
+  *
+  * Правила лежат плотным массивом вместе с дескрипторами владельцев, а
+  * для слотов дескрипторов хранится номер правила. Поиск, замена и
+  * удаление - O(1): удалённое правило замещается последним. Память -
+  * 24 байта на серию и 4 байта на слот; расписание без серий не платит
+  * ничего.
+  */
+ class RecurrenceTable {
+ private:
+     static constexpr uint32_t npos = UINT32_MAX;
+
+     std::vector<RecurrenceRule> rules_; ///< Правила
+     std::vector<EventHandle> owners_;   ///< Мероприятие каждого правила
+     std::vector<uint32_t> ruleOfSlot_;  ///< Номер правила для каждого слота (npos - нет)
+
+ public:
+     /**
+      * @brief Назначить или заменить правило мероприятия
+      */
+     void set(EventHandle owner, const RecurrenceRule& rule);
+
+     /**
+      * @brief Правило мероприятия или nullptr
+      */
+     const RecurrenceRule* find(EventHandle owner) const;
+
+     /**
+      * @brief Убрать правило мероприятия из слота (вызывается при удалении)
+      * @return false, если правила не было
+      */
+     bool erase(uint32_t slot);
+
+     /**
+      * @brief Убрать все правила (память сохраняется)
+      */
+     void clear();
+
+     size_t size() const { return rules_.size(); }                         ///< Число серий
+     bool empty() const { return rules_.empty(); }                         ///< Серий нет
+     const RecurrenceRule& rule(size_t i) const { return rules_[i]; }      ///< i-е правило
+     EventHandle owner(size_t i) const { return owners_[i]; }              ///< Мероприятие i-го правила
+
+     /**
+      * @brief Занятая память, байты (по ёмкости массивов)
+      */
+     size_t memoryBytes() const {
+         return rules_.capacity() * sizeof(RecurrenceRule) + owners_.capacity() * sizeof(EventHandle)
+              + ruleOfSlot_.capacity() * sizeof(uint32_t);
+     }
+ };
+
+ /**
+  * @struct Occurrence
+  * @brief Повторение мероприятия
+  */
+ struct Occurrence {
+     EventHandle event; ///< Мероприятие серии
+     DateTime start;    ///< Начало повторения
+     DateTime end;      ///< Конец (начало плюс фактическая длительность)
+ };
+
+ /**
+  * @brief Повторения всех серий, пересекающиеся с окном [from, to)
+  * @param schedule Расписание
+  * @param out Сюда дописываются повторения (по сериям, внутри серии - по времени)
+  * @param limit Наибольшее число дописываемых повторений
+  * @return Число дописанных повторений
+  *
+  * Разворачиваются только повторения из окна: O(s + k) для s серий и
+  * k найденных повторений. Повторение нулевой длительности попадает в
+  * окно, если начинается в нём.
+  */
+ size_t occurrencesIn(const ScheduleStore& schedule, DateTime from, DateTime to,
+                      std::vector<Occurrence>& out, size_t limit = SIZE_MAX);
+
+ /**
+  * @brief Самые ранние count повторений, пересекающихся с окном [from, to)
+  * @param out Сюда дописываются повторения в порядке начала
+  * @return true, если в окне есть и другие повторения
+  *
+  * Для вывода длинных окон: память - O(count), отобранные повторения
+  * держатся в куче, а перебор серии прекращается на первом повторении,
+  * которое не раньше самого позднего из отобранных.
+  */
+ bool earliestOccurrencesIn(const ScheduleStore& schedule, DateTime from, DateTime to, size_t count,
+                            std::vector<Occurrence>& out);
+
+ #endif
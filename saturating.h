@@ -0,0 +1,124 @@
+/**
+ * @file saturating.h
+ * @brief Целочисленная арифметика с насыщением и проверкой переполнения
+ */
+
+ #ifndef SATURATING_H
+ #define SATURATING_H
+
+ #include <cstdint>
+ #include <limits>
+ #include <type_traits>
+
+ // При переполнении результат прижимается к границе типа вместо
+ // неопределённого поведения. Проверка - встроенные функции GCC/Clang
+ // __builtin_*_overflow: флаг переноса процессора, без деления и
+ // расширения до большего типа. Ветка переполнения почти никогда не
+ // выполняется и хорошо предсказывается.
+
+ /**
+  * @brief a + b с насыщением
+  */
+ template <typename T>
+ constexpr T saturatingAdd(T a, T b) noexcept {
+     static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "нужен знаковый целый тип");
+     T result = 0;
+     if (__builtin_add_overflow(a, b, &result)) {
+         return b > 0 ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+     }
+     return result;
+ }
+
+ /**
+  * @brief a - b с насыщением
+  */
+ template <typename T>
+ constexpr T saturatingSub(T a, T b) noexcept {
+     static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "нужен знаковый целый тип");
+     T result = 0;
+     if (__builtin_sub_overflow(a, b, &result)) {
+         return b < 0 ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+     }
+     return result;
+ }
+
+ /**
+  * @brief a * b с насыщением
+  */
+ template <typename T>
+ constexpr T saturatingMul(T a, T b) noexcept {
+     static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "нужен знаковый целый тип");
+     T result = 0;
+     if (__builtin_mul_overflow(a, b, &result)) {
+         return (a < 0) != (b < 0) ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+     }
+     return result;
+ }
+
+ /**
+  * @brief Привести целое значение к типу T, прижав к его границам
+  */
+ template <typename T, typename U>
+ constexpr T saturatingCast(U value) noexcept {
+     static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "нужен знаковый целый тип");
+     T result = 0;
+     if (__builtin_add_overflow(value, 0, &result)) {
+         return value > 0 ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+     }
+     return result;
+ }
+
+ /**
+  * @brief Привести double к целому типу T с отбрасыванием дробной части
+  *
+  * Значения за границами типа прижимаются к ним, NaN даёт 0. Обычный
+  * static_cast в этих случаях - неопределённое поведение.
+  */
+ template <typename T>
+ constexpr T saturatingFromDouble(double value) noexcept {
+     static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "нужен знаковый целый тип");
+     // Граница max() + 1 = 2^(digits) точно представима в double
+     constexpr double upper = static_cast<double>(std::numeric_limits<T>::max() / 2 + 1) * 2.0;
+     constexpr double lower = static_cast<double>(std::numeric_limits<T>::min());
+     if (value != value) return 0;
+     if (value >= upper) return std::numeric_limits<T>::max();
+     if (value <= lower) return std::numeric_limits<T>::min();
+     return static_cast<T>(value);
+ }
+
+ /**
+  * @brief a + b с проверкой
+  * @param result Сумма, если переполнения не было (иначе не меняется)
+  * @return false при переполнении
+  */
+ template <typename T>
+ constexpr bool checkedAdd(T a, T b, T& result) noexcept {
+     T sum = 0;
+     if (__builtin_add_overflow(a, b, &sum)) return false;
+     result = sum;
+     return true;
+ }
+
+ /**
+  * @brief a - b с проверкой (см. checkedAdd)
+  */
+ template <typename T>
+ constexpr bool checkedSub(T a, T b, T& result) noexcept {
+     T difference = 0;
+     if (__builtin_sub_overflow(a, b, &difference)) return false;
+     result = difference;
+     return true;
+ }
+
+ /**
+  * @brief a * b с проверкой (см. checkedAdd)
+  */
+ template <typename T>
+ constexpr bool checkedMul(T a, T b, T& result) noexcept {
+     T product = 0;
+     if (__builtin_mul_overflow(a, b, &product)) return false;
+     result = product;
+     return true;
+ }
+
+ #endif
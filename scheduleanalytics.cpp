@@ -0,0 +1,310 @@
+/**
+ * @file scheduleanalytics.cpp
+ * @brief Реализация статистики "план/факт"
+ */
+
+ #include "scheduleanalytics.h"
+ #include "parallel.h"
+ #include "time.h"
+ #include "timespan.h"
+ #include <algorithm>
+ #include <cmath>
+ #include <cstdio>
+ #include <ostream>
+ #include <string>
+
+ using namespace std;
+
+ namespace {
+
+ const int32_t daySeconds = 24 * 3600;
+
+ // Отклонение считается в int64_t и приводится к симметричному диапазону
+ // int32_t, чтобы модуль любого значения тоже помещался в int32_t
+ int32_t saturate(int64_t seconds) {
+     return static_cast<int32_t>(max<int64_t>(-INT32_MAX, min<int64_t>(INT32_MAX, seconds)));
+ }
+
+ // Порядок худших: большее опоздание раньше, при равенстве - меньшая позиция
+ bool worseOverrun(const ScheduleOverrun& a, const ScheduleOverrun& b) {
+     return a.overrunSeconds != b.overrunSeconds ? a.overrunSeconds > b.overrunSeconds : a.position < b.position;
+ }
+
+ // Итог первого прохода по части расписания
+ struct Partial {
+     int64_t deviationSum = 0;
+     int64_t overrunSum = 0;
+     size_t overrunCount = 0;
+     size_t earlyCount = 0;
+     int32_t minDeviation = INT32_MAX;
+     int32_t maxDeviation = -INT32_MAX;
+     vector<ScheduleOverrun> worst; ///< Куча: в вершине наименее плохое из отобранных
+ };
+
+ // Итог второго прохода: посекундные счётчики и отклонения вне суток
+ struct Counts {
+     vector<uint32_t> bins;
+     vector<int32_t> outliers;
+ };
+
+ int32_t percentileFrom(const vector<int32_t>& low, const vector<size_t>& bins, int32_t lo,
+                        const vector<int32_t>& high, size_t total, double percent) {
+     double share = min(100.0, max(0.0, percent)) / 100.0;
+     size_t rank = max<size_t>(1, static_cast<size_t>(ceil(share * static_cast<double>(total))));
+     if (rank <= low.size()) return low[rank - 1];
+     rank -= low.size();
+     for (size_t v = 0; v < bins.size(); v++) {
+         if (rank <= bins[v]) return lo + static_cast<int32_t>(v);
+         rank -= bins[v];
+     }
+     return high[min(rank, high.size()) - 1];
+ }
+
+ void appendTime(string& out, int seconds) {
+     char buffer[Time::maxFormattedLength];
+     out.append(buffer, Time::formatSeconds(seconds, buffer));
+ }
+
+ // Отклонение одного мероприятия со знаком: formatSeconds выводит
+ // отрицательные значения покомпонентно, поэтому знак ставится отдельно
+ void appendDeviation(string& out, int32_t seconds) {
+     if (seconds > 0) out += '+';
+     if (seconds < 0) out += '-';
+     appendTime(out, seconds < 0 ? -seconds : seconds);
+ }
+
+ // Суммы и границы корзин: int64_t выводится через TimeSpan64 без прижатия
+ void appendTotalDeviation(string& out, int64_t seconds) {
+     char buffer[TimeSpan64::maxFormattedLength];
+     if (seconds > 0) out += '+';
+     out.append(buffer, TimeSpan64::fromSeconds(seconds).formatTo(buffer));
+ }
+
+ void appendPercent(string& out, double percent) {
+     char buffer[32];
+     int length = snprintf(buffer, sizeof(buffer), "%g%%", percent);
+     out.append(buffer, static_cast<size_t>(max(0, length)));
+ }
+
+ } // namespace
+
+ ScheduleStats analyzeSchedule(const ScheduleStore& schedule, const ScheduleStatsOptions& options) {
+     ScheduleStats stats;
+     size_t n = static_cast<size_t>(schedule.size());
+     stats.events = n;
+     stats.percentiles.assign(options.percentiles.size(), 0);
+     int32_t bucket = max<int32_t>(1, options.bucketSeconds);
+     int32_t limit = max(bucket, min(daySeconds, options.histogramLimitSeconds));
+     stats.histogram.firstSeconds = -limit;
+     stats.histogram.bucketSeconds = bucket;
+     // Корзина около INT32_MAX: 2 * limit + bucket в int32_t переполнится
+     int64_t span = 2 * static_cast<int64_t>(limit);
+     stats.histogram.counts.assign(static_cast<size_t>((span + bucket - 1) / bucket), 0);
+     if (n == 0) return stats;
+
+     unsigned threads = n >= options.parallelThreshold ? resolveThreads(options.threads) : 1;
+     threads = static_cast<unsigned>(min<size_t>(threads, n));
+     const int32_t* planned = schedule.plannedColumn();
+     const int32_t* actual = schedule.actualColumn();
+     size_t top = options.topCount;
+
+     // Проход 1: суммы, крайние значения и худшие опоздания
+     vector<Partial> partials(threads);
+     parallelFor(n, threads, [&](size_t begin, size_t end, unsigned part) {
+         Partial& p = partials[part];
+         for (size_t i = begin; i < end; i++) {
+             int32_t d = saturate(static_cast<int64_t>(actual[i]) - planned[i]);
+             p.deviationSum += d;
+             p.minDeviation = min(p.minDeviation, d);
+             p.maxDeviation = max(p.maxDeviation, d);
+             if (d < 0) {
+                 p.earlyCount++;
+                 continue;
+             }
+             if (d == 0) continue;
+             p.overrunCount++;
+             p.overrunSum += d;
+             if (top == 0) continue;
+             ScheduleOverrun candidate{static_cast<int>(i), d};
+             if (p.worst.size() < top) {
+                 p.worst.push_back(candidate);
+                 push_heap(p.worst.begin(), p.worst.end(), worseOverrun);
+             } else if (worseOverrun(candidate, p.worst.front())) {
+                 pop_heap(p.worst.begin(), p.worst.end(), worseOverrun);
+                 p.worst.back() = candidate;
+                 push_heap(p.worst.begin(), p.worst.end(), worseOverrun);
+             }
+         }
+     });
+
+     stats.minDeviationSeconds = INT32_MAX;
+     stats.maxDeviationSeconds = -INT32_MAX;
+     for (Partial& p : partials) {
+         stats.totalDeviationSeconds += p.deviationSum;
+         stats.totalOverrunSeconds += p.overrunSum;
+         stats.overrunCount += p.overrunCount;
+         stats.earlyCount += p.earlyCount;
+         stats.minDeviationSeconds = min(stats.minDeviationSeconds, p.minDeviation);
+         stats.maxDeviationSeconds = max(stats.maxDeviationSeconds, p.maxDeviation);
+         stats.worst.insert(stats.worst.end(), p.worst.begin(), p.worst.end());
+     }
+     stats.onTimeCount = n - stats.overrunCount - stats.earlyCount;
+     stats.meanDeviationSeconds = static_cast<double>(stats.totalDeviationSeconds) / static_cast<double>(n);
+     if (stats.overrunCount > 0) {
+         stats.meanOverrunSeconds = static_cast<double>(stats.totalOverrunSeconds) / static_cast<double>(stats.overrunCount);
+     }
+     sort(stats.worst.begin(), stats.worst.end(), worseOverrun);
+     if (stats.worst.size() > top) stats.worst.resize(top);
+
+     // Проход 2: посекундная гистограмма на [lo, hi] - не шире двух суток.
+     // Если счётчиков намного больше, чем мероприятий, дешевле отсортировать
+     // все отклонения: тогда диапазон пуст и все они идут в low и high
+     int32_t lo = max(stats.minDeviationSeconds, -daySeconds);
+     int32_t hi = min(stats.maxDeviationSeconds, daySeconds);
+     size_t binCount = lo <= hi ? static_cast<size_t>(hi - lo) + 1 : 0;
+     if (binCount > 4 * n) {
+         lo = 1;
+         hi = 0;
+         binCount = 0;
+     }
+     vector<Counts> counts(threads);
+     parallelFor(n, threads, [&](size_t begin, size_t end, unsigned part) {
+         Counts& c = counts[part];
+         c.bins.assign(binCount, 0);
+         for (size_t i = begin; i < end; i++) {
+             int32_t d = saturate(static_cast<int64_t>(actual[i]) - planned[i]);
+             if (d < lo || d > hi) {
+                 c.outliers.push_back(d);
+             } else {
+                 c.bins[static_cast<size_t>(d - lo)]++;
+             }
+         }
+     });
+
+     vector<size_t> bins(binCount, 0);
+     vector<int32_t> low, high;
+     for (Counts& c : counts) {
+         for (size_t v = 0; v < binCount; v++) bins[v] += c.bins[v];
+         for (int32_t d : c.outliers) (d < lo ? low : high).push_back(d);
+         vector<uint32_t>().swap(c.bins);
+     }
+     sort(low.begin(), low.end());
+     sort(high.begin(), high.end());
+
+     for (size_t k = 0; k < options.percentiles.size(); k++) {
+         stats.percentiles[k] = percentileFrom(low, bins, lo, high, n, options.percentiles[k]);
+     }
+
+     DeviationHistogram& h = stats.histogram;
+     auto place = [&](int32_t d, size_t count) {
+         if (d < h.firstSeconds) {
+             h.below += count;
+             return;
+         }
+         size_t index = static_cast<size_t>((static_cast<int64_t>(d) - h.firstSeconds) / bucket);
+         if (index >= h.counts.size()) {
+             h.above += count;
+         } else {
+             h.counts[index] += count;
+         }
+     };
+     for (int32_t d : low) place(d, 1);
+     for (size_t v = 0; v < binCount; v++) {
+         if (bins[v] > 0) place(lo + static_cast<int32_t>(v), bins[v]);
+     }
+     for (int32_t d : high) place(d, 1);
+     return stats;
+ }
+
+ void writeScheduleStats(const ScheduleStore& schedule, const ScheduleStats& stats,
+                         const ScheduleStatsOptions& options, ostream& out) {
+     string text;
+     text += "Мероприятий: ";
+     text += to_string(stats.events);
+     text += '\n';
+     if (stats.events == 0) {
+         out.write(text.data(), text.size());
+         return;
+     }
+     text += "Опозданий: ";
+     text += to_string(stats.overrunCount);
+     text += ", ускорений: ";
+     text += to_string(stats.earlyCount);
+     text += ", точно по плану: ";
+     text += to_string(stats.onTimeCount);
+     text += '\n';
+     text += "Суммарное опоздание: ";
+     appendTotalDeviation(text, stats.totalOverrunSeconds);
+     text += ", среднее: ";
+     appendDeviation(text, saturate(llround(stats.meanOverrunSeconds)));
+     text += '\n';
+     text += "Среднее отклонение: ";
+     appendDeviation(text, saturate(llround(stats.meanDeviationSeconds)));
+     text += " (от ";
+     appendDeviation(text, stats.minDeviationSeconds);
+     text += " до ";
+     appendDeviation(text, stats.maxDeviationSeconds);
+     text += ")\n";
+
+     if (!stats.percentiles.empty()) {
+         text += "Процентили отклонения:";
+         for (size_t k = 0; k < stats.percentiles.size() && k < options.percentiles.size(); k++) {
+             text += k == 0 ? " " : ", ";
+             appendPercent(text, options.percentiles[k]);
+             text += ' ';
+             appendDeviation(text, stats.percentiles[k]);
+         }
+         text += '\n';
+     }
+
+     // Пустые корзины пропускаются, полоса - до 40 символов
+     const DeviationHistogram& h = stats.histogram;
+     size_t peak = max(h.below, h.above);
+     for (size_t c : h.counts) peak = max(peak, c);
+     auto appendBar = [&](size_t count) {
+         text += ": ";
+         text += to_string(count);
+         text += ' ';
+         text.append(peak > 0 ? (count * 40 + peak - 1) / peak : 0, '#');
+         text += '\n';
+     };
+     text += "Гистограмма отклонений (корзина ";
+     appendTime(text, h.bucketSeconds);
+     text += "):\n";
+     if (h.below > 0) {
+         text += "  меньше ";
+         appendTotalDeviation(text, h.firstSeconds);
+         appendBar(h.below);
+     }
+     for (size_t k = 0; k < h.counts.size(); k++) {
+         if (h.counts[k] == 0) continue;
+         int64_t from = h.firstSeconds + static_cast<int64_t>(k) * h.bucketSeconds;
+         text += "  ";
+         appendTotalDeviation(text, from);
+         text += " .. ";
+         appendTotalDeviation(text, from + h.bucketSeconds);
+         appendBar(h.counts[k]);
+     }
+     if (h.above > 0) {
+         text += "  от ";
+         appendTotalDeviation(text, h.firstSeconds + static_cast<int64_t>(h.counts.size()) * h.bucketSeconds);
+         appendBar(h.above);
+     }
+
+     if (!stats.worst.empty()) {
+         text += "Худшие опоздания:\n";
+         for (size_t k = 0; k < stats.worst.size(); k++) {
+             const ScheduleOverrun& w = stats.worst[k];
+             text += "  ";
+             text += to_string(k + 1);
+             text += ". \"";
+             text += schedule.name(w.position);
+             text += "\" (№";
+             text += to_string(w.position + 1);
+             text += "): ";
+             appendDeviation(text, w.overrunSeconds);
+             text += '\n';
+         }
+     }
+     out.write(text.data(), text.size());
+ }
@@ -0,0 +1,94 @@
+/**
+ * @file scheduleanalytics.h
+ * @brief Сводная статистика "план/факт" по всему расписанию
+ */
+
+ #ifndef SCHEDULEANALYTICS_H
+ #define SCHEDULEANALYTICS_H
+
+ #include "schedulestore.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <iosfwd>
+ #include <vector>
+
+ /**
+  * @struct ScheduleStatsOptions
+  * @brief Параметры расчёта статистики
+  */
+ struct ScheduleStatsOptions {
+     size_t topCount = 10;                    ///< Сколько худших опозданий включить в отчёт
+     std::vector<double> percentiles = {50, 90, 99}; ///< Процентили отклонения (0..100)
+     int32_t bucketSeconds = 15 * 60;         ///< Ширина корзины гистограммы
+     int32_t histogramLimitSeconds = 4 * 3600; ///< Гистограмма покрывает [-limit, limit)
+     size_t parallelThreshold = 100000;       ///< С этого числа мероприятий работа делится на потоки
+     unsigned threads = 0;                    ///< Число потоков (0 - по числу ядер)
+ };
+
+ /**
+  * @struct ScheduleOverrun
+  * @brief Опоздание одного мероприятия
+  */
+ struct ScheduleOverrun {
+     int position;            ///< Позиция мероприятия
+     int32_t overrunSeconds;  ///< Факт минус план, больше нуля
+ };
+
+ /**
+  * @struct DeviationHistogram
+  * @brief Распределение отклонений "факт минус план"
+  */
+ struct DeviationHistogram {
+     int32_t firstSeconds = 0;    ///< Нижняя граница первой корзины
+     int32_t bucketSeconds = 0;   ///< Ширина корзины
+     size_t below = 0;            ///< Отклонения меньше firstSeconds
+     size_t above = 0;            ///< Отклонения за последней корзиной
+     std::vector<size_t> counts;  ///< Число мероприятий в каждой корзине
+ };
+
+ /**
+  * @struct ScheduleStats
+  * @brief Итог анализа расписания
+  */
+ struct ScheduleStats {
+     size_t events = 0;                ///< Число мероприятий
+     size_t overrunCount = 0;          ///< Факт больше плана
+     size_t earlyCount = 0;            ///< Факт меньше плана
+     size_t onTimeCount = 0;           ///< Факт равен плану
+     int64_t totalOverrunSeconds = 0;  ///< Сумма опозданий
+     int64_t totalDeviationSeconds = 0; ///< Сумма отклонений "факт минус план"
+     double meanOverrunSeconds = 0;    ///< Среднее опоздание среди опоздавших
+     double meanDeviationSeconds = 0;  ///< Среднее отклонение по всем мероприятиям
+     int32_t minDeviationSeconds = 0;  ///< Наибольшее ускорение (со знаком минус)
+     int32_t maxDeviationSeconds = 0;  ///< Наибольшее опоздание
+     std::vector<int32_t> percentiles; ///< Отклонения для options.percentiles
+     DeviationHistogram histogram;     ///< Гистограмма отклонений
+     std::vector<ScheduleOverrun> worst; ///< Худшие опоздания по убыванию, при равенстве - по позиции
+ };
+
+ /**
+  * @brief Посчитать статистику "план/факт"
+  * @param schedule Расписание
+  * @param options Процентили, гистограмма, размер списка худших, потоки
+  * @return Статистика
+  *
+  * Два прохода по столбцам плановой и фактической длительности без
+  * создания объектов Time. Первый считает суммы, минимум, максимум и
+  * худшие опоздания (куча на top мест в каждом потоке), второй -
+  * посекундную гистограмму отклонений в пределах суток, по которой
+  * процентили находятся точно за O(n). Отклонения больше суток (а в
+  * небольшом расписании - все) собираются отдельно и сортируются.
+  */
+ ScheduleStats analyzeSchedule(const ScheduleStore& schedule, const ScheduleStatsOptions& options);
+
+ /**
+  * @brief Вывести статистику в поток текстом
+  * @param schedule Расписание (для названий худших мероприятий)
+  * @param stats Статистика
+  * @param options Параметры, с которыми она посчитана (для подписей процентилей)
+  * @param out Поток вывода
+  */
+ void writeScheduleStats(const ScheduleStore& schedule, const ScheduleStats& stats,
+                         const ScheduleStatsOptions& options, std::ostream& out);
+
+ #endif
@@ -0,0 +1,425 @@
+/**
+ * @file schedulecommands.cpp
+ * @brief Реализация неинтерактивного выполнения команд
+ */
+
+ #include "schedulecommands.h"
+ #include "conflicts.h"
+ #include "scheduleanalytics.h"
+ #include "schedulefile.h"
+ #include "scheduleio.h"
+ #include "time.h"
+ #include "timespan.h"
+ #include "tracing.h"
+ #include <charconv>
+ #include <cstring>
+ #include <fstream>
+ #include <istream>
+ #include <ostream>
+ #include <string_view>
+
+ using namespace std;
+
+ namespace {
+
+ bool isBlank(char c) {
+     return c == ' ' || c == '\t' || c == '\r';
+ }
+
+ // Следующее слово строки; пустое, если строка закончилась
+ string_view nextWord(const char*& p, const char* last) {
+     while (p < last && isBlank(*p)) p++;
+     const char* begin = p;
+     while (p < last && !isBlank(*p)) p++;
+     return string_view(begin, p - begin);
+ }
+
+ // Остаток строки без пробелов по краям
+ string_view restOfLine(const char* p, const char* last) {
+     while (p < last && isBlank(*p)) p++;
+     while (last > p && isBlank(last[-1])) last--;
+     return string_view(p, last - p);
+ }
+
+ bool parseSeconds(string_view word, int& seconds, string& error) {
+     TimeParseError result = Time::parse(word.data(), word.data() + word.size(), seconds).error;
+     if (result == TimeParseError::None) return true;
+     error = "время \"";
+     error += word;
+     error += "\": ";
+     error += Time::parseErrorText(result);
+     return false;
+ }
+
+ // Номер мероприятия из сценария (с 1) в позицию хранилища
+ bool parseIndex(const ScheduleStore& schedule, string_view word, int& index, string& error) {
+     int number = 0;
+     auto result = from_chars(word.data(), word.data() + word.size(), number);
+     if (word.empty() || result.ec != errc() || result.ptr != word.data() + word.size()) {
+         error = "ожидался номер мероприятия";
+         return false;
+     }
+     if (number < 1 || number > schedule.size()) {
+         error = "нет мероприятия с номером ";
+         error += word;
+         return false;
+     }
+     index = number - 1;
+     return true;
+ }
+
+ void appendTime(string& out, int seconds) {
+     char buffer[Time::maxFormattedLength];
+     out.append(buffer, Time::formatSeconds(seconds, buffer));
+ }
+
+ // Суммы длительностей выходят за int: часы без ограничения разрядов
+ void appendSpan(string& out, int64_t seconds) {
+     char buffer[TimeSpan64::maxFormattedLength];
+     out.append(buffer, TimeSpan64::fromSeconds(seconds).formatTo(buffer));
+ }
+ 
+ void writeConflicts(const ScheduleStore& schedule, const ConflictReport& report, ostream& out) {
+     string text;
+     text += "Пересечений: ";
+     text += to_string(report.overlaps.size());
+     text += '\n';
+     for (const EventConflict& c : report.overlaps) {
+         text += "  \"";
+         text += schedule.name(c.first);
+         text += "\" и \"";
+         text += schedule.name(c.second);
+         text += "\": ";
+         appendTime(text, c.overlapSeconds);
+         text += '\n';
+     }
+     text += "Коротких перерывов: ";
+     text += to_string(report.shortGaps.size());
+     text += '\n';
+     for (const ScheduleGap& g : report.shortGaps) {
+         text += "  после \"";
+         text += schedule.name(g.before);
+         text += "\" до \"";
+         text += schedule.name(g.after);
+         text += "\": ";
+         appendTime(text, g.gapSeconds);
+         text += '\n';
+     }
+     out.write(text.data(), text.size());
+ }
+
+ } // namespace
+
+ bool runCommand(ScheduleStore& schedule, const char* first, const char* last, ostream& out, string& error) {
+     const char* p = first;
+     string_view command = nextWord(p, last);
+     if (command.empty() || command[0] == '#') return true;
+
+     if (command == "add") {
+         int start, end, planned;
+         if (!parseSeconds(nextWord(p, last), start, error)) return false;
+         if (!parseSeconds(nextWord(p, last), end, error)) return false;
+         if (!parseSeconds(nextWord(p, last), planned, error)) return false;
+         string_view name = restOfLine(p, last);
+         if (name.empty()) {
+             error = "не указано название мероприятия";
+             return false;
+         }
+         TRACE_OPERATION(Add);
+         schedule.add(name, start, end, planned);
+         return true;
+     }
+     if (command == "edit") {
+         int index;
+         if (!parseIndex(schedule, nextWord(p, last), index, error)) return false;
+         string_view field = nextWord(p, last);
+         if (field == "name") {
+             string_view name = restOfLine(p, last);
+             if (name.empty()) {
+                 error = "не указано название мероприятия";
+                 return false;
+             }
+             TRACE_OPERATION(Edit);
+             schedule.setName(index, name);
+             return true;
+         }
+         int seconds;
+         if (field != "start" && field != "end" && field != "planned") {
+             error = "неизвестное поле \"";
+             error += field;
+             error += "\" (ожидалось name, start, end или planned)";
+             return false;
+         }
+         if (!parseSeconds(nextWord(p, last), seconds, error)) return false;
+         TRACE_OPERATION(Edit);
+         if (field == "start") schedule.setStart(index, seconds);
+         else if (field == "end") schedule.setEnd(index, seconds);
+         else schedule.setPlanned(index, seconds);
+         schedule.setActual(index, actualDurationSeconds(schedule.start(index), schedule.end(index)));
+         return true;
+     }
+     if (command == "delete") {
+         int index;
+         if (!parseIndex(schedule, nextWord(p, last), index, error)) return false;
+         TRACE_OPERATION(Delete);
+         schedule.remove(index);
+         return true;
+     }
+     if (command == "report") {
+         TRACE_OPERATION(List);
+         writeSchedule(schedule, out);
+         return true;
+     }
+     if (command == "totals") {
+         TRACE_OPERATION(Report);
+         writeTotals(schedule, out);
+         return true;
+     }
+     if (command == "stats") {
+         ScheduleStatsOptions options;
+         string_view word = nextWord(p, last);
+         if (!word.empty()) {
+             auto result = from_chars(word.data(), word.data() + word.size(), options.topCount);
+             if (result.ec != errc() || result.ptr != word.data() + word.size()) {
+                 error = "некорректное число худших мероприятий: ";
+                 error += word;
+                 return false;
+             }
+         }
+         TRACE_OPERATION(Report);
+         writeScheduleStats(schedule, analyzeSchedule(schedule, options), options, out);
+         return true;
+     }
+     if (command == "conflicts") {
+         ConflictOptions options;
+         if (!parseSeconds(nextWord(p, last), options.minGapSeconds, error)) return false;
+         TRACE_OPERATION(Report);
+         writeConflicts(schedule, findConflicts(schedule, options), out);
+         return true;
+     }
+     if (command == "repeat") {
+         int index;
+         if (!parseIndex(schedule, nextWord(p, last), index, error)) return false;
+         string_view rule = restOfLine(p, last);
+         if (rule == "off") {
+             schedule.clearRecurrence(index);
+             return true;
+         }
+         RecurrenceRule parsed;
+         if (!parseRecurrenceRule(rule, parsed, error)) return false;
+         TRACE_OPERATION(Edit);
+         schedule.setRecurrence(index, parsed);
+         return true;
+     }
+     if (command == "occurrences") {
+         int32_t day;
+         string_view word = nextWord(p, last);
+         if (!parseDate(word, day)) {
+             error = "ожидалась дата ГГГГ-ММ-ДД";
+             return false;
+         }
+         uint32_t days = 1;
+         word = nextWord(p, last);
+         if (!word.empty()) {
+             auto result = from_chars(word.data(), word.data() + word.size(), days);
+             if (result.ec != errc() || result.ptr != word.data() + word.size() || days == 0) {
+                 error = "некорректное число дней: ";
+                 error += word;
+                 return false;
+             }
+         }
+         TRACE_OPERATION(Report);
+         writeOccurrences(schedule, DateTime(day, 0), DateTime(day, int64_t(days) * DateTime::secondsPerDay), out);
+         return true;
+     }
+     if (command == "clear") {
+         schedule.clear();
+         return true;
+     }
+     if (command == "save" || command == "load") {
+         string path(restOfLine(p, last));
+         if (path.empty()) {
+             error = "не указан путь к файлу";
+             return false;
+         }
+         ScheduleFileError result = command == "save" ? saveSchedule(schedule, path.c_str())
+                                                      : loadSchedule(path.c_str(), schedule);
+         if (result == ScheduleFileError::None) return true;
+         error = path;
+         error += ": ";
+         error += scheduleFileErrorText(result);
+         return false;
+     }
+     if (command == "import" || command == "export") {
+         string path(restOfLine(p, last));
+         ScheduleFormat format;
+         if (!scheduleFormatFromPath(path, format)) {
+             error = "ожидался файл .csv или .jsonl";
+             return false;
+         }
+         if (command == "export") {
+             ofstream file(path, ios::binary);
+             if (file) exportSchedule(schedule, format, file);
+             if (!file) {
+                 error = path + ": ошибка записи файла";
+                 return false;
+             }
+             if (!schedule.recurrences().empty()) {
+                 out << "внимание: правила повторения (" << schedule.recurrences().size()
+                     << ") не входят в " << path << ", их сохраняет только save\n";
+             }
+             return true;
+         }
+         ifstream file(path, ios::binary);
+         if (!file) {
+             error = path + ": не удалось открыть файл";
+             return false;
+         }
+         // Ошибочные строки пропускаются; команда считается неуспешной,
+         // если они были, но принятые мероприятия остаются в расписании
+         vector<ImportError> rejected;
+         ImportStats stats = importSchedule(file, format, schedule, &rejected, 1);
+         if (stats.rejected == 0) return true;
+         error = path + ": принято " + to_string(stats.imported) + ", отклонено " + to_string(stats.rejected)
+               + " (строка " + to_string(rejected[0].line) + ": " + rejected[0].message + ")";
+         return false;
+     }
+     error = "неизвестная команда \"";
+     error += command;
+     error += "\"";
+     return false;
+ }
+
+ CommandStats runCommands(ScheduleStore& schedule, const char* first, const char* last, ostream& out,
+                          vector<CommandError>* errors, size_t firstLine) {
+     CommandStats stats;
+     string error;
+     size_t line = firstLine;
+     while (first < last) {
+         const char* newline = static_cast<const char*>(memchr(first, '\n', last - first));
+         const char* lineEnd = newline ? newline : last;
+         stats.lines++;
+
+         const char* p = first;
+         string_view command = nextWord(p, lineEnd);
+         if (!command.empty() && command[0] != '#') {
+             if (runCommand(schedule, first, lineEnd, out, error)) {
+                 stats.commands++;
+             } else {
+                 stats.errors++;
+                 if (errors) errors->push_back(CommandError{line, error});
+             }
+         }
+         line++;
+         first = newline ? newline + 1 : last;
+     }
+     return stats;
+ }
+
+ CommandStats runCommandStream(ScheduleStore& schedule, istream& in, ostream& out, vector<CommandError>* errors) {
+     CommandStats total;
+     vector<char> buffer(1 << 20);
+     size_t pending = 0; // Незаконченная строка, перенесённая в начало буфера
+
+     auto run = [&](const char* begin, const char* end) {
+         CommandStats part = runCommands(schedule, begin, end, out, errors, total.lines + 1);
+         total.commands += part.commands;
+         total.errors += part.errors;
+         total.lines += part.lines;
+     };
+
+     while (true) {
+         in.read(buffer.data() + pending, buffer.size() - pending);
+         size_t got = static_cast<size_t>(in.gcount());
+         if (got == 0) {
+             run(buffer.data(), buffer.data() + pending);
+             break;
+         }
+         size_t filled = pending + got;
+
+         // Выполняются только целые строки; хвост ждёт следующего блока
+         const char* begin = buffer.data();
+         const char* end = begin + filled;
+         while (end > begin && end[-1] != '\n') end--;
+         if (end == begin) {
+             if (filled == buffer.size()) buffer.resize(buffer.size() * 2); // Строка длиннее блока
+             pending = filled;
+             continue;
+         }
+         run(begin, end);
+         pending = begin + filled - end;
+         memmove(buffer.data(), end, pending);
+     }
+     return total;
+ }
+
+ void writeSchedule(const ScheduleStore& schedule, ostream& out) {
+     const size_t flushSize = 1 << 16;
+     string text;
+     text.reserve(flushSize + 256);
+     char number[16];
+
+     for (int i = 0; i < schedule.size(); i++) {
+         text.append(number, to_chars(number, number + sizeof(number), i + 1).ptr);
+         text += ". ";
+         text += schedule.name(i);
+         text += "\n   Начало: ";
+         appendTime(text, schedule.start(i));
+         text += " | Конец: ";
+         appendTime(text, schedule.end(i));
+         text += "\n   План: ";
+         appendTime(text, schedule.planned(i));
+         text += " | Факт: ";
+         appendTime(text, schedule.actual(i));
+         text += "\n\n";
+
+         if (text.size() >= flushSize) {
+             out.write(text.data(), text.size());
+             text.clear();
+         }
+     }
+     out.write(text.data(), text.size());
+ }
+
+ void writeTotals(const ScheduleStore& schedule, ostream& out) {
+     const ScheduleTotals& totals = schedule.totals();
+     string text;
+     text += "Мероприятий: ";
+     text += to_string(totals.count());
+     text += "\nСумма плана: ";
+     appendSpan(text, totals.plannedSeconds());
+     text += " | Сумма факта: ";
+     appendSpan(text, totals.actualSeconds());
+     text += "\nОпозданий: ";
+     text += to_string(totals.overrunCount());
+     if (totals.count() > 0) {
+         text += "\nСамое раннее начало: ";
+         appendTime(text, totals.earliestStart());
+         text += " | Самый поздний конец: ";
+         appendTime(text, totals.latestEnd());
+     }
+     text += '\n';
+     out.write(text.data(), text.size());
+ }
+
+ void writeOccurrences(const ScheduleStore& schedule, DateTime from, DateTime to, ostream& out, size_t maxShown) {
+     vector<Occurrence> found;
+     bool more = earliestOccurrencesIn(schedule, from, to, maxShown, found);
+
+     string text;
+     text += "Повторений: ";
+     text += more ? "больше " + to_string(maxShown) : to_string(found.size());
+     text += '\n';
+     char moment[DateTime::maxFormattedLength];
+     for (const Occurrence& o : found) {
+         text += "  ";
+         text.append(moment, o.start.formatTo(moment));
+         text += " - ";
+         text.append(moment, o.end.formatTo(moment));
+         text += "  ";
+         text += schedule.name(schedule.indexOf(o.event));
+         text += '\n';
+     }
+     if (more) text += "  ...\n";
+     out.write(text.data(), text.size());
+ }
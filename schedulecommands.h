@@ -0,0 +1,130 @@
+/**
+ * @file schedulecommands.h
+ * @brief Неинтерактивное выполнение команд над расписанием (сценарии, пакетный режим)
+ */
+
+ #ifndef SCHEDULECOMMANDS_H
+ #define SCHEDULECOMMANDS_H
+
+ #include "datetime.h"
+ #include "schedulestore.h"
+ #include <cstddef>
+ #include <iosfwd>
+ #include <string>
+ #include <vector>
+
+ // Сценарий - текст, по одной команде в строке. Пустые строки и строки,
+ // начинающиеся с '#', пропускаются. Время записывается как Ч:ММ:СС,
+ // номера мероприятий - как в меню, начиная с 1.
+ //
+ //     add <начало> <конец> <план> <название до конца строки>
+ //     edit <номер> name <название до конца строки>
+ //     edit <номер> start|end|planned <время>
+ //     delete <номер>
+ //     report
+ //     totals
+ //     stats [число худших опозданий, по умолчанию 10]
+ //     conflicts <минимальный перерыв>
+ //     repeat <номер> <правило повторения> | off   (формат правила - recurrence.h)
+ //     occurrences <ГГГГ-ММ-ДД> [число дней, по умолчанию 1]
+ //     clear
+ //     save <путь к файлу расписания>
+ //     load <путь к файлу расписания>
+ //     import <путь к .csv или .jsonl>
+ //     export <путь к .csv или .jsonl>
+
+ /**
+  * @struct CommandError
+  * @brief Команда сценария, которая не была выполнена
+  */
+ struct CommandError {
+     size_t line;         ///< Номер строки, начиная с 1
+     std::string message; ///< Причина
+ };
+
+ /**
+  * @struct CommandStats
+  * @brief Итог выполнения сценария
+  */
+ struct CommandStats {
+     size_t commands = 0; ///< Выполненные команды
+     size_t errors = 0;   ///< Отклонённые команды
+     size_t lines = 0;    ///< Прочитанные строки (включая пустые и комментарии)
+ };
+
+ /**
+  * @brief Выполнить одну команду
+  * @param schedule Расписание
+  * @param first Начало строки (без '\n')
+  * @param last Конец строки
+  * @param out Поток для отчётов (report, conflicts)
+  * @param error Сюда записывается причина, если команда отклонена
+  * @return true, если команда выполнена или строка пустая
+  *
+  * Изменения выполняются так же, как в меню создания мероприятий:
+  * после правки начала или конца пересчитывается фактическая длительность.
+  */
+ bool runCommand(ScheduleStore& schedule, const char* first, const char* last,
+                 std::ostream& out, std::string& error);
+
+ /**
+  * @brief Выполнить все команды из буфера
+  * @param schedule Расписание
+  * @param first Начало текста
+  * @param last Конец текста
+  * @param out Поток для отчётов
+  * @param errors Если не nullptr, сюда дописываются отклонённые команды
+  * @param firstLine Номер первой строки буфера (для сообщений об ошибках)
+  * @return Счётчики выполненных и отклонённых команд
+  *
+  * Ошибочная команда не прерывает сценарий.
+  */
+ CommandStats runCommands(ScheduleStore& schedule, const char* first, const char* last, std::ostream& out,
+                          std::vector<CommandError>* errors = nullptr, size_t firstLine = 1);
+
+ /**
+  * @brief Выполнить сценарий из потока, читая его блоками
+  * @param schedule Расписание
+  * @param in Поток со сценарием (файл или std::cin)
+  * @param out Поток для отчётов
+  * @param errors Если не nullptr, сюда дописываются отклонённые команды
+  * @return Счётчики выполненных и отклонённых команд
+  */
+ CommandStats runCommandStream(ScheduleStore& schedule, std::istream& in, std::ostream& out,
+                               std::vector<CommandError>* errors = nullptr);
+
+ /**
+  * @brief Вывести полное расписание (начало, конец, план, факт)
+  * @param schedule Расписание
+  * @param out Поток вывода
+  *
+  * Строки собираются в буфер и выводятся крупными блоками.
+  */
+ void writeSchedule(const ScheduleStore& schedule, std::ostream& out);
+
+ /**
+  * @brief Вывести итоги расписания: суммы плана и факта, опоздания, крайние времена
+  * @param schedule Расписание
+  * @param out Поток вывода
+  *
+  * Итоги поддерживаются хранилищем при каждом изменении, поэтому
+  * вывод не проходит по мероприятиям.
+  */
+ void writeTotals(const ScheduleStore& schedule, std::ostream& out);
+
+ /**
+  * @brief Вывести повторения серий, пересекающиеся с окном [from, to), по времени начала
+  * @param schedule Расписание
+  * @param from Начало окна
+  * @param to Конец окна
+  * @param out Поток вывода
+  * @param maxShown Наибольшее число выводимых повторений
+  *
+  * Выводятся самые ранние maxShown повторений (earliestOccurrencesIn),
+  * так что вывод длинного окна ограничен по памяти; если повторений
+  * больше, в конце выводится "...".
+  */
+ void writeOccurrences(const ScheduleStore& schedule, DateTime from, DateTime to, std::ostream& out,
+                       size_t maxShown = 1000);
+
+ #endif
@@ -0,0 +1,296 @@
+/**
+ * @file schedulefile.cpp
+ * @brief Реализация двоичного файла расписания
+ */
+
+ #include "schedulefile.h"
+ #include <cerrno>
+ #include <cstdio>
+ #include <cstring>
+ #include <string>
+ #include <vector>
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+
+ using namespace std;
+
+ namespace {
+
+ const char fileMagic[8] = {'O', 'O', 'P', '2', 'S', 'C', 'H', 'D'};
+ const uint32_t fileVersion = 2;
+ const uint32_t oldestVersion = 1; // Без правил повторения
+ const uint32_t byteOrderMark = 0x01020304;
+
+ // Размер файла с count мероприятиями, ruleCount правилами и таблицей строк namesSize
+ uint64_t expectedFileSize(uint64_t count, uint64_t ruleCount, uint64_t namesSize) {
+     return sizeof(ScheduleFileHeader) + count * 6 * sizeof(int32_t) + ruleCount * sizeof(ScheduleFileRule) + namesSize;
+ }
+
+ // Правило, которое могли записать saveSchedule и RecurrenceRule::weekly
+ bool validRule(const ScheduleFileRule& rule, uint64_t count) {
+     if (rule.event >= count || rule.interval == 0 || rule.reserved != 0 || rule.weekdays > 0x7F) return false;
+     switch (static_cast<RecurrenceKind>(rule.kind)) {
+         case RecurrenceKind::EveryMinutes:
+         case RecurrenceKind::Daily:
+             return rule.weekdays == 0;
+         case RecurrenceKind::Weekly:
+             return rule.weekdays != 0;
+     }
+     return false;
+ }
+
+ // Запись с повтором после частичной записи и прерывания сигналом
+ bool writeAll(int fd, const void* data, size_t size) {
+     const char* p = static_cast<const char*>(data);
+     while (size > 0) {
+         ssize_t written = ::write(fd, p, size);
+         if (written < 0) {
+             if (errno == EINTR) continue;
+             return false;
+         }
+         p += written;
+         size -= static_cast<size_t>(written);
+     }
+     return true;
+ }
+
+ // Буфер записи: столбцы и названия уходят в файл блоками по 1 МиБ
+ class BlockWriter {
+ private:
+     int fd_;
+     vector<char> buffer_;
+     bool ok_ = true;
+
+ public:
+     explicit BlockWriter(int fd) : fd_(fd) { buffer_.reserve(1 << 20); }
+
+     void append(const void* data, size_t size) {
+         if (buffer_.size() + size > buffer_.capacity()) flush();
+         if (size > buffer_.capacity()) {
+             ok_ = ok_ && writeAll(fd_, data, size);
+             return;
+         }
+         const char* p = static_cast<const char*>(data);
+         buffer_.insert(buffer_.end(), p, p + size);
+     }
+
+     template <typename T>
+     void appendValue(T value) { append(&value, sizeof(value)); }
+
+     bool flush() {
+         ok_ = ok_ && writeAll(fd_, buffer_.data(), buffer_.size());
+         buffer_.clear();
+         return ok_;
+     }
+ };
+
+ } // namespace
+
+ const char* scheduleFileErrorText(ScheduleFileError error) {
+     switch (error) {
+         case ScheduleFileError::None: return "нет ошибки";
+         case ScheduleFileError::OpenFailed: return "не удалось открыть файл";
+         case ScheduleFileError::TooSmall: return "файл слишком короткий";
+         case ScheduleFileError::BadMagic: return "это не файл расписания";
+         case ScheduleFileError::UnsupportedVersion: return "неподдерживаемая версия формата";
+         case ScheduleFileError::WrongByteOrder: return "файл записан с другим порядком байтов";
+         case ScheduleFileError::Corrupt: return "файл повреждён";
+         case ScheduleFileError::TooLarge: return "расписание слишком велико для формата";
+         case ScheduleFileError::WriteFailed: return "ошибка записи файла";
+     }
+     return "неизвестная ошибка";
+ }
+
+ ScheduleFile::ScheduleFile(ScheduleFile&& other) noexcept {
+     *this = std::move(other);
+ }
+
+ ScheduleFile& ScheduleFile::operator=(ScheduleFile&& other) noexcept {
+     if (this != &other) {
+         close();
+         data_ = other.data_;
+         size_ = other.size_;
+         header_ = other.header_;
+         start_ = other.start_;
+         end_ = other.end_;
+         planned_ = other.planned_;
+         actual_ = other.actual_;
+         nameOffset_ = other.nameOffset_;
+         nameLength_ = other.nameLength_;
+         rules_ = other.rules_;
+         names_ = other.names_;
+         other.data_ = nullptr;
+         other.size_ = 0;
+         other.header_ = nullptr;
+     }
+     return *this;
+ }
+
+ ScheduleFile::~ScheduleFile() {
+     close();
+ }
+
+ void ScheduleFile::close() {
+     if (data_) munmap(const_cast<char*>(data_), size_);
+     data_ = nullptr;
+     size_ = 0;
+     header_ = nullptr;
+ }
+
+ ScheduleFileError ScheduleFile::open(const char* path) {
+     close();
+     int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+     if (fd < 0) return ScheduleFileError::OpenFailed;
+     struct stat info;
+     if (fstat(fd, &info) != 0) {
+         ::close(fd);
+         return ScheduleFileError::OpenFailed;
+     }
+     size_t size = static_cast<size_t>(info.st_size);
+     if (size < sizeof(ScheduleFileHeader)) {
+         ::close(fd);
+         return ScheduleFileError::TooSmall;
+     }
+     void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+     ::close(fd); // Отображение остаётся действительным без дескриптора
+     if (mapped == MAP_FAILED) return ScheduleFileError::OpenFailed;
+
+     const ScheduleFileHeader* header = static_cast<const ScheduleFileHeader*>(mapped);
+     ScheduleFileError error = ScheduleFileError::None;
+     if (memcmp(header->magic, fileMagic, sizeof(fileMagic)) != 0) {
+         error = ScheduleFileError::BadMagic;
+     } else if (header->version < oldestVersion || header->version > fileVersion) {
+         error = ScheduleFileError::UnsupportedVersion;
+     } else if (header->byteOrder != byteOrderMark) {
+         error = ScheduleFileError::WrongByteOrder;
+     } else if (header->count > INT32_MAX || header->namesSize > UINT32_MAX || header->ruleCount > header->count
+                || (header->version == 1 && header->ruleCount != 0) || header->fileSize != size
+                || expectedFileSize(header->count, header->ruleCount, header->namesSize) != size) {
+         error = ScheduleFileError::Corrupt;
+     }
+     if (error != ScheduleFileError::None) {
+         munmap(mapped, size);
+         return error;
+     }
+
+     data_ = static_cast<const char*>(mapped);
+     size_ = size;
+     header_ = header;
+     size_t count = static_cast<size_t>(header->count);
+     const int32_t* columns = reinterpret_cast<const int32_t*>(data_ + sizeof(ScheduleFileHeader));
+     start_ = columns;
+     end_ = columns + count;
+     planned_ = columns + 2 * count;
+     actual_ = columns + 3 * count;
+     nameOffset_ = reinterpret_cast<const uint32_t*>(columns + 4 * count);
+     nameLength_ = reinterpret_cast<const uint32_t*>(columns + 5 * count);
+     rules_ = reinterpret_cast<const ScheduleFileRule*>(columns + 6 * count);
+     names_ = reinterpret_cast<const char*>(rules_ + header->ruleCount);
+
+     // Названия не должны выходить за таблицу строк
+     for (size_t i = 0; i < count; i++) {
+         if (static_cast<uint64_t>(nameOffset_[i]) + nameLength_[i] > header->namesSize) {
+             close();
+             return ScheduleFileError::Corrupt;
+         }
+     }
+     for (size_t i = 0; i < header->ruleCount; i++) {
+         if (!validRule(rules_[i], count)) {
+             close();
+             return ScheduleFileError::Corrupt;
+         }
+     }
+     return ScheduleFileError::None;
+ }
+
+ RecurrenceRule ScheduleFile::rule(int i) const {
+     const ScheduleFileRule& r = rules_[i];
+     RecurrenceRule rule;
+     rule.kind = static_cast<RecurrenceKind>(r.kind);
+     rule.weekdays = r.weekdays;
+     rule.interval = r.interval;
+     rule.firstDay = r.firstDay;
+     rule.untilDay = r.untilDay;
+     return rule;
+ }
+
+ void ScheduleFile::copyTo(ScheduleStore& schedule) const {
+     if (!header_) {
+         schedule.clear();
+         return;
+     }
+     schedule.assign(static_cast<size_t>(header_->count), start_, end_, planned_, actual_,
+                     nameOffset_, nameLength_, names_, static_cast<size_t>(header_->namesSize));
+     for (int i = 0; i < ruleCount(); i++) schedule.setRecurrence(ruleEvent(i), rule(i));
+ }
+
+ ScheduleFileError loadSchedule(const char* path, ScheduleStore& schedule) {
+     ScheduleFile file;
+     ScheduleFileError error = file.open(path);
+     if (error == ScheduleFileError::None) file.copyTo(schedule);
+     return error;
+ }
+
+ ScheduleFileError saveSchedule(const ScheduleStore& schedule, const char* path) {
+     size_t count = static_cast<size_t>(schedule.size());
+     uint64_t namesSize = 0;
+     for (size_t i = 0; i < count; i++) namesSize += schedule.name(static_cast<int>(i)).size();
+     if (namesSize > UINT32_MAX) return ScheduleFileError::TooLarge;
+
+     ScheduleFileHeader header;
+     memset(&header, 0, sizeof(header));
+     memcpy(header.magic, fileMagic, sizeof(fileMagic));
+     header.version = fileVersion;
+     header.byteOrder = byteOrderMark;
+     header.count = count;
+     header.namesSize = namesSize;
+     header.ruleCount = schedule.recurrences().size();
+     header.fileSize = expectedFileSize(count, header.ruleCount, namesSize);
+
+     string temporary = string(path) + ".tmp";
+     int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+     if (fd < 0) return ScheduleFileError::OpenFailed;
+
+     BlockWriter out(fd);
+     out.append(&header, sizeof(header));
+     out.append(schedule.startColumn(), count * sizeof(int32_t));
+     out.append(schedule.endColumn(), count * sizeof(int32_t));
+     out.append(schedule.plannedColumn(), count * sizeof(int32_t));
+     out.append(schedule.actualColumn(), count * sizeof(int32_t));
+     // Названия записываются подряд в порядке мероприятий
+     uint32_t offset = 0;
+     for (size_t i = 0; i < count; i++) {
+         out.appendValue(offset);
+         offset += static_cast<uint32_t>(schedule.name(static_cast<int>(i)).size());
+     }
+     for (size_t i = 0; i < count; i++) {
+         out.appendValue(static_cast<uint32_t>(schedule.name(static_cast<int>(i)).size()));
+     }
+     const RecurrenceTable& rules = schedule.recurrences();
+     for (size_t i = 0; i < rules.size(); i++) {
+         const RecurrenceRule& rule = rules.rule(i);
+         ScheduleFileRule record;
+         memset(&record, 0, sizeof(record));
+         record.event = static_cast<uint32_t>(schedule.indexOf(rules.owner(i)));
+         record.kind = static_cast<uint8_t>(rule.kind);
+         record.weekdays = rule.weekdays;
+         record.interval = rule.interval;
+         record.firstDay = rule.firstDay;
+         record.untilDay = rule.untilDay;
+         out.appendValue(record);
+     }
+     for (size_t i = 0; i < count; i++) {
+         string_view name = schedule.name(static_cast<int>(i));
+         out.append(name.data(), name.size());
+     }
+
+     bool ok = out.flush() && fsync(fd) == 0;
+     ok = ::close(fd) == 0 && ok;
+     if (!ok || rename(temporary.c_str(), path) != 0) {
+         unlink(temporary.c_str());
+         return ScheduleFileError::WriteFailed;
+     }
+     return ScheduleFileError::None;
+ }
@@ -0,0 +1,178 @@
+/**
+ * @file schedulefile.h
+ * @brief Двоичный файл расписания, открываемый через mmap
+ */
+
+ #ifndef SCHEDULEFILE_H
+ #define SCHEDULEFILE_H
+
+ #include "schedulestore.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <string_view>
+
+ // Формат (версия 2, порядок байтов - little-endian):
+ //
+ //     ScheduleFileHeader                       64 байта
+ //     int32_t  start[count]                    начало, секунды
+ //     int32_t  end[count]                      конец
+ //     int32_t  planned[count]                  плановая длительность
+ //     int32_t  actual[count]                   фактическая длительность
+ //     uint32_t nameOffset[count]               смещение названия в таблице строк
+ //     uint32_t nameLength[count]               длина названия
+ //     ScheduleFileRule rules[ruleCount]        правила повторения (с версии 2)
+ //     char     names[namesSize]                таблица строк (без нулевых символов)
+ //
+ // Все столбцы имеют фиксированную ширину, поэтому открытие файла не
+ // требует разбора: поля читаются прямо из отображённой памяти. Файлы
+ // версии 1 (без правил, ruleCount в заголовке - нули) тоже читаются.
+
+ /**
+  * @struct ScheduleFileHeader
+  * @brief Заголовок файла расписания
+  */
+ struct ScheduleFileHeader {
+     char magic[8];         ///< "OOP2SCHD"
+     uint32_t version;      ///< Версия формата
+     uint32_t byteOrder;    ///< 0x01020304 в порядке байтов записавшей машины
+     uint64_t count;        ///< Число мероприятий
+     uint64_t namesSize;    ///< Размер таблицы строк, байты
+     uint64_t fileSize;     ///< Полный размер файла, байты
+     uint64_t ruleCount;    ///< Число правил повторения (в версии 1 - ноль)
+     uint8_t reserved[16];  ///< Нули (для будущих версий)
+ };
+
+ static_assert(sizeof(ScheduleFileHeader) == 64, "Заголовок файла расписания должен занимать 64 байта");
+
+ /**
+  * @struct ScheduleFileRule
+  * @brief Правило повторения в файле: RecurrenceRule и позиция мероприятия
+  */
+ struct ScheduleFileRule {
+     uint32_t event;    ///< Позиция мероприятия
+     uint8_t kind;      ///< RecurrenceKind
+     uint8_t weekdays;  ///< Маска дней недели
+     uint16_t reserved; ///< Ноль
+     uint32_t interval; ///< Шаг повторения
+     int32_t firstDay;  ///< День первого повторения
+     int32_t untilDay;  ///< День конца серии
+ };
+
+ static_assert(sizeof(ScheduleFileRule) == 20, "Правило в файле должно занимать 20 байт");
+
+ /**
+  * @brief Результат открытия или записи файла расписания
+  */
+ enum class ScheduleFileError {
+     None,               ///< Успех
+     OpenFailed,         ///< Файл не открывается или не отображается в память
+     TooSmall,           ///< Файл короче заголовка
+     BadMagic,           ///< Это не файл расписания
+     UnsupportedVersion, ///< Версия формата не поддерживается
+     WrongByteOrder,     ///< Файл записан машиной с другим порядком байтов
+     Corrupt,            ///< Размеры, смещения названий или правила не сходятся
+     TooLarge,           ///< Расписание не помещается в формат (названия длиннее 4 ГиБ)
+     WriteFailed         ///< Ошибка записи или переименования
+ };
+
+ /**
+  * @brief Текст ошибки для сообщений пользователю
+  */
+ const char* scheduleFileErrorText(ScheduleFileError error);
+
+ /**
+  * @class ScheduleFile
+  * @brief Файл расписания, отображённый в память только для чтения
+  *
+  * Открытие проверяет заголовок и смещения названий и не выделяет
+  * память под мероприятия: поля читаются прямо из отображения.
+  * Объект можно перемещать, но не копировать.
+  */
+ class ScheduleFile {
+ private:
+     const char* data_ = nullptr;              ///< Начало отображения
+     size_t size_ = 0;                         ///< Размер отображения
+     const ScheduleFileHeader* header_ = nullptr;
+     const int32_t* start_ = nullptr;
+     const int32_t* end_ = nullptr;
+     const int32_t* planned_ = nullptr;
+     const int32_t* actual_ = nullptr;
+     const uint32_t* nameOffset_ = nullptr;
+     const uint32_t* nameLength_ = nullptr;
+     const ScheduleFileRule* rules_ = nullptr;
+     const char* names_ = nullptr;
+
+ public:
+     ScheduleFile() = default;
+     ScheduleFile(const ScheduleFile&) = delete;
+     ScheduleFile& operator=(const ScheduleFile&) = delete;
+     ScheduleFile(ScheduleFile&& other) noexcept;
+     ScheduleFile& operator=(ScheduleFile&& other) noexcept;
+     ~ScheduleFile();
+
+     /**
+      * @brief Отобразить файл в память
+      * @param path Путь к файлу
+      * @return ScheduleFileError::None при успехе
+      */
+     ScheduleFileError open(const char* path);
+
+     /**
+      * @brief Снять отображение
+      */
+     void close();
+
+     bool isOpen() const { return data_ != nullptr; } ///< Файл открыт
+
+     /**
+      * @brief Количество мероприятий
+      */
+     int size() const { return header_ ? static_cast<int>(header_->count) : 0; }
+
+     // Доступ к полям по позиции
+     std::string_view name(int index) const {
+         return std::string_view(names_ + nameOffset_[index], nameLength_[index]);
+     }
+     int32_t start(int index) const { return start_[index]; }     ///< Начало
+     int32_t end(int index) const { return end_[index]; }         ///< Конец
+     int32_t planned(int index) const { return planned_[index]; } ///< Плановая длительность
+     int32_t actual(int index) const { return actual_[index]; }   ///< Фактическая длительность
+
+     /**
+      * @brief Число правил повторения
+      */
+     int ruleCount() const { return header_ ? static_cast<int>(header_->ruleCount) : 0; }
+
+     int ruleEvent(int i) const { return static_cast<int>(rules_[i].event); } ///< Позиция мероприятия i-го правила
+     RecurrenceRule rule(int i) const;                                        ///< i-е правило
+
+     /**
+      * @brief Скопировать содержимое и правила повторения в хранилище (заменяя его)
+      * @param schedule Хранилище
+      */
+     void copyTo(ScheduleStore& schedule) const;
+ };
+
+ /**
+  * @brief Загрузить расписание из файла
+  * @param path Путь к файлу
+  * @param schedule Хранилище; при ошибке не меняется
+  * @return ScheduleFileError::None при успехе
+  */
+ ScheduleFileError loadSchedule(const char* path, ScheduleStore& schedule);
+
+ /**
+  * @brief Атомарно записать расписание в файл
+  * @param schedule Хранилище
+  * @param path Путь к файлу
+  * @return ScheduleFileError::None при успехе
+  *
+  * Данные пишутся во временный файл рядом с целевым, сбрасываются на
+  * диск и переименовываются поверх него: при сбое на диске остаётся
+  * либо прежний файл, либо новый целиком. Мусор в таблице строк
+  * (от удалений и правок названий) не записывается. Правила повторения
+  * сохраняются вместе с мероприятиями.
+  */
+ ScheduleFileError saveSchedule(const ScheduleStore& schedule, const char* path);
+
+ #endif
@@ -0,0 +1,695 @@
+/**
+ * @file scheduleio.cpp
+ * @brief Реализация потокового импорта и экспорта расписания
+ */
+
+ #include "scheduleio.h"
+ #include "time.h"
+ #include <algorithm>
+ #include <cctype>
+ #include <cstring>
+ #include <deque>
+ #include <istream>
+ #include <ostream>
+
+ using namespace std;
+
+ namespace {
+
+ const size_t blockSize = 1 << 20;
+ const size_t flushSize = 1 << 16;
+ const size_t maxRecordSize = 4 << 20; // Запись длиннее отклоняется (незакрытая кавычка не съедает файл)
+ const int maxJsonDepth = 64; // Вложенность пропускаемых значений JSON
+
+ // Обязательные поля в порядке столбцов по умолчанию
+ enum Field { NameField, StartField, EndField, PlannedField, FieldCount };
+ const char* const fieldNames[FieldCount] = {"name", "startTime", "endTime", "plannedDuration"};
+
+ int fieldByName(string_view key) {
+     for (int f = 0; f < FieldCount; f++) {
+         if (key == fieldNames[f]) return f;
+     }
+     return -1;
+ }
+
+ // Чтение блоками: непрочитанный хвост переносится в начало буфера
+ class BlockReader {
+ private:
+     istream& in_;
+     vector<char> buffer_;
+     size_t begin_ = 0;
+     size_t end_ = 0;
+     bool eof_ = false;
+
+ public:
+     explicit BlockReader(istream& in) : in_(in), buffer_(blockSize) {}
+
+     const char* begin() const { return buffer_.data() + begin_; }
+     const char* end() const { return buffer_.data() + end_; }
+     bool eof() const { return eof_; }
+     void consume(const char* p) { begin_ = static_cast<size_t>(p - buffer_.data()); }
+
+     // Незаконченная запись уже не меньше предела и дочитываться не должна
+     bool overlong() const { return end_ - begin_ >= maxRecordSize; }
+
+     // Пропустить данные до следующего перевода строки включительно
+     void skipLine() {
+         while (true) {
+             const char* newline = static_cast<const char*>(memchr(begin(), '\n', end_ - begin_));
+             if (newline) {
+                 consume(newline + 1);
+                 return;
+             }
+             begin_ = end_;
+             if (!fill()) return;
+         }
+     }
+
+     // Дочитать следующий блок; false, если поток закончился
+     bool fill() {
+         if (eof_) return false;
+         memmove(buffer_.data(), begin(), end_ - begin_);
+         end_ -= begin_;
+         begin_ = 0;
+         if (end_ == buffer_.size()) buffer_.resize(buffer_.size() * 2); // Запись длиннее блока
+         in_.read(buffer_.data() + end_, buffer_.size() - end_);
+         size_t got = static_cast<size_t>(in_.gcount());
+         end_ += got;
+         if (got == 0) eof_ = true;
+         return got > 0;
+     }
+ };
+
+ // Разбор одной записи: Record - запись готова, NeedMore - нужен следующий
+ // блок, Malformed - запись пропущена до конца строки
+ enum class Step { Record, NeedMore, Malformed };
+
+ class ErrorLog {
+ private:
+     ImportStats& stats_;
+     vector<ImportError>* errors_;
+     size_t maxErrors_;
+
+ public:
+     ErrorLog(ImportStats& stats, vector<ImportError>* errors, size_t maxErrors)
+         : stats_(stats), errors_(errors), maxErrors_(maxErrors) {}
+
+     void reject(size_t line, string message) {
+         stats_.rejected++;
+         if (errors_ && errors_->size() < maxErrors_) errors_->push_back(ImportError{line, std::move(message)});
+     }
+ };
+
+ bool parseTimeField(string_view text, Field field, int32_t& seconds, string& error) {
+     int value;
+     TimeParseError result = Time::parse(text.data(), text.data() + text.size(), value).error;
+     if (result != TimeParseError::None) {
+         error = fieldNames[field];
+         error += ": ";
+         error += Time::parseErrorText(result);
+         return false;
+     }
+     seconds = value;
+     return true;
+ }
+
+ // Проверка полей записи по правилам интерактивного ввода
+ bool makeEvent(const string_view (&values)[FieldCount], ImportedEvent& event, string& error) {
+     if (values[NameField].empty()) {
+         error = "не указано название мероприятия";
+         return false;
+     }
+     event.name = values[NameField];
+     return parseTimeField(values[StartField], StartField, event.start, error)
+         && parseTimeField(values[EndField], EndField, event.end, error)
+         && parseTimeField(values[PlannedField], PlannedField, event.planned, error);
+ }
+
+ // ---------------------------------------------------------------- CSV
+
+ // Поля записи CSV: указывают прямо в буфер чтения, а поля с удвоенными
+ // кавычками - в строки scratch, которые переиспользуются между записями
+ struct CsvFields {
+     vector<string_view> values;
+     deque<string> scratch; // deque: добавление не перемещает уже собранные строки
+     size_t count = 0;
+
+     string_view& add() {
+         if (count == values.size()) {
+             values.emplace_back();
+             scratch.emplace_back();
+         }
+         return values[count++];
+     }
+ };
+
+ Step parseCsvRecord(const char* p, const char* end, bool atEof, CsvFields& fields, size_t& newlines,
+                     const char*& next) {
+     fields.count = 0;
+     newlines = 0;
+     while (true) {
+         string_view& field = fields.add();
+
+         if (p < end && *p == '"') {
+             p++;
+             const char* begin = p;
+             string* unescaped = nullptr;
+             while (true) {
+                 const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+                 if (!quote) {
+                     if (!atEof) return Step::NeedMore;
+                     next = end; // Незакрытая кавычка в конце файла
+                     return Step::Malformed;
+                 }
+                 newlines += count(p, quote, '\n');
+                 if (unescaped) unescaped->append(p, quote);
+                 p = quote + 1;
+                 if (p == end && !atEof) return Step::NeedMore;
+                 if (p < end && *p == '"') {
+                     // Удвоенная кавычка: дальше поле собирается в отдельной строке
+                     if (!unescaped) {
+                         unescaped = &fields.scratch[fields.count - 1];
+                         unescaped->assign(begin, p);
+                     } else {
+                         unescaped->push_back('"');
+                     }
+                     p++;
+                     continue;
+                 }
+                 field = unescaped ? string_view(*unescaped) : string_view(begin, quote - begin);
+                 break;
+             }
+         } else {
+             const char* q = p;
+             while (q < end && *q != ',' && *q != '\n') q++;
+             if (q == end && !atEof) return Step::NeedMore;
+             const char* fieldEnd = q;
+             if (fieldEnd > p && fieldEnd[-1] == '\r') fieldEnd--;
+             field = string_view(p, fieldEnd - p);
+             p = q;
+         }
+
+         if (p == end) {
+             next = end;
+             return Step::Record;
+         }
+         if (*p == ',') {
+             p++;
+             continue;
+         }
+         if (*p == '\r') {
+             if (p + 1 == end && !atEof) return Step::NeedMore;
+             if (p + 1 == end || p[1] == '\n') p++;
+         }
+         if (p == end || *p == '\n') {
+             next = p == end ? end : p + 1;
+             if (p != end) newlines++;
+             return Step::Record;
+         }
+         // Символы после закрывающей кавычки: пропустить до конца строки
+         const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+         if (!newline && !atEof) return Step::NeedMore;
+         next = newline ? newline + 1 : end;
+         if (newline) newlines++;
+         return Step::Malformed;
+     }
+ }
+
+ void importCsv(BlockReader& reader, const function<void(const ImportedEvent&)>& sink, ErrorLog& log,
+                ImportStats& stats) {
+     CsvFields fields;
+     int column[FieldCount] = {-1, -1, -1, -1};
+     size_t columnCount = 0;
+     bool haveHeader = false;
+     size_t line = 1;
+     string error;
+
+     reader.fill();
+     // Метка порядка байтов UTF-8 перед заголовком
+     if (reader.end() - reader.begin() >= 3 && memcmp(reader.begin(), "\xEF\xBB\xBF", 3) == 0) {
+         reader.consume(reader.begin() + 3);
+     }
+     while (true) {
+         const char* p = reader.begin();
+         if (p == reader.end()) {
+             if (!reader.fill()) break;
+             continue;
+         }
+         size_t newlines;
+         const char* next;
+         Step step = parseCsvRecord(p, reader.end(), reader.eof(), fields, newlines, next);
+         if (step == Step::NeedMore) {
+             if (!reader.overlong()) {
+                 reader.fill();
+                 continue;
+             }
+             // Скорее всего, незакрытая кавычка: отклонить запись и продолжить
+             // со следующей строки, а не читать файл в память до конца
+             stats.records++;
+             log.reject(line++, "запись длиннее " + to_string(maxRecordSize >> 20) + " МиБ (незакрытая кавычка?)");
+             reader.skipLine();
+             continue;
+         }
+         size_t recordLine = line;
+         line += newlines;
+         reader.consume(next); // Поля остаются действительными до следующего fill()
+
+         size_t fieldCount = fields.count;
+         bool blank = fieldCount == 1 && fields.values[0].empty();
+         if (step == Step::Malformed) {
+             stats.records++;
+             log.reject(recordLine, "лишние символы после закрывающей кавычки или незакрытая кавычка");
+             continue;
+         }
+         if (blank) continue;
+
+         if (!haveHeader) {
+             haveHeader = true;
+             columnCount = fieldCount;
+             for (size_t i = 0; i < fieldCount; i++) {
+                 int f = fieldByName(fields.values[i]);
+                 if (f >= 0 && column[f] < 0) column[f] = static_cast<int>(i);
+             }
+             for (int f = 0; f < FieldCount; f++) {
+                 if (column[f] < 0) {
+                     log.reject(recordLine, string("в заголовке нет столбца ") + fieldNames[f]);
+                     return;
+                 }
+             }
+             continue;
+         }
+
+         stats.records++;
+         if (fieldCount != columnCount) {
+             log.reject(recordLine, "число полей " + to_string(fieldCount) + " вместо " + to_string(columnCount));
+             continue;
+         }
+         string_view values[FieldCount];
+         for (int f = 0; f < FieldCount; f++) values[f] = fields.values[column[f]];
+         ImportedEvent event;
+         if (!makeEvent(values, event, error)) {
+             log.reject(recordLine, error);
+             continue;
+         }
+         sink(event);
+         stats.imported++;
+     }
+ }
+
+ void appendCsvField(string& out, string_view text) {
+     bool quote = text.find_first_of(",\"\r\n") != string_view::npos
+               || (!text.empty() && (text.front() == ' ' || text.back() == ' '));
+     if (!quote) {
+         out += text;
+         return;
+     }
+     out += '"';
+     for (char c : text) {
+         if (c == '"') out += '"';
+         out += c;
+     }
+     out += '"';
+ }
+
+ // ---------------------------------------------------------------- JSON Lines
+
+ class JsonCursor {
+ private:
+     const char* p_;
+     const char* end_;
+
+ public:
+     JsonCursor(const char* p, const char* end) : p_(p), end_(end) {}
+
+     void skipBlanks() {
+         while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) p_++;
+     }
+     bool atEnd() {
+         skipBlanks();
+         return p_ == end_;
+     }
+     bool consume(char c) {
+         skipBlanks();
+         if (p_ < end_ && *p_ == c) {
+             p_++;
+             return true;
+         }
+         return false;
+     }
+     char peek() {
+         skipBlanks();
+         return p_ < end_ ? *p_ : '\0';
+     }
+
+     // Строка в кавычках с разбором escape-последовательностей
+     bool parseString(string& out, string& error) {
+         out.clear();
+         if (!consume('"')) {
+             error = "ожидалась строка";
+             return false;
+         }
+         while (p_ < end_) {
+             const char* stop = p_;
+             while (stop < end_ && *stop != '"' && *stop != '\\' && static_cast<unsigned char>(*stop) >= 0x20) stop++;
+             out.append(p_, stop);
+             p_ = stop;
+             if (p_ == end_) break;
+             char c = *p_++;
+             if (c == '"') return true;
+             if (c != '\\') {
+                 error = "управляющий символ внутри строки";
+                 return false;
+             }
+             if (p_ == end_) break;
+             char e = *p_++;
+             switch (e) {
+                 case '"': out += '"'; break;
+                 case '\\': out += '\\'; break;
+                 case '/': out += '/'; break;
+                 case 'b': out += '\b'; break;
+                 case 'f': out += '\f'; break;
+                 case 'n': out += '\n'; break;
+                 case 'r': out += '\r'; break;
+                 case 't': out += '\t'; break;
+                 case 'u': {
+                     uint32_t code;
+                     if (!parseHex(code)) {
+                         error = "неверная последовательность \\u";
+                         return false;
+                     }
+                     if (code >= 0xD800 && code < 0xDC00) {
+                         uint32_t low;
+                         if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') {
+                             error = "непарный суррогат в \\u";
+                             return false;
+                         }
+                         p_ += 2;
+                         if (!parseHex(low) || low < 0xDC00 || low >= 0xE000) {
+                             error = "непарный суррогат в \\u";
+                             return false;
+                         }
+                         code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                     } else if (code >= 0xDC00 && code < 0xE000) {
+                         error = "непарный суррогат в \\u";
+                         return false;
+                     }
+                     appendUtf8(out, code);
+                     break;
+                 }
+                 default:
+                     error = "неизвестная escape-последовательность";
+                     return false;
+             }
+         }
+         error = "незакрытая строка";
+         return false;
+     }
+
+     // Пропуск значения неизвестного ключа (включая вложенные объекты и массивы).
+     // Глубина ограничена: иначе строка из миллионов '[' переполнит стек
+     bool skipValue(string& scratch, string& error, int depth = 0) {
+         char c = peek();
+         if (c == '"') return parseString(scratch, error);
+         if (c == '{' || c == '[') {
+             if (depth == maxJsonDepth) {
+                 error = "вложенность больше " + to_string(maxJsonDepth) + " уровней";
+                 return false;
+             }
+             char close = c == '{' ? '}' : ']';
+             p_++;
+             if (consume(close)) return true;
+             do {
+                 if (c == '{') {
+                     if (!parseString(scratch, error)) return false;
+                     if (!consume(':')) {
+                         error = "ожидалось ':'";
+                         return false;
+                     }
+                 }
+                 if (!skipValue(scratch, error, depth + 1)) return false;
+             } while (consume(','));
+             if (!consume(close)) {
+                 error = "незакрытый объект или массив";
+                 return false;
+             }
+             return true;
+         }
+         const char* start = p_;
+         while (p_ < end_ && (isalnum(static_cast<unsigned char>(*p_)) || *p_ == '-' || *p_ == '+' || *p_ == '.')) p_++;
+         if (p_ == start) {
+             error = "ожидалось значение";
+             return false;
+         }
+         return true;
+     }
+
+ private:
+     bool parseHex(uint32_t& code) {
+         if (end_ - p_ < 4) return false;
+         code = 0;
+         for (int i = 0; i < 4; i++) {
+             char h = *p_++;
+             code <<= 4;
+             if (h >= '0' && h <= '9') code |= h - '0';
+             else if (h >= 'a' && h <= 'f') code |= h - 'a' + 10;
+             else if (h >= 'A' && h <= 'F') code |= h - 'A' + 10;
+             else return false;
+         }
+         return true;
+     }
+
+     static void appendUtf8(string& out, uint32_t code) {
+         if (code < 0x80) {
+             out += static_cast<char>(code);
+         } else if (code < 0x800) {
+             out += static_cast<char>(0xC0 | (code >> 6));
+             out += static_cast<char>(0x80 | (code & 0x3F));
+         } else if (code < 0x10000) {
+             out += static_cast<char>(0xE0 | (code >> 12));
+             out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+             out += static_cast<char>(0x80 | (code & 0x3F));
+         } else {
+             out += static_cast<char>(0xF0 | (code >> 18));
+             out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+             out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+             out += static_cast<char>(0x80 | (code & 0x3F));
+         }
+     }
+ };
+
+ // Разбор объекта одной строки; строки values переиспользуются
+ bool parseJsonRecord(const char* p, const char* end, string (&values)[FieldCount], bool (&present)[FieldCount],
+                      string& key, string& error) {
+     JsonCursor json(p, end);
+     for (bool& b : present) b = false;
+     if (!json.consume('{')) {
+         error = "ожидался объект JSON";
+         return false;
+     }
+     if (!json.consume('}')) {
+         do {
+             if (!json.parseString(key, error)) return false;
+             if (!json.consume(':')) {
+                 error = "ожидалось ':'";
+                 return false;
+             }
+             int f = fieldByName(key);
+             if (f < 0) {
+                 if (!json.skipValue(key, error)) return false;
+                 continue;
+             }
+             if (json.peek() != '"') {
+                 error = key + ": ожидалась строка";
+                 return false;
+             }
+             if (!json.parseString(values[f], error)) return false;
+             present[f] = true;
+         } while (json.consume(','));
+         if (!json.consume('}')) {
+             error = "ожидалось ',' или '}'";
+             return false;
+         }
+     }
+     if (!json.atEnd()) {
+         error = "лишние символы после объекта";
+         return false;
+     }
+     for (int f = 0; f < FieldCount; f++) {
+         if (!present[f]) {
+             error = string("нет поля ") + fieldNames[f];
+             return false;
+         }
+     }
+     return true;
+ }
+
+ void importJsonl(BlockReader& reader, const function<void(const ImportedEvent&)>& sink, ErrorLog& log,
+                  ImportStats& stats) {
+     string values[FieldCount];
+     bool present[FieldCount];
+     string key, error;
+     size_t line = 0;
+
+     reader.fill();
+     while (true) {
+         const char* p = reader.begin();
+         const char* newline = static_cast<const char*>(memchr(p, '\n', reader.end() - p));
+         if (!newline && !reader.eof()) {
+             if (!reader.overlong()) {
+                 reader.fill();
+                 continue;
+             }
+             stats.records++;
+             log.reject(++line, "строка длиннее " + to_string(maxRecordSize >> 20) + " МиБ");
+             reader.skipLine();
+             continue;
+         }
+         const char* lineEnd = newline ? newline : reader.end();
+         if (p == lineEnd && !newline) break;
+         line++;
+         reader.consume(newline ? newline + 1 : lineEnd);
+
+         const char* q = p;
+         while (q < lineEnd && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+         if (q == lineEnd) continue;
+
+         stats.records++;
+         if (!parseJsonRecord(q, lineEnd, values, present, key, error)) {
+             log.reject(line, error);
+             continue;
+         }
+         string_view views[FieldCount];
+         for (int f = 0; f < FieldCount; f++) views[f] = values[f];
+         ImportedEvent event;
+         if (!makeEvent(views, event, error)) {
+             log.reject(line, error);
+             continue;
+         }
+         sink(event);
+         stats.imported++;
+     }
+ }
+
+ void appendJsonString(string& out, string_view text) {
+     static const char hex[] = "0123456789abcdef";
+     out += '"';
+     for (char c : text) {
+         unsigned char u = static_cast<unsigned char>(c);
+         if (c == '"' || c == '\\') {
+             out += '\\';
+             out += c;
+         } else if (c == '\n') {
+             out += "\\n";
+         } else if (c == '\r') {
+             out += "\\r";
+         } else if (c == '\t') {
+             out += "\\t";
+         } else if (u < 0x20) {
+             out += "\\u00";
+             out += hex[u >> 4];
+             out += hex[u & 15];
+         } else {
+             out += c;
+         }
+     }
+     out += '"';
+ }
+
+ void appendTime(string& out, int32_t seconds) {
+     char buffer[Time::maxFormattedLength];
+     out.append(buffer, Time::formatSeconds(seconds, buffer));
+ }
+
+ } // namespace
+
+ bool scheduleFormatFromPath(string_view path, ScheduleFormat& format) {
+     size_t dot = path.rfind('.');
+     if (dot == string_view::npos) return false;
+     string extension(path.substr(dot + 1));
+     for (char& c : extension) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+     if (extension == "csv") {
+         format = ScheduleFormat::Csv;
+         return true;
+     }
+     if (extension == "jsonl" || extension == "ndjson" || extension == "json") {
+         format = ScheduleFormat::Jsonl;
+         return true;
+     }
+     return false;
+ }
+
+ ImportStats importEvents(istream& in, ScheduleFormat format, const function<void(const ImportedEvent&)>& sink,
+                          vector<ImportError>* errors, size_t maxErrors) {
+     ImportStats stats;
+     ErrorLog log(stats, errors, maxErrors);
+     BlockReader reader(in);
+     if (format == ScheduleFormat::Csv) importCsv(reader, sink, log, stats);
+     else importJsonl(reader, sink, log, stats);
+     return stats;
+ }
+
+ ImportStats importSchedule(istream& in, ScheduleFormat format, ScheduleStore& schedule,
+                            vector<ImportError>* errors, size_t maxErrors) {
+     // Индекс интервалов строится один раз после загрузки, а не вставкой на каждую запись
+     schedule.deferIndex();
+     return importEvents(in, format, [&](const ImportedEvent& e) {
+         schedule.add(e.name, e.start, e.end, e.planned);
+     }, errors, maxErrors);
+ }
+
+ ScheduleWriter::ScheduleWriter(ostream& out, ScheduleFormat format) : out_(out), format_(format) {
+     buffer_.reserve(flushSize + 4096);
+     if (format_ == ScheduleFormat::Csv) buffer_ += "name,startTime,endTime,plannedDuration,actualDuration\n";
+ }
+
+ ScheduleWriter::~ScheduleWriter() {
+     flush();
+ }
+
+ void ScheduleWriter::write(string_view name, int32_t start, int32_t end, int32_t planned, int32_t actual) {
+     if (format_ == ScheduleFormat::Csv) {
+         appendCsvField(buffer_, name);
+         buffer_ += ',';
+         appendTime(buffer_, start);
+         buffer_ += ',';
+         appendTime(buffer_, end);
+         buffer_ += ',';
+         appendTime(buffer_, planned);
+         buffer_ += ',';
+         appendTime(buffer_, actual);
+         buffer_ += '\n';
+     } else {
+         buffer_ += "{\"name\":";
+         appendJsonString(buffer_, name);
+         buffer_ += ",\"startTime\":\"";
+         appendTime(buffer_, start);
+         buffer_ += "\",\"endTime\":\"";
+         appendTime(buffer_, end);
+         buffer_ += "\",\"plannedDuration\":\"";
+         appendTime(buffer_, planned);
+         buffer_ += "\",\"actualDuration\":\"";
+         appendTime(buffer_, actual);
+         buffer_ += "\"}\n";
+     }
+     if (buffer_.size() >= flushSize) flush();
+ }
+
+ void ScheduleWriter::flush() {
+     out_.write(buffer_.data(), buffer_.size());
+     buffer_.clear();
+ }
+
+ void exportSchedule(const ScheduleStore& schedule, ScheduleFormat format, ostream& out) {
+     ScheduleWriter writer(out, format);
+     for (int i = 0; i < schedule.size(); i++) {
+         writer.write(schedule.name(i), schedule.start(i), schedule.end(i), schedule.planned(i), schedule.actual(i));
+     }
+ }
+
+ ImportStats convertSchedule(istream& in, ScheduleFormat from, ostream& out, ScheduleFormat to,
+                             vector<ImportError>* errors, size_t maxErrors) {
+     ScheduleWriter writer(out, to);
+     return importEvents(in, from, [&](const ImportedEvent& e) {
+         writer.write(e.name, e.start, e.end, e.planned, actualDurationSeconds(e.start, e.end));
+     }, errors, maxErrors);
+ }
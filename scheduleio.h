@@ -0,0 +1,147 @@
+/**
+ * @file scheduleio.h
+ * @brief Потоковый импорт и экспорт расписания в CSV и JSON Lines
+ */
+
+ #ifndef SCHEDULEIO_H
+ #define SCHEDULEIO_H
+
+ #include "schedulestore.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <functional>
+ #include <iosfwd>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+
+ // CSV: первая строка - заголовок, столбцы ищутся по именам (порядок
+ // любой, лишние столбцы пропускаются). Поля с запятыми, кавычками и
+ // переводами строк заключаются в кавычки, кавычка внутри удваивается.
+ //
+ //     name,startTime,endTime,plannedDuration,actualDuration
+ //     "Планёрка, отдел",9:00:00,10:30:00,1:00:00,1:30:00
+ //
+ // JSON Lines: по одному объекту на строку, время - строки.
+ //
+ //     {"name":"Планёрка","startTime":"9:00:00","endTime":"10:30:00","plannedDuration":"1:00:00","actualDuration":"1:30:00"}
+ //
+ // При импорте actualDuration не читается, а вычисляется по началу и
+ // концу. Время проверяется Time::parse - так же, как при вводе в меню.
+ // Правила повторения в эти форматы не входят: их хранит только
+ // двоичный файл (schedulefile.h).
+
+ /**
+  * @brief Формат файла обмена
+  */
+ enum class ScheduleFormat {
+     Csv,  ///< Значения через запятую
+     Jsonl ///< JSON-объект на строку
+ };
+
+ /**
+  * @brief Определить формат по расширению (.csv, .jsonl, .ndjson, .json)
+  * @param path Путь к файлу
+  * @param format Найденный формат
+  * @return false, если расширение не распознано
+  */
+ bool scheduleFormatFromPath(std::string_view path, ScheduleFormat& format);
+
+ /**
+  * @struct ImportedEvent
+  * @brief Мероприятие, прочитанное из файла (название действительно до следующей строки)
+  */
+ struct ImportedEvent {
+     std::string_view name; ///< Название
+     int32_t start;         ///< Начало, секунды
+     int32_t end;           ///< Конец, секунды
+     int32_t planned;       ///< Плановая длительность, секунды
+ };
+
+ /**
+  * @struct ImportError
+  * @brief Отклонённая строка файла
+  */
+ struct ImportError {
+     size_t line;         ///< Номер строки, с которой начинается запись (с 1)
+     std::string message; ///< Причина
+ };
+
+ /**
+  * @struct ImportStats
+  * @brief Итог импорта
+  */
+ struct ImportStats {
+     size_t records = 0;  ///< Прочитанные записи (без заголовка и пустых строк)
+     size_t imported = 0; ///< Принятые записи
+     size_t rejected = 0; ///< Отклонённые записи
+ };
+
+ /**
+  * @brief Прочитать мероприятия из потока блоками, передавая каждое в sink
+  * @param in Поток с данными
+  * @param format Формат
+  * @param sink Получатель мероприятий
+  * @param errors Если не nullptr, сюда дописываются первые maxErrors ошибок
+  * @param maxErrors Сколько ошибок сохранять (считаются все)
+  * @return Счётчики записей
+  *
+  * Память не зависит от размера файла: в буфере держится только блок
+  * и незаконченная запись. Ошибочная запись пропускается, чтение
+  * продолжается со следующей. Запись длиннее 4 МиБ (например, после
+  * незакрытой кавычки CSV) отклоняется, и чтение продолжается со
+  * следующей строки.
+  */
+ ImportStats importEvents(std::istream& in, ScheduleFormat format,
+                          const std::function<void(const ImportedEvent&)>& sink,
+                          std::vector<ImportError>* errors = nullptr, size_t maxErrors = 1000);
+
+ /**
+  * @brief Добавить мероприятия из потока в конец расписания
+  */
+ ImportStats importSchedule(std::istream& in, ScheduleFormat format, ScheduleStore& schedule,
+                            std::vector<ImportError>* errors = nullptr, size_t maxErrors = 1000);
+
+ /**
+  * @class ScheduleWriter
+  * @brief Запись мероприятий в CSV или JSON Lines через буфер
+  *
+  * Строки собираются в буфер и выводятся блоками по 64 КиБ. Заголовок
+  * CSV пишется конструктором, остаток буфера - flush() или деструктором.
+  */
+ class ScheduleWriter {
+ private:
+     std::ostream& out_;
+     ScheduleFormat format_;
+     std::string buffer_;
+
+ public:
+     ScheduleWriter(std::ostream& out, ScheduleFormat format);
+     ~ScheduleWriter();
+     ScheduleWriter(const ScheduleWriter&) = delete;
+     ScheduleWriter& operator=(const ScheduleWriter&) = delete;
+
+     /**
+      * @brief Записать одно мероприятие
+      */
+     void write(std::string_view name, int32_t start, int32_t end, int32_t planned, int32_t actual);
+
+     /**
+      * @brief Вывести накопленное в поток
+      */
+     void flush();
+ };
+
+ /**
+  * @brief Записать всё расписание в поток
+  */
+ void exportSchedule(const ScheduleStore& schedule, ScheduleFormat format, std::ostream& out);
+
+ /**
+  * @brief Переписать мероприятия из одного формата в другой без загрузки в память
+  * @return Счётчики записей входного потока
+  */
+ ImportStats convertSchedule(std::istream& in, ScheduleFormat from, std::ostream& out, ScheduleFormat to,
+                             std::vector<ImportError>* errors = nullptr, size_t maxErrors = 1000);
+
+ #endif
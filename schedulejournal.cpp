@@ -0,0 +1,231 @@
+/**
+ * @file schedulejournal.cpp
+ * @brief Реализация журнала изменений расписания
+ */
+
+ #include "schedulejournal.h"
+ #include <algorithm>
+ #include <utility>
+
+ using namespace std;
+
+ ScheduleJournal::Record& ScheduleJournal::push(Operation operation, int index) {
+     discardRedo();
+     Record record;
+     record.operation = operation;
+     record.first = depth_ == 0 || stepStart_;
+     record.index = index;
+     record.values[0] = record.values[1] = record.values[2] = record.values[3] = 0;
+     record.textLength[0] = record.textLength[1] = 0;
+     record.extra = npos;
+     record.text = text_.size();
+     record.id = ++lastId_;
+     stepStart_ = false;
+     records_.push_back(record);
+     cursor_++;
+     return records_.back();
+ }
+
+ // Отменённые записи больше не понадобятся: их названия, правила и
+ // хранилища лежат в конце буферов, после данных оставшихся записей
+ void ScheduleJournal::discardRedo() {
+     if (cursor_ == records_.size()) return;
+     size_t rules = rules_.size();
+     size_t stores = stores_.size();
+     for (size_t i = cursor_; i < records_.size(); i++) {
+         const Record& r = records_[i];
+         if (r.operation == Operation::Remove && r.extra != npos) rules = min<size_t>(rules, r.extra);
+         if (r.operation == Operation::Recurrence) {
+             for (int32_t rule : {r.values[0], r.values[1]}) {
+                 if (rule >= 0) rules = min<size_t>(rules, static_cast<size_t>(rule));
+             }
+         }
+         if (r.operation == Operation::Replace) stores = min<size_t>(stores, r.extra);
+     }
+     text_.resize(records_[cursor_].text);
+     rules_.resize(rules);
+     stores_.erase(stores_.begin() + static_cast<ptrdiff_t>(stores), stores_.end());
+     records_.resize(cursor_);
+ }
+
+ void ScheduleJournal::apply(const Record& r, bool forward) {
+     int32_t value = r.values[forward ? 1 : 0];
+     switch (r.operation) {
+         case Operation::Add:
+             if (forward) {
+                 schedule_.add(string_view(text_.data() + r.text, r.textLength[0]), r.values[0], r.values[1], r.values[2]);
+             } else {
+                 schedule_.remove(r.index);
+             }
+             break;
+         case Operation::Remove:
+             if (forward) {
+                 schedule_.remove(r.index);
+             } else {
+                 schedule_.insert(r.index, string_view(text_.data() + r.text, r.textLength[0]),
+                                  r.values[0], r.values[1], r.values[2]);
+                 schedule_.setActual(r.index, r.values[3]);
+                 if (r.extra != npos) schedule_.setRecurrence(r.index, rules_[r.extra]);
+             }
+             break;
+         case Operation::Name: {
+             // Прежнее название, за ним новое
+             size_t offset = r.text + (forward ? r.textLength[0] : 0);
+             schedule_.setName(r.index, string_view(text_.data() + offset, r.textLength[forward ? 1 : 0]));
+             break;
+         }
+         case Operation::Start: schedule_.setStart(r.index, value); break;
+         case Operation::End: schedule_.setEnd(r.index, value); break;
+         case Operation::Planned: schedule_.setPlanned(r.index, value); break;
+         case Operation::Actual: schedule_.setActual(r.index, value); break;
+         case Operation::Recurrence:
+             if (value >= 0) {
+                 schedule_.setRecurrence(r.index, rules_[static_cast<size_t>(value)]);
+             } else {
+                 schedule_.clearRecurrence(r.index);
+             }
+             break;
+         case Operation::Replace:
+             swap(schedule_, stores_[r.extra]);
+             break;
+     }
+ }
+
+ int32_t ScheduleJournal::storeRule(const RecurrenceRule* rule) {
+     if (!rule) return -1;
+     rules_.push_back(*rule);
+     return static_cast<int32_t>(rules_.size() - 1);
+ }
+
+ EventHandle ScheduleJournal::add(string_view name, int32_t startSeconds, int32_t endSeconds, int32_t plannedSeconds) {
+     Record& r = push(Operation::Add, schedule_.size());
+     EventHandle handle = schedule_.add(name, startSeconds, endSeconds, plannedSeconds);
+     r.values[0] = startSeconds;
+     r.values[1] = endSeconds;
+     r.values[2] = plannedSeconds;
+     r.values[3] = schedule_.actual(r.index);
+     r.textLength[0] = static_cast<uint32_t>(name.size());
+     text_.append(name.data(), name.size());
+     return handle;
+ }
+
+ void ScheduleJournal::remove(int index) {
+     Record& r = push(Operation::Remove, index);
+     r.values[0] = schedule_.start(index);
+     r.values[1] = schedule_.end(index);
+     r.values[2] = schedule_.planned(index);
+     r.values[3] = schedule_.actual(index);
+     string_view name = schedule_.name(index);
+     r.textLength[0] = static_cast<uint32_t>(name.size());
+     text_.append(name.data(), name.size());
+     int32_t rule = storeRule(schedule_.recurrence(index));
+     r.extra = rule >= 0 ? static_cast<uint32_t>(rule) : npos;
+     schedule_.remove(index);
+ }
+
+ void ScheduleJournal::setName(int index, string_view name) {
+     Record& r = push(Operation::Name, index);
+     string_view old = schedule_.name(index);
+     r.textLength[0] = static_cast<uint32_t>(old.size());
+     r.textLength[1] = static_cast<uint32_t>(name.size());
+     text_.append(old.data(), old.size());
+     text_.append(name.data(), name.size());
+     schedule_.setName(index, name);
+ }
+
+ void ScheduleJournal::setStart(int index, int32_t seconds) {
+     Record& r = push(Operation::Start, index);
+     r.values[0] = schedule_.start(index);
+     r.values[1] = seconds;
+     schedule_.setStart(index, seconds);
+ }
+
+ void ScheduleJournal::setEnd(int index, int32_t seconds) {
+     Record& r = push(Operation::End, index);
+     r.values[0] = schedule_.end(index);
+     r.values[1] = seconds;
+     schedule_.setEnd(index, seconds);
+ }
+
+ void ScheduleJournal::setPlanned(int index, int32_t seconds) {
+     Record& r = push(Operation::Planned, index);
+     r.values[0] = schedule_.planned(index);
+     r.values[1] = seconds;
+     schedule_.setPlanned(index, seconds);
+ }
+
+ void ScheduleJournal::setActual(int index, int32_t seconds) {
+     Record& r = push(Operation::Actual, index);
+     r.values[0] = schedule_.actual(index);
+     r.values[1] = seconds;
+     schedule_.setActual(index, seconds);
+ }
+
+ void ScheduleJournal::setRecurrence(int index, const RecurrenceRule& rule) {
+     Record& r = push(Operation::Recurrence, index);
+     r.values[0] = storeRule(schedule_.recurrence(index));
+     r.values[1] = storeRule(&rule);
+     schedule_.setRecurrence(index, rule);
+ }
+
+ void ScheduleJournal::clearRecurrence(int index) {
+     Record& r = push(Operation::Recurrence, index);
+     r.values[0] = storeRule(schedule_.recurrence(index));
+     r.values[1] = -1;
+     schedule_.clearRecurrence(index);
+ }
+
+ void ScheduleJournal::replace(ScheduleStore&& contents) {
+     Record& r = push(Operation::Replace, 0);
+     r.extra = static_cast<uint32_t>(stores_.size());
+     stores_.push_back(std::move(contents));
+     swap(schedule_, stores_.back());
+ }
+
+ void ScheduleJournal::beginStep() {
+     if (depth_++ == 0) stepStart_ = true;
+ }
+
+ void ScheduleJournal::endStep() {
+     if (depth_ > 0 && --depth_ == 0) stepStart_ = false;
+ }
+
+ bool ScheduleJournal::undo() {
+     if (cursor_ == 0) return false;
+     do {
+         apply(records_[--cursor_], false);
+     } while (cursor_ > 0 && !records_[cursor_].first);
+     return true;
+ }
+
+ bool ScheduleJournal::redo() {
+     if (cursor_ == records_.size()) return false;
+     do {
+         apply(records_[cursor_++], true);
+     } while (cursor_ < records_.size() && !records_[cursor_].first);
+     return true;
+ }
+
+ ScheduleSnapshot ScheduleJournal::snapshot() const {
+     return ScheduleSnapshot{cursor_, cursor_ > 0 ? records_[cursor_ - 1].id : baseId_};
+ }
+
+ bool ScheduleJournal::restore(const ScheduleSnapshot& snapshot) {
+     size_t position = snapshot.position;
+     if (position > records_.size()) return false;
+     if (snapshot.record != (position > 0 ? records_[position - 1].id : baseId_)) return false;
+     while (cursor_ > position) apply(records_[--cursor_], false);
+     while (cursor_ < position) apply(records_[cursor_++], true);
+     return true;
+ }
+
+ void ScheduleJournal::clearHistory() {
+     records_.clear();
+     cursor_ = 0;
+     text_.clear();
+     rules_.clear();
+     stores_.clear();
+     baseId_ = ++lastId_;
+     depth_ = 0;
+     stepStart_ = false;
+ }
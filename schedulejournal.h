@@ -0,0 +1,179 @@
+/**
+ * @file schedulejournal.h
+ * @brief Журнал изменений расписания: отмена, повтор и снимки
+ */
+
+ #ifndef SCHEDULEJOURNAL_H
+ #define SCHEDULEJOURNAL_H
+
+ #include "schedulestore.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+
+ /**
+  * @struct ScheduleSnapshot
+  * @brief Снимок расписания - место в истории журнала
+  *
+  * Снимок ничего не копирует и занимает 16 байт при любом размере
+  * расписания; ScheduleJournal::restore() возвращает расписание к нему,
+  * отменяя или повторяя записи между текущим местом и снимком.
+  */
+ struct ScheduleSnapshot {
+     size_t position = 0; ///< Число применённых записей журнала
+     uint64_t record = 0; ///< Номер последней применённой записи (или начала истории)
+ };
+
+ /**
+  * @class ScheduleJournal
+  * @brief Изменения расписания с отменой, повтором и снимками
+  *
+  * Журнал применяет изменение к хранилищу и запоминает прежнее и новое
+  * значение: запись фиксированного размера плюс названия в общем
+  * буфере, поэтому правка поля и её отмена - O(1) времени и памяти.
+  * Отмена удаления вставляет мероприятие обратно на его позицию
+  * (ScheduleStore::insert, O(n - позиция)).
+  *
+  * Замена расписания целиком (очистка, загрузка файла) не копирует
+  * мероприятия: прежнее хранилище переносится в журнал перемещением,
+  * а отмена и повтор меняют хранилища местами за O(1).
+  *
+  * Шаг отмены - одна запись или все записи между beginStep() и
+  * endStep(). Новое изменение после отмены отбрасывает отменённые шаги.
+  * Записи ссылаются на позиции мероприятий, поэтому пока в журнале есть
+  * история, расписание меняется только через журнал.
+  */
+ class ScheduleJournal {
+ private:
+     enum class Operation : uint8_t {
+         Add,        ///< Добавление (в конец)
+         Remove,     ///< Удаление
+         Name,       ///< Название
+         Start,      ///< Начало
+         End,        ///< Конец
+         Planned,    ///< Плановая длительность
+         Actual,     ///< Фактическая длительность
+         Recurrence, ///< Правило повторения
+         Replace     ///< Замена расписания целиком
+     };
+
+     struct Record {
+         Operation operation;
+         bool first;              ///< Первая запись шага
+         int32_t index;           ///< Позиция мероприятия
+         int32_t values[4];       ///< Add, Remove: начало, конец, план, факт; поле: прежнее и новое;
+                                  ///< Recurrence: номера прежнего и нового правила в rules_ (-1 - нет)
+         uint32_t textLength[2];  ///< Длина прежнего и нового названия (Add, Remove - только [0])
+         uint32_t extra;          ///< Remove: номер правила в rules_; Replace: номер хранилища в stores_
+         size_t text;             ///< Начало названий записи в text_
+         uint64_t id;             ///< Номер записи (для снимков)
+     };
+
+     static constexpr uint32_t npos = UINT32_MAX;
+
+     ScheduleStore& schedule_;
+     std::vector<Record> records_;        ///< История
+     size_t cursor_ = 0;                  ///< Применено записей; дальше - отменённые
+     std::string text_;                   ///< Названия записей подряд
+     std::vector<RecurrenceRule> rules_;  ///< Правила повторения записей
+     std::vector<ScheduleStore> stores_;  ///< Хранилища, вытесненные заменой
+     uint64_t lastId_ = 0;                ///< Номер последней созданной записи
+     uint64_t baseId_ = 0;                ///< Номер начала истории
+     int depth_ = 0;                      ///< Вложенность beginStep
+     bool stepStart_ = false;             ///< Следующая запись открывает шаг
+
+     Record& push(Operation operation, int index);
+     void discardRedo();
+     void apply(const Record& record, bool forward);
+     int32_t storeRule(const RecurrenceRule* rule);
+
+ public:
+     /**
+      * @brief Журнал изменений расписания schedule (история пуста)
+      */
+     explicit ScheduleJournal(ScheduleStore& schedule) : schedule_(schedule) {}
+
+     ScheduleJournal(const ScheduleJournal&) = delete;
+     ScheduleJournal& operator=(const ScheduleJournal&) = delete;
+
+     // Изменения - как одноимённые методы ScheduleStore
+     EventHandle add(std::string_view name, int32_t startSeconds, int32_t endSeconds, int32_t plannedSeconds);
+     void remove(int index);
+     void setName(int index, std::string_view name);
+     void setStart(int index, int32_t seconds);
+     void setEnd(int index, int32_t seconds);
+     void setPlanned(int index, int32_t seconds);
+     void setActual(int index, int32_t seconds);
+     void setRecurrence(int index, const RecurrenceRule& rule);
+     void clearRecurrence(int index);
+
+     /**
+      * @brief Заменить расписание целиком (загрузка файла)
+      * @param contents Новое содержимое; прежнее остаётся в журнале для отмены
+      */
+     void replace(ScheduleStore&& contents);
+
+     /**
+      * @brief Удалить все мероприятия (с возможностью отмены)
+      */
+     void clear() { replace(ScheduleStore()); }
+
+     /**
+      * @brief Начать шаг: изменения до endStep() отменяются вместе
+      *
+      * Шаги могут быть вложенными; шагом считается внешний.
+      */
+     void beginStep();
+     void endStep(); ///< Закончить шаг
+
+     /**
+      * @brief Отменить последний шаг
+      * @return false, если отменять нечего
+      */
+     bool undo();
+
+     /**
+      * @brief Повторить последний отменённый шаг
+      * @return false, если повторять нечего
+      */
+     bool redo();
+
+     bool canUndo() const { return cursor_ > 0; }               ///< Есть что отменить
+     bool canRedo() const { return cursor_ < records_.size(); } ///< Есть что повторить
+
+     /**
+      * @brief Снимок текущего состояния за O(1)
+      */
+     ScheduleSnapshot snapshot() const;
+
+     /**
+      * @brief Вернуть расписание к снимку
+      * @return false, если снимок недействителен: его записи отброшены
+      *         новым изменением после отмены или clearHistory()
+      *
+      * Время пропорционально числу записей между текущим местом и снимком.
+      */
+     bool restore(const ScheduleSnapshot& snapshot);
+
+     /**
+      * @brief Забыть историю (расписание не меняется, снимки недействительны)
+      */
+     void clearHistory();
+
+     /**
+      * @brief Число записей в истории (применённых и отменённых)
+      */
+     size_t recordCount() const { return records_.size(); }
+
+     /**
+      * @brief Память истории, байты (по ёмкости), без вытесненных хранилищ
+      */
+     size_t memoryBytes() const {
+         return records_.capacity() * sizeof(Record) + text_.capacity()
+              + rules_.capacity() * sizeof(RecurrenceRule) + stores_.capacity() * sizeof(ScheduleStore);
+     }
+ };
+
+ #endif
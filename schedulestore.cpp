@@ -0,0 +1,448 @@
+/**
+ * @file schedulestore.cpp
+ * @brief Реализация хранилища расписания
+ */
+
+ #include "schedulestore.h"
+ #include <algorithm>
+ #include <cstring>
+
+ using namespace std;
+
+ // Переписывает живые названия подряд, выбрасывая мусор от удалений и правок
+ void ScheduleStore::compactNames() const {
+     NameArena compacted;
+     compacted.reserve(names_.size() - names_.unusedBytes());
+     for (size_t i = 0; i < nameOffset_.size(); i++) {
+         nameOffset_[i] = compacted.store(string_view(names_.data() + nameOffset_[i], nameLength_[i]));
+     }
+     names_.swap(compacted);
+ }
+
+ // Дерево Фенвика live_ (нумерация с 1) хранит число живых записей в
+ // своих отрезках; строится при первом надгробии и сбрасывается уплотнением
+ void ScheduleStore::buildLive() const {
+     size_t count = slotOf_.size();
+     live_.assign(count + 1, 1);
+     live_[0] = 0;
+     for (size_t k = 1; k <= count; k++) {
+         size_t parent = k + (k & (0 - k));
+         if (parent <= count) live_[parent] += live_[k];
+     }
+ }
+
+ void ScheduleStore::appendLive() const {
+     uint32_t k = static_cast<uint32_t>(live_.size());
+     live_.push_back(1 + prefixLive(k - 1) - prefixLive(k - (k & (0 - k))));
+ }
+
+ void ScheduleStore::decrementLive(uint32_t position) const {
+     for (size_t k = position + 1; k < live_.size(); k += k & (0 - k)) live_[k]--;
+ }
+
+ // Число живых записей среди первых count физических позиций
+ uint32_t ScheduleStore::prefixLive(uint32_t count) const {
+     uint32_t sum = 0;
+     for (uint32_t k = count; k > 0; k -= k & (0 - k)) sum += live_[k];
+     return sum;
+ }
+
+ // Физическая позиция живой записи с номером rank (спуск по дереву)
+ uint32_t ScheduleStore::selectLive(uint32_t rank) const {
+     size_t count = live_.size() - 1;
+     size_t step = 1;
+     while (step * 2 <= count) step *= 2;
+     size_t position = 0;
+     uint32_t remaining = rank + 1;
+     for (; step > 0; step /= 2) {
+         if (position + step <= count && live_[position + step] < remaining) {
+             position += step;
+             remaining -= live_[position];
+         }
+     }
+     return static_cast<uint32_t>(position);
+ }
+
+ // Число живых записей подряд от начала, то есть позиция первого надгробия
+ uint32_t ScheduleStore::leadingLive() const {
+     size_t count = live_.size() - 1;
+     size_t step = 1;
+     while (step * 2 <= count) step *= 2;
+     size_t position = 0;
+     for (; step > 0; step /= 2) {
+         // Отрезок (position, position + step] целиком живой
+         if (position + step <= count && live_[position + step] == step) position += step;
+     }
+     return static_cast<uint32_t>(position);
+ }
+
+ void ScheduleStore::moveEvent(size_t from, size_t to) const {
+     start_[to] = start_[from];
+     end_[to] = end_[from];
+     planned_[to] = planned_[from];
+     actual_[to] = actual_[from];
+     nameOffset_[to] = nameOffset_[from];
+     nameLength_[to] = nameLength_[from];
+     slotOf_[to] = slotOf_[from];
+ }
+
+ // Убирает надгробия одним проходом, сохраняя порядок живых записей
+ void ScheduleStore::settle() const {
+     if (dead_ == 0) return;
+     // Записи до первого надгробия остаются на месте: удаление недавно
+     // добавленного мероприятия не проходит весь столбец
+     size_t write = leadingLive();
+     for (size_t p = write; p < slotOf_.size(); p++) {
+         uint32_t slot = slotOf_[p];
+         if (slot == npos) continue;
+         if (write != p) moveEvent(p, write);
+         slotIndex_[slot] = static_cast<uint32_t>(write);
+         write++;
+     }
+     start_.resize(write);
+     end_.resize(write);
+     planned_.resize(write);
+     actual_.resize(write);
+     nameOffset_.resize(write);
+     nameLength_.resize(write);
+     slotOf_.resize(write);
+     live_.clear();
+     dead_ = 0;
+     shrinkIfSparse();
+ }
+
+ // Ёмкость больше размера в 4 раза возвращается системе; запас в 4 раза
+ // не даёт чередованию добавлений и удалений перевыделять столбцы
+ void ScheduleStore::shrinkIfSparse() const {
+     size_t count = slotOf_.size();
+     if (start_.capacity() > minShrinkCapacity && start_.capacity() / 4 > count) {
+         start_.shrink_to_fit();
+         end_.shrink_to_fit();
+         planned_.shrink_to_fit();
+         actual_.shrink_to_fit();
+         nameOffset_.shrink_to_fit();
+         nameLength_.shrink_to_fit();
+         slotOf_.shrink_to_fit();
+         vector<uint32_t>().swap(live_);
+     }
+     if (names_.unusedBytes() > names_.size() / 2
+         || (names_.capacity() > minShrinkCapacity && names_.capacity() / 4 > names_.size())) {
+         compactNames();
+     }
+ }
+
+ EventHandle ScheduleStore::add(string_view name, int32_t startSeconds, int32_t endSeconds, int32_t plannedSeconds) {
+     uint32_t index = static_cast<uint32_t>(start_.size());
+
+     uint32_t slot;
+     if (!freeSlots_.empty()) {
+         slot = freeSlots_.back();
+         freeSlots_.pop_back();
+         slotIndex_[slot] = index;
+     } else {
+         slot = static_cast<uint32_t>(slotIndex_.size());
+         slotIndex_.push_back(index);
+         slotGeneration_.push_back(0);
+     }
+
+     start_.push_back(startSeconds);
+     end_.push_back(endSeconds);
+     planned_.push_back(plannedSeconds);
+     actual_.push_back(actualDurationSeconds(startSeconds, endSeconds));
+     totals_.add(startSeconds, plannedSeconds, actual_.back());
+     nameOffset_.push_back(names_.store(name));
+     nameLength_.push_back(static_cast<uint32_t>(name.size()));
+     slotOf_.push_back(slot);
+
+     if (dead_ > 0) appendLive();
+
+     EventHandle handle{slot, slotGeneration_[slot]};
+     if (!indexStale_) index_.insert(handle, startSeconds, endSeconds);
+     return handle;
+ }
+
+ EventHandle ScheduleStore::insert(int index, string_view name, int32_t startSeconds, int32_t endSeconds,
+                                  int32_t plannedSeconds) {
+     settle();
+     EventHandle handle = add(name, startSeconds, endSeconds, plannedSeconds);
+     size_t at = static_cast<size_t>(index);
+     size_t last = slotOf_.size() - 1;
+     if (at >= last) return handle;
+     // Новая запись переезжает из конца на позицию index, следующие - на одну дальше
+     auto shift = [at, last](auto& column) {
+         rotate(column.begin() + at, column.begin() + last, column.end());
+     };
+     shift(start_);
+     shift(end_);
+     shift(planned_);
+     shift(actual_);
+     shift(nameOffset_);
+     shift(nameLength_);
+     shift(slotOf_);
+     for (size_t p = at; p <= last; p++) slotIndex_[slotOf_[p]] = static_cast<uint32_t>(p);
+     return handle;
+ }
+
+ void ScheduleStore::reserve(size_t count, size_t nameBytes) {
+     start_.reserve(count);
+     end_.reserve(count);
+     planned_.reserve(count);
+     actual_.reserve(count);
+     nameOffset_.reserve(count);
+     nameLength_.reserve(count);
+     slotOf_.reserve(count);
+     slotIndex_.reserve(count);
+     slotGeneration_.reserve(count);
+     freeSlots_.reserve(count);
+     index_.reserve(count);
+     names_.reserve(nameBytes);
+ }
+
+ // Превращает запись в надгробие: слот и название освобождаются сразу,
+ // место в столбцах - при уплотнении
+ void ScheduleStore::kill(uint32_t position) {
+     uint32_t slot = slotOf_[position];
+     if (!indexStale_) {
+         // Каждое удаление из дерева - O(log n) промахов кэша. Когда их
+         // набирается больше 1/16 индекса, дешевле перестроить его за O(n)
+         // при следующем запросе, чем продолжать удалять по одному
+         if (++indexErases_ > index_.size() / 16 + 1024) {
+             deferIndex();
+         } else {
+             index_.erase(EventHandle{slot, slotGeneration_[slot]});
+         }
+     }
+     slotIndex_[slot] = npos;
+     slotGeneration_[slot]++;
+     freeSlots_.push_back(slot);
+     recurrences_.erase(slot);
+     totals_.remove(start_[position], planned_[position], actual_[position]);
+     names_.release(nameOffset_[position], nameLength_[position]);
+
+     if (position + 1 == slotOf_.size()) {
+         // Последняя запись убирается сразу: надгробие и дерево Фенвика не
+         // нужны (отрезки дерева не опираются на последний узел)
+         start_.pop_back();
+         end_.pop_back();
+         planned_.pop_back();
+         actual_.pop_back();
+         nameOffset_.pop_back();
+         nameLength_.pop_back();
+         slotOf_.pop_back();
+         if (dead_ > 0) live_.pop_back();
+     } else {
+         nameOffset_[position] = 0;
+         nameLength_[position] = 0;
+         slotOf_[position] = npos;
+         if (dead_ == 0) buildLive();
+         decrementLive(position);
+         dead_++;
+     }
+
+     if (static_cast<size_t>(dead_) * 4 > slotOf_.size()) {
+         settle();
+     } else if (names_.unusedBytes() > names_.size() / 2) {
+         compactNames();
+     }
+ }
+
+ void ScheduleStore::remove(int index) {
+     kill(physical(index));
+ }
+
+ bool ScheduleStore::remove(EventHandle handle) {
+     if (indexOf(handle) < 0) return false;
+     kill(slotIndex_[handle.slot]);
+     return true;
+ }
+
+ size_t ScheduleStore::removeIf(const function<bool(int)>& pred) {
+     // Условие видит расписание целиком, до первого удаления
+     size_t count = static_cast<size_t>(size());
+     vector<uint8_t> marks(count);
+     size_t removed = 0;
+     for (size_t i = 0; i < count; i++) {
+         marks[i] = pred(static_cast<int>(i));
+         removed += marks[i];
+     }
+     if (removed == 0) return 0;
+     if (removed > count / 16) deferIndex();
+
+     settle();
+     size_t write = 0;
+     for (size_t i = 0; i < count; i++) {
+         uint32_t slot = slotOf_[i];
+         if (marks[i]) {
+             if (!indexStale_) index_.erase(EventHandle{slot, slotGeneration_[slot]});
+             slotIndex_[slot] = npos;
+             slotGeneration_[slot]++;
+             freeSlots_.push_back(slot);
+             recurrences_.erase(slot);
+             totals_.remove(start_[i], planned_[i], actual_[i]);
+             names_.release(nameOffset_[i], nameLength_[i]);
+             continue;
+         }
+         if (write != i) moveEvent(i, write);
+         slotIndex_[slot] = static_cast<uint32_t>(write);
+         write++;
+     }
+     start_.resize(write);
+     end_.resize(write);
+     planned_.resize(write);
+     actual_.resize(write);
+     nameOffset_.resize(write);
+     nameLength_.resize(write);
+     slotOf_.resize(write);
+     shrinkIfSparse();
+     return removed;
+ }
+
+ void ScheduleStore::compact() {
+     settle();
+     shrinkIfSparse();
+ }
+
+ void ScheduleStore::clear() {
+     for (uint32_t slot : slotOf_) {
+         if (slot == npos) continue;
+         slotIndex_[slot] = npos;
+         slotGeneration_[slot]++;
+         freeSlots_.push_back(slot);
+     }
+     start_.clear();
+     end_.clear();
+     planned_.clear();
+     actual_.clear();
+     nameOffset_.clear();
+     nameLength_.clear();
+     slotOf_.clear();
+     live_.clear();
+     dead_ = 0;
+     totals_.clear();
+     recurrences_.clear();
+     names_.clear();
+     index_.clear();
+     indexStale_ = false;
+     indexErases_ = 0;
+ }
+
+ void ScheduleStore::assign(size_t count, const int32_t* start, const int32_t* end, const int32_t* planned,
+                            const int32_t* actual, const uint32_t* nameOffset, const uint32_t* nameLength,
+                            const char* names, size_t namesSize) {
+     clear();
+     start_.assign(start, start + count);
+     end_.assign(end, end + count);
+     planned_.assign(planned, planned + count);
+     actual_.assign(actual, actual + count);
+     nameOffset_.assign(nameOffset, nameOffset + count);
+     nameLength_.assign(nameLength, nameLength + count);
+     size_t used = 0;
+     for (size_t i = 0; i < count; i++) {
+         used += nameLength[i];
+         totals_.add(start[i], planned[i], actual[i]);
+     }
+     names_.assignPacked(names, namesSize, used);
+
+     // Мероприятия занимают слоты 0..count-1, остальные слоты свободны
+     size_t slots = max(slotIndex_.size(), count);
+     slotIndex_.assign(slots, npos);
+     slotGeneration_.resize(slots, 0);
+     slotOf_.resize(count);
+     for (size_t i = 0; i < count; i++) {
+         slotIndex_[i] = static_cast<uint32_t>(i);
+         slotOf_[i] = static_cast<uint32_t>(i);
+     }
+     freeSlots_.clear();
+     for (size_t slot = slots; slot-- > count;) freeSlots_.push_back(static_cast<uint32_t>(slot));
+     indexStale_ = count > 0;
+ }
+
+ void ScheduleStore::deferIndex() {
+     if (indexStale_) return;
+     index_.clear();
+     indexStale_ = true;
+     indexErases_ = 0;
+ }
+
+ const IntervalIndex& ScheduleStore::intervals() const {
+     if (indexStale_) {
+         settle();
+         index_.rebuild(slotOf_.size(), slotOf_.data(), slotGeneration_.data(), start_.data(), end_.data());
+         indexStale_ = false;
+         indexErases_ = 0;
+     }
+     return index_;
+ }
+
+ void ScheduleStore::prepareForReaders() {
+     settle();
+     intervals();
+ }
+
+ EventHandle ScheduleStore::handleAt(int index) const {
+     uint32_t slot = slotOf_[physical(index)];
+     return EventHandle{slot, slotGeneration_[slot]};
+ }
+
+ int ScheduleStore::indexOf(EventHandle handle) const {
+     if (handle.slot >= slotIndex_.size()) return -1;
+     if (slotGeneration_[handle.slot] != handle.generation) return -1;
+     uint32_t position = slotIndex_[handle.slot];
+     if (position == npos) return -1;
+     return static_cast<int>(dead_ == 0 ? position : prefixLive(position));
+ }
+
+ void ScheduleStore::setName(int index, string_view name) {
+     uint32_t p = physical(index);
+     uint32_t offset = nameOffset_[p];
+     uint32_t length = nameLength_[p];
+     // Свободный блок нужного размера лучше укорачивания на месте: иначе
+     // хвосты длинных блоков копятся в мелких классах, длинным названиям
+     // приходится расти в конец буфера, и правки в цикле ведут к уплотнению
+     bool inPlace = names_.fitsInPlace(offset, length, name.size())
+         && (NameArena::sameBlock(length, name.size()) || !names_.hasPooled(name.size()));
+     if (inPlace) {
+         // Новое название помещается в блок старого
+         if (!name.empty()) memmove(names_.data() + offset, name.data(), name.size());
+         if (name.size() < length) names_.shrink(offset, length, name.size());
+     } else {
+         nameOffset_[p] = names_.store(name);
+         names_.release(offset, length);
+     }
+     nameLength_[p] = static_cast<uint32_t>(name.size());
+
+     if (names_.unusedBytes() > names_.size() / 2) compactNames();
+ }
+
+ // Правка одного столбца: прежние значения вычитаются из итогов, новые прибавляются
+ void ScheduleStore::setColumn(vector<int32_t>& column, uint32_t position, int32_t seconds) {
+     totals_.remove(start_[position], planned_[position], actual_[position]);
+     column[position] = seconds;
+     totals_.add(start_[position], planned_[position], actual_[position]);
+ }
+
+ void ScheduleStore::setPlanned(int index, int32_t seconds) {
+     setColumn(planned_, physical(index), seconds);
+ }
+
+ void ScheduleStore::setActual(int index, int32_t seconds) {
+     setColumn(actual_, physical(index), seconds);
+ }
+
+ void ScheduleStore::setStart(int index, int32_t seconds) {
+     uint32_t p = physical(index);
+     setColumn(start_, p, seconds);
+     if (indexStale_) return;
+     EventHandle handle{slotOf_[p], slotGeneration_[slotOf_[p]]};
+     index_.erase(handle);
+     index_.insert(handle, seconds, end_[p]);
+ }
+
+ void ScheduleStore::setEnd(int index, int32_t seconds) {
+     uint32_t p = physical(index);
+     setColumn(end_, p, seconds);
+     if (indexStale_) return;
+     EventHandle handle{slotOf_[p], slotGeneration_[slotOf_[p]]};
+     index_.erase(handle);
+     index_.insert(handle, start_[p], seconds);
+ }
@@ -0,0 +1,278 @@
+/**
+ * @file schedulestore.h
+ * @brief Хранилище расписания в виде структуры массивов
+ */
+
+ #ifndef SCHEDULESTORE_H
+ #define SCHEDULESTORE_H
+
+ #include "scheduletypes.h"
+ #include "intervalindex.h"
+ #include "namearena.h"
+ #include "recurrence.h"
+ #include "scheduletotals.h"
+ #include <cstdint>
+ #include <functional>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+
+ /**
+  * @class ScheduleStore
+  * @brief Расписание, хранящее каждое поле мероприятий в отдельном массиве
+  *
+  * Секунды начала, конца, плановой и фактической длительности лежат в
+  * непрерывных столбцах int32_t, названия - в общем буфере символов.
+  * Позиции (0..size()-1) задают порядок вывода и сдвигаются при удалении,
+  * дескрипторы EventHandle остаются устойчивыми.
+  *
+  * Удаление не сдвигает столбцы, а оставляет надгробие; позиция
+  * переводится в физическую через дерево Фенвика по живым записям
+  * (O(log n)). Надгробия убираются одним проходом, когда их становится
+  * больше четверти, либо при обращении к столбцам и перестройке индекса.
+  * После уплотнения ёмкость столбцов, превышающая размер в 4 раза,
+  * возвращается системе. Индекс интервалов
+  * обновляется при каждом изменении начала, конца и состава расписания;
+  * после массовой загрузки (assign, deferIndex) и массового удаления
+  * он строится при первом обращении. Итоги (totals()) правятся при
+  * каждом изменении за O(1). Правило повторения (recurrence.h) живёт,
+  * пока живёт мероприятие: удаление мероприятия удаляет и правило.
+  */
+ class ScheduleStore {
+ private:
+     // Столбцы индексируются физической позицией. Уплотнение может
+     // понадобиться константным методам (столбцы, индекс), поэтому mutable.
+     mutable std::vector<int32_t> start_;     ///< Начало, секунды
+     mutable std::vector<int32_t> end_;       ///< Конец, секунды
+     mutable std::vector<int32_t> planned_;   ///< Плановая длительность, секунды
+     mutable std::vector<int32_t> actual_;    ///< Фактическая длительность, секунды
+     mutable std::vector<uint32_t> nameOffset_; ///< Смещение названия в names_
+     mutable std::vector<uint32_t> nameLength_; ///< Длина названия
+     mutable std::vector<uint32_t> slotOf_;   ///< Слот дескриптора для каждой позиции (npos - надгробие)
+
+     mutable NameArena names_;                ///< Буфер названий
+
+     mutable std::vector<uint32_t> slotIndex_; ///< Физическая позиция мероприятия для каждого слота
+     std::vector<uint32_t> slotGeneration_;    ///< Поколение каждого слота
+     std::vector<uint32_t> freeSlots_;         ///< Освобождённые слоты
+
+     mutable std::vector<uint32_t> live_;     ///< Дерево Фенвика по живым позициям (пока есть надгробия)
+     mutable uint32_t dead_ = 0;              ///< Число надгробий
+
+     mutable IntervalIndex index_;    ///< Интервалы [начало, конец) по слотам
+     mutable bool indexStale_ = false; ///< Индекс не построен (assign, deferIndex)
+     mutable size_t indexErases_ = 0;  ///< Удаления из индекса с момента его построения
+
+     ScheduleTotals totals_;           ///< Суммы и крайние значения
+     RecurrenceTable recurrences_;     ///< Правила повторения по слотам
+
+     static constexpr uint32_t npos = UINT32_MAX;
+     static constexpr size_t minShrinkCapacity = 1024; ///< Меньшие столбцы не ужимаются
+
+     void compactNames() const;
+     void settle() const;
+     void shrinkIfSparse() const;
+     void moveEvent(size_t from, size_t to) const;
+     void kill(uint32_t position);
+     void setColumn(std::vector<int32_t>& column, uint32_t position, int32_t seconds);
+
+     void buildLive() const;
+     void appendLive() const;
+     void decrementLive(uint32_t position) const;
+     uint32_t prefixLive(uint32_t count) const;
+     uint32_t selectLive(uint32_t rank) const;
+     uint32_t leadingLive() const;
+
+     /// Физическая позиция мероприятия с позицией index
+     uint32_t physical(int index) const {
+         return dead_ == 0 ? static_cast<uint32_t>(index) : selectLive(static_cast<uint32_t>(index));
+     }
+
+ public:
+     /**
+      * @brief Количество мероприятий
+      */
+     int size() const { return static_cast<int>(slotOf_.size() - dead_); }
+
+     /**
+      * @brief Проверка на пустоту
+      */
+     bool empty() const { return size() == 0; }
+
+     /**
+      * @brief Добавить мероприятие в конец расписания
+      * @param name Название
+      * @param startSeconds Начало, секунды от полуночи
+      * @param endSeconds Конец, секунды от полуночи
+      * @param plannedSeconds Плановая длительность, секунды
+      * @return Дескриптор нового мероприятия
+      *
+      * Фактическая длительность вычисляется по началу и концу.
+      */
+     EventHandle add(std::string_view name, int32_t startSeconds, int32_t endSeconds, int32_t plannedSeconds);
+
+     /**
+      * @brief Вставить мероприятие на позицию index, сдвинув следующие
+      * @return Дескриптор нового мероприятия
+      *
+      * O(n - index): столбцы от позиции до конца сдвигаются на одну
+      * запись. Нужна для отмены удаления (schedulejournal.h); обычное
+      * добавление - add().
+      */
+     EventHandle insert(int index, std::string_view name, int32_t startSeconds, int32_t endSeconds, int32_t plannedSeconds);
+
+     /**
+      * @brief Зарезервировать память под count мероприятий и nameBytes байт названий
+      *
+      * После резервирования add() до count мероприятий не выделяет память
+      * (названия до maxPooledSize байт берутся из буфера или списков
+      * свободных блоков). Уплотнение может вернуть неиспользованный
+      * резерв, если он превышает размер в 4 раза.
+      */
+     void reserve(size_t count, size_t nameBytes);
+
+     /**
+      * @brief Удалить мероприятие, сохранив порядок остальных
+      * @param index Позиция мероприятия
+      *
+      * O(log n): на месте мероприятия остаётся надгробие.
+      */
+     void remove(int index);
+
+     /**
+      * @brief Удалить мероприятие по дескриптору
+      * @return false, если дескриптор недействителен
+      */
+     bool remove(EventHandle handle);
+
+     /**
+      * @brief Удалить все мероприятия, для позиций которых pred вернул true
+      * @param pred Условие; вызывается для каждой позиции до начала удаления
+      * @return Число удалённых мероприятий
+      *
+      * Один проход по столбцам, порядок оставшихся сохраняется. Если
+      * удаляется больше 1/16 расписания, индекс интервалов не правится
+      * по одному, а перестраивается при следующем запросе.
+      */
+     size_t removeIf(const std::function<bool(int)>& pred);
+
+     /**
+      * @brief Убрать надгробия и вернуть лишнюю память столбцов и названий
+      *
+      * Ёмкость ужимается, если превышает размер в 4 раза. clear() ёмкость
+      * сохраняет; clear() и compact() вместе освобождают память полностью.
+      */
+     void compact();
+
+     /**
+      * @brief Удалить все мероприятия
+      */
+     void clear();
+
+     /**
+      * @brief Заменить содержимое готовыми столбцами (загрузка из файла)
+      * @param count Число мероприятий
+      * @param start Начало каждого мероприятия
+      * @param end Конец
+      * @param planned Плановая длительность
+      * @param actual Фактическая длительность
+      * @param nameOffset Смещение названия в names
+      * @param nameLength Длина названия
+      * @param names Буфер названий
+      * @param namesSize Размер буфера названий
+      *
+      * Столбцы копируются целиком, без выделения памяти на каждое
+      * мероприятие. Прежние дескрипторы становятся недействительными,
+      * новые мероприятия занимают слоты 0..count-1.
+      */
+     void assign(size_t count, const int32_t* start, const int32_t* end, const int32_t* planned,
+                 const int32_t* actual, const uint32_t* nameOffset, const uint32_t* nameLength,
+                 const char* names, size_t namesSize);
+
+     /**
+      * @brief Выполнить отложенную работу: убрать надгробия и построить индекс
+      *
+      * Константные методы уплотняют столбцы и строят индекс по первому
+      * требованию. После этого вызова и до следующего изменения они
+      * ничего не меняют, и хранилище можно читать из нескольких потоков.
+      */
+     void prepareForReaders();
+
+     /**
+      * @brief Отложить обновление индекса интервалов до первого запроса
+      *
+      * Для массовых добавлений: вместо вставки на каждое мероприятие
+      * индекс перестраивается целиком за O(n) при вызове intervals().
+      */
+     void deferIndex();
+
+     /**
+      * @brief Дескриптор мероприятия на позиции
+      */
+     EventHandle handleAt(int index) const;
+
+     /**
+      * @brief Позиция мероприятия по дескриптору
+      * @return Позиция или -1, если дескриптор недействителен
+      */
+     int indexOf(EventHandle handle) const;
+
+     // Доступ к полям по позиции
+     std::string_view name(int index) const {
+         uint32_t p = physical(index);
+         return std::string_view(names_.data() + nameOffset_[p], nameLength_[p]);
+     }
+     int32_t start(int index) const { return start_[physical(index)]; }       ///< Начало
+     int32_t end(int index) const { return end_[physical(index)]; }           ///< Конец
+     int32_t planned(int index) const { return planned_[physical(index)]; }   ///< Плановая длительность
+     int32_t actual(int index) const { return actual_[physical(index)]; }     ///< Фактическая длительность
+
+     /**
+      * @brief Изменить название (короткое название пишется на место старого)
+      */
+     void setName(int index, std::string_view name);
+     void setStart(int index, int32_t seconds);                                 ///< Изменить начало
+     void setEnd(int index, int32_t seconds);                                   ///< Изменить конец
+     void setPlanned(int index, int32_t seconds);                               ///< Изменить план
+     void setActual(int index, int32_t seconds);                                ///< Изменить факт
+
+     // Непрерывные столбцы для массовой обработки (size() элементов).
+     // Если есть надгробия, сначала выполняется уплотнение.
+     const int32_t* startColumn() const { settle(); return start_.data(); }
+     const int32_t* endColumn() const { settle(); return end_.data(); }
+     const int32_t* plannedColumn() const { settle(); return planned_.data(); }
+     const int32_t* actualColumn() const { settle(); return actual_.data(); }
+
+     /**
+      * @brief Суммы длительностей, число опозданий, самое раннее начало и поздний конец
+      */
+     const ScheduleTotals& totals() const { return totals_; }
+
+     /**
+      * @brief Индекс интервалов для запросов по времени
+      */
+     const IntervalIndex& intervals() const;
+
+     /**
+      * @brief Сделать мероприятие серией или заменить её правило
+      */
+     void setRecurrence(int index, const RecurrenceRule& rule) { recurrences_.set(handleAt(index), rule); }
+
+     /**
+      * @brief Сделать мероприятие разовым
+      * @return false, если оно и не повторялось
+      */
+     bool clearRecurrence(int index) { return recurrences_.erase(handleAt(index).slot); }
+
+     /**
+      * @brief Правило повторения мероприятия или nullptr для разового
+      */
+     const RecurrenceRule* recurrence(int index) const { return recurrences_.find(handleAt(index)); }
+
+     /**
+      * @brief Все серии расписания (для запросов по окну - occurrencesIn)
+      */
+     const RecurrenceTable& recurrences() const { return recurrences_; }
+ };
+
+ #endif
@@ -0,0 +1,96 @@
+/**
+ * @file scheduletotals.cpp
+ * @brief Реализация итогов расписания
+ */
+
+ #include "scheduletotals.h"
+ #include "saturating.h"
+ #include <algorithm>
+
+ using namespace std;
+
+ void SecondCounter::add(int32_t value) {
+     size_++;
+     if (value < 0 || value >= rangeSeconds) {
+         outside_[value]++;
+         return;
+     }
+     if (counts_.empty()) {
+         counts_.assign(rangeSeconds, 0);
+         words_.assign(wordCount, 0);
+     }
+     if (counts_[value]++ == 0) {
+         size_t word = static_cast<size_t>(value) / 64;
+         words_[word] |= uint64_t(1) << (value % 64);
+         summary_[word / 64] |= uint64_t(1) << (word % 64);
+     }
+ }
+
+ void SecondCounter::remove(int32_t value) {
+     size_--;
+     if (value < 0 || value >= rangeSeconds) {
+         auto it = outside_.find(value);
+         if (--it->second == 0) outside_.erase(it);
+         return;
+     }
+     if (--counts_[value] == 0) {
+         size_t word = static_cast<size_t>(value) / 64;
+         words_[word] &= ~(uint64_t(1) << (value % 64));
+         if (words_[word] == 0) summary_[word / 64] &= ~(uint64_t(1) << (word % 64));
+     }
+ }
+
+ void SecondCounter::clear() {
+     fill(counts_.begin(), counts_.end(), 0);
+     fill(words_.begin(), words_.end(), 0);
+     fill(summary_, summary_ + summaryCount, 0);
+     outside_.clear();
+     size_ = 0;
+ }
+
+ int32_t SecondCounter::min() const {
+     if (!outside_.empty() && outside_.begin()->first < 0) return outside_.begin()->first;
+     for (size_t s = 0; s < summaryCount; s++) {
+         if (summary_[s] == 0) continue;
+         size_t word = s * 64 + static_cast<size_t>(__builtin_ctzll(summary_[s]));
+         return static_cast<int32_t>(word * 64 + static_cast<size_t>(__builtin_ctzll(words_[word])));
+     }
+     return outside_.begin()->first;
+ }
+
+ int32_t SecondCounter::max() const {
+     if (!outside_.empty() && outside_.rbegin()->first >= rangeSeconds) return outside_.rbegin()->first;
+     for (size_t s = summaryCount; s-- > 0;) {
+         if (summary_[s] == 0) continue;
+         size_t word = s * 64 + 63 - static_cast<size_t>(__builtin_clzll(summary_[s]));
+         return static_cast<int32_t>(word * 64 + 63 - static_cast<size_t>(__builtin_clzll(words_[word])));
+     }
+     return outside_.rbegin()->first;
+ }
+
+ void ScheduleTotals::add(int32_t startSeconds, int32_t plannedSeconds, int32_t actualSeconds) {
+     count_++;
+     plannedSeconds_ += plannedSeconds;
+     actualSeconds_ += actualSeconds;
+     if (actualSeconds > plannedSeconds) overrunCount_++;
+     starts_.add(startSeconds);
+     ends_.add(saturatingAdd(startSeconds, actualSeconds));
+ }
+
+ void ScheduleTotals::remove(int32_t startSeconds, int32_t plannedSeconds, int32_t actualSeconds) {
+     count_--;
+     plannedSeconds_ -= plannedSeconds;
+     actualSeconds_ -= actualSeconds;
+     if (actualSeconds > plannedSeconds) overrunCount_--;
+     starts_.remove(startSeconds);
+     ends_.remove(saturatingAdd(startSeconds, actualSeconds));
+ }
+
+ void ScheduleTotals::clear() {
+     count_ = 0;
+     plannedSeconds_ = 0;
+     actualSeconds_ = 0;
+     overrunCount_ = 0;
+     starts_.clear();
+     ends_.clear();
+ }
@@ -0,0 +1,107 @@
+/**
+ * @file scheduletotals.h
+ * @brief Итоги расписания, обновляемые при каждом изменении
+ */
+
+ #ifndef SCHEDULETOTALS_H
+ #define SCHEDULETOTALS_H
+
+ #include <cstddef>
+ #include <cstdint>
+ #include <map>
+ #include <vector>
+
+ /**
+  * @class SecondCounter
+  * @brief Мультимножество секунд с поиском наименьшего и наибольшего значения
+  *
+  * Значения из двух суток [0, 172800) - начала и концы, в том числе после
+  * полуночи - считаются в массиве счётчиков, непустые секунды отмечены в
+  * двухуровневой битовой карте: 2700 слов и 43 слова сводки. Поиск
+  * крайнего значения просматривает не больше 43 + 1 слов, то есть
+  * выполняется за O(1). Остальные значения (редкие) хранятся в std::map.
+  * Память под массивы выделяется при первом добавлении.
+  */
+ class SecondCounter {
+ private:
+     static constexpr int32_t rangeSeconds = 2 * 24 * 3600;
+     static constexpr size_t wordCount = (rangeSeconds + 63) / 64;
+     static constexpr size_t summaryCount = (wordCount + 63) / 64;
+
+     std::vector<uint32_t> counts_;        ///< Число значений в каждой секунде диапазона
+     std::vector<uint64_t> words_;         ///< Бит на каждую непустую секунду
+     uint64_t summary_[summaryCount] = {}; ///< Бит на каждое ненулевое слово words_
+     std::map<int32_t, uint32_t> outside_; ///< Значения вне диапазона
+     size_t size_ = 0;
+
+ public:
+     void add(int32_t value);              ///< Добавить значение
+     void remove(int32_t value);           ///< Убрать одно вхождение значения
+     void clear();                         ///< Убрать все значения (память сохраняется)
+     size_t size() const { return size_; } ///< Число значений
+
+     /**
+      * @brief Наименьшее значение (size() > 0)
+      */
+     int32_t min() const;
+
+     /**
+      * @brief Наибольшее значение (size() > 0)
+      */
+     int32_t max() const;
+ };
+
+ /**
+  * @class ScheduleTotals
+  * @brief Суммы и крайние значения по всем мероприятиям расписания
+  *
+  * Хранилище вызывает add() и remove() для каждого добавленного,
+  * удалённого или изменённого мероприятия (изменение - remove старых
+  * значений и add новых), поэтому чтение итогов не зависит от размера
+  * расписания.
+  */
+ class ScheduleTotals {
+ private:
+     size_t count_ = 0;
+     int64_t plannedSeconds_ = 0;
+     int64_t actualSeconds_ = 0;
+     size_t overrunCount_ = 0;
+     SecondCounter starts_;
+     SecondCounter ends_;
+
+ public:
+     /**
+      * @brief Учесть мероприятие
+      */
+     void add(int32_t startSeconds, int32_t plannedSeconds, int32_t actualSeconds);
+
+     /**
+      * @brief Исключить мероприятие с такими значениями
+      */
+     void remove(int32_t startSeconds, int32_t plannedSeconds, int32_t actualSeconds);
+
+     /**
+      * @brief Обнулить итоги
+      */
+     void clear();
+
+     size_t count() const { return count_; }                   ///< Число мероприятий
+     int64_t plannedSeconds() const { return plannedSeconds_; } ///< Сумма плановых длительностей
+     int64_t actualSeconds() const { return actualSeconds_; }   ///< Сумма фактических длительностей
+     size_t overrunCount() const { return overrunCount_; }      ///< Мероприятия, где факт больше плана
+
+     /**
+      * @brief Самое раннее начало (секунды от полуночи, 0 для пустого расписания)
+      */
+     int32_t earliestStart() const { return count_ > 0 ? starts_.min() : 0; }
+
+     /**
+      * @brief Самый поздний конец: наибольшая сумма начала и фактической длительности
+      *
+      * Конец после полуночи больше суток: 23:00 -> 04:00 заканчивается в
+      * 28:00:00, позже, чем 10:00 -> 11:00.
+      */
+     int32_t latestEnd() const { return count_ > 0 ? ends_.max() : 0; }
+ };
+
+ #endif
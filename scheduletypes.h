@@ -0,0 +1,53 @@
+/**
+ * @file scheduletypes.h
+ * @brief Общие типы и функции модулей расписания
+ */
+
+ #ifndef SCHEDULETYPES_H
+ #define SCHEDULETYPES_H
+
+ #include "datetime.h"
+ #include <cstdint>
+
+ /**
+  * @struct EventHandle
+  * @brief Устойчивая ссылка на мероприятие
+  *
+  * В отличие от позиции в расписании, не меняется при удалении других
+  * мероприятий. После удаления самого мероприятия становится
+  * недействительной (поколение слота увеличивается).
+  */
+ struct EventHandle {
+     uint32_t slot;       ///< Номер слота в таблице дескрипторов
+     uint32_t generation; ///< Поколение слота на момент выдачи
+
+     bool operator==(const EventHandle& other) const {
+         return slot == other.slot && generation == other.generation;
+     }
+     bool operator!=(const EventHandle& other) const { return !(*this == other); }
+ };
+
+ /**
+  * @brief Фактическая длительность с учётом перехода через сутки
+  * @param startSeconds Начало, секунды от полуночи
+  * @param endSeconds Конец, секунды от полуночи дня начала; больше суток -
+  *        мероприятие на несколько дней
+  * @return Длительность в секундах (за границами int32 - с насыщением)
+  *
+  * Начало и конец переводятся в моменты DateTime первого дня: конец
+  * меньше суток - ближайший такой момент не раньше начала (nextAt, конец
+  * раньше начала - следующие сутки), конец от суток и больше - момент
+  * через столько секунд после полуночи дня начала. Длительность -
+  * разность моментов, TimeSpan64.
+  */
+ constexpr int32_t actualDurationSeconds(int32_t startSeconds, int32_t endSeconds) noexcept {
+     DateTime begin(0, startSeconds);
+     DateTime finish = endSeconds >= DateTime::secondsPerDay ? DateTime(0, endSeconds) : begin.nextAt(endSeconds);
+     return saturatingCast<int32_t>((finish - begin).totalSeconds());
+ }
+
+ static_assert(actualDurationSeconds(9 * 3600, 10 * 3600) == 3600, "конец в тот же день");
+ static_assert(actualDurationSeconds(23 * 3600, 4 * 3600) == 5 * 3600, "конец раньше начала - следующие сутки");
+ static_assert(actualDurationSeconds(3600, 49 * 3600) == 48 * 3600, "конец больше суток - несколько дней");
+
+ #endif
@@ -4,93 +4,158 @@
  */
 
  #include "time.h"
+ #include "saturating.h"
+ #include <algorithm>
+ #include <atomic>
+ #include <charconv>
+ #include <cstring>
  #include <iostream>
+ #include <mutex>
+ #include <vector>
  
  using namespace std;
  
- size_t Time::operationCount_ = 0;
+ namespace {
  
- Time::Time() : totalSeconds_(0) {
-     operationCount_++;
+ // Счетчики одного потока. Пишет только поток-владелец, поэтому
+ // инкремент - это relaxed load + store без lock-префикса, а выравнивание
+ // по кэш-линии исключает ложное разделение между потоками.
+ struct alignas(64) CounterShard {
+     atomic<size_t> constructions{0};
+     atomic<size_t> copies{0};
+     atomic<size_t> moves{0};
+     atomic<size_t> arithmetic{0};
+ };
+ 
+ // Список живых шардов и сумма счетчиков завершившихся потоков
+ struct ShardRegistry {
+     mutex lock;
+     vector<const CounterShard*> live;
+     TimeStats retired{0, 0, 0, 0};
+ };
+ 
+ // Реестр намеренно не уничтожается: thread_local шарды могут
+ // отписываться после разрушения статических объектов
+ ShardRegistry& registry() {
+     static ShardRegistry* instance = new ShardRegistry;
+     return *instance;
  }
  
- Time::Time(int hours, int minutes, int seconds) {
-     totalSeconds_ = hours * 3600 + minutes * 60 + seconds;
-     operationCount_++;
+ struct ShardOwner {
+     CounterShard shard;
+     
+     ShardOwner() {
+         ShardRegistry& r = registry();
+         lock_guard<mutex> guard(r.lock);
+         r.live.push_back(&shard);
+     }
+     
+     ~ShardOwner() {
+         ShardRegistry& r = registry();
+         lock_guard<mutex> guard(r.lock);
+         r.retired.constructions += shard.constructions.load(memory_order_relaxed);
+         r.retired.copies += shard.copies.load(memory_order_relaxed);
+         r.retired.moves += shard.moves.load(memory_order_relaxed);
+         r.retired.arithmetic += shard.arithmetic.load(memory_order_relaxed);
+         r.live.erase(find(r.live.begin(), r.live.end(), &shard));
+     }
+ };
+ 
+ CounterShard& localShard() {
+     static thread_local ShardOwner owner;
+     return owner.shard;
  }
  
- Time::Time(const Time& other) : totalSeconds_(other.totalSeconds_) {
-     operationCount_++;
+ inline void bump(atomic<size_t>& counter) {
+     counter.store(counter.load(memory_order_relaxed) + 1, memory_order_relaxed);
  }
  
- Time::~Time() {
-     cout << "[DELETED] Time object with value ";
-     print();
-     cout << endl;
+ // Часы, минуты и секунды в общие секунды с насыщением: 600000 часов уже
+ // не помещаются в int, и прежнее hours * 3600 давало переполнение
+ int hmsToSeconds(int hours, int minutes, int seconds) {
+     long long total = static_cast<long long>(hours) * 3600 + static_cast<long long>(minutes) * 60 + seconds;
+     return saturatingCast<int>(total);
  }
  
- void Time::setTime(int hours, int minutes, int seconds) {
-     totalSeconds_ = hours * 3600 + minutes * 60 + seconds;
+ } // namespace
+ 
+ Time::Time() : totalSeconds_(0) {
+     bump(localShard().constructions);
  }
  
- int Time::getHours() const {
-     return totalSeconds_ / 3600;
+ Time::Time(int hours, int minutes, int seconds) {
+     totalSeconds_ = hmsToSeconds(hours, minutes, seconds);
+     bump(localShard().constructions);
  }
  
- int Time::getMinutes() const {
-     return (totalSeconds_ % 3600) / 60;
+ Time::Time(const Time& other) : totalSeconds_(other.totalSeconds_) {
+     bump(localShard().copies);
  }
  
- int Time::getSeconds() const {
-     return totalSeconds_ % 60;
+ Time::Time(Time&& other) noexcept : totalSeconds_(other.totalSeconds_) {
+     bump(localShard().moves);
  }
  
- int Time::getTotalSeconds() const {
-     return totalSeconds_;
+ Time::~Time() {
+     cout << "[DELETED] Time object with value ";
+     print();
+     cout << endl;
+ }
+ 
+ void Time::setTime(int hours, int minutes, int seconds) {
+     totalSeconds_ = hmsToSeconds(hours, minutes, seconds);
  }
  
  Time& Time::operator++() {
-     totalSeconds_++;
+     totalSeconds_ = saturatingAdd(totalSeconds_, 1);
+     bump(localShard().arithmetic);
      return *this;
  }
  
  Time Time::operator++(int) {
      Time temp(*this);
-     totalSeconds_++;
+     totalSeconds_ = saturatingAdd(totalSeconds_, 1);
+     bump(localShard().arithmetic);
      return temp;
  }
  
  Time& Time::operator--() {
      if (totalSeconds_ > 0) totalSeconds_--;
+     bump(localShard().arithmetic);
      return *this;
  }
  
  Time Time::operator--(int) {
      Time temp(*this);
      if (totalSeconds_ > 0) totalSeconds_--;
+     bump(localShard().arithmetic);
      return temp;
  }
  
  Time& Time::operator+=(const Time& other) {
-     totalSeconds_ += other.totalSeconds_;
+     totalSeconds_ = saturatingAdd(totalSeconds_, other.totalSeconds_);
+     bump(localShard().arithmetic);
      return *this;
  }
  
  Time& Time::operator-=(const Time& other) {
-     totalSeconds_ -= other.totalSeconds_;
+     totalSeconds_ = saturatingSub(totalSeconds_, other.totalSeconds_);
      if (totalSeconds_ < 0) totalSeconds_ = 0;
+     bump(localShard().arithmetic);
      return *this;
  }
  
  Time& Time::operator*=(double scalar) {
-     totalSeconds_ = static_cast<int>(totalSeconds_ * scalar);
+     totalSeconds_ = saturatingFromDouble<int>(totalSeconds_ * scalar);
+     bump(localShard().arithmetic);
      return *this;
  }
  
  Time& Time::operator/=(double scalar) {
      if (scalar != 0) {
-         totalSeconds_ = static_cast<int>(totalSeconds_ / scalar);
+         totalSeconds_ = saturatingFromDouble<int>(totalSeconds_ / scalar);
      }
+     bump(localShard().arithmetic);
      return *this;
  }
  
@@ -118,42 +183,141 @@
      return result;
  }
  
- bool Time::operator<(const Time& other) const {
-     return totalSeconds_ < other.totalSeconds_;
+ void Time::print() const {
+     char buffer[maxFormattedLength];
+     cout.write(buffer, formatTo(buffer) - buffer);
  }
  
- bool Time::operator>(const Time& other) const {
-     return totalSeconds_ > other.totalSeconds_;
+ char* Time::formatTo(char* out) const {
+     return formatSeconds(totalSeconds_, out);
  }
  
- bool Time::operator<=(const Time& other) const {
-     return totalSeconds_ <= other.totalSeconds_;
+ char* Time::formatSeconds(int totalSeconds, char* out) {
+     static const char digitPairs[] =
+         "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+         "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+         "8081828384858687888990919293949596979899";
+     
+     int hours = totalSeconds / 3600;
+     int minutes = (totalSeconds % 3600) / 60;
+     int seconds = totalSeconds % 60;
+     
+     // Часы без дополнения нулями, как при выводе в поток
+     if (hours >= 0 && hours < 10) {
+         *out++ = static_cast<char>('0' + hours);
+     } else if (hours >= 10 && hours < 100) {
+         memcpy(out, digitPairs + 2 * hours, 2);
+         out += 2;
+     } else {
+         out = to_chars(out, out + 7, hours).ptr;
+     }
+     
+     // Минуты и секунды: "0" перед значениями меньше 10 (и перед
+     // отрицательными - так же, как делал потоковый print)
+     for (int part : {minutes, seconds}) {
+         *out++ = ':';
+         if (part >= 0) {
+             memcpy(out, digitPairs + 2 * part, 2);
+             out += 2;
+         } else {
+             *out++ = '0';
+             out = to_chars(out, out + 3, part).ptr;
+         }
+     }
+     return out;
  }
  
- bool Time::operator>=(const Time& other) const {
-     return totalSeconds_ >= other.totalSeconds_;
+ namespace {
+ 
+ inline bool isBlank(char c) {
+     return c == ' ' || c == '\t' || c == '\r';
  }
  
- bool Time::operator==(const Time& other) const {
-     return totalSeconds_ == other.totalSeconds_;
+ inline const char* skipBlanks(const char* p, const char* last) {
+     while (p != last && isBlank(*p)) p++;
+     return p;
  }
  
- bool Time::operator!=(const Time& other) const {
-     return totalSeconds_ != other.totalSeconds_;
+ inline bool isDigit(char c) {
+     return static_cast<unsigned char>(c - '0') < 10;
  }
  
- void Time::print() const {
-     int hours = getHours();
-     int minutes = getMinutes();
-     int seconds = getSeconds();
+ } // namespace
+ 
+ TimeParseResult Time::parse(const char* first, const char* last, int& totalSeconds) {
+     const char* p = skipBlanks(first, last);
+     if (p == last || *p == '\n') return {p, TimeParseError::Empty};
+     
+     int fields[3];
+     char separator = 0; // ':' или ' ', не смешиваются
+     for (int k = 0; k < 3; k++) {
+         if (k > 0) {
+             if (p != last && *p == ':' && separator != ' ') {
+                 separator = ':';
+                 p++;
+             } else if (p != last && isBlank(*p) && separator != ':') {
+                 separator = ' ';
+                 p = skipBlanks(p, last);
+             } else {
+                 bool endOfLine = p == last || *p == '\n';
+                 return {p, endOfLine ? TimeParseError::MissingField : TimeParseError::InvalidCharacter};
+             }
+         }
+         
+         if (p == last || *p == '\n') return {p, TimeParseError::MissingField};
+         if (*p == '-') return {p, TimeParseError::Negative};
+         if (!isDigit(*p)) return {p, TimeParseError::InvalidCharacter};
+         
+         // Больше 9 цифр int не вмещает без проверки; длинные числа - переполнение
+         const char* digits = p;
+         int value = 0;
+         while (p != last && isDigit(*p)) {
+             if (p - digits == 9) return {digits, TimeParseError::Overflow};
+             value = value * 10 + (*p - '0');
+             p++;
+         }
+         fields[k] = value;
+     }
      
-     cout << hours << ":";
-     if (minutes < 10) cout << "0";
-     cout << minutes << ":";
-     if (seconds < 10) cout << "0";
-     cout << seconds;
+     p = skipBlanks(p, last);
+     if (p != last && *p != '\n') return {p, TimeParseError::TrailingCharacters};
+     if (fields[1] >= 60) return {first, TimeParseError::MinutesOutOfRange};
+     if (fields[2] >= 60) return {first, TimeParseError::SecondsOutOfRange};
+     if (fields[0] > (2147483647 - 3599) / 3600) return {first, TimeParseError::Overflow};
+     
+     totalSeconds = fields[0] * 3600 + fields[1] * 60 + fields[2];
+     return {p, TimeParseError::None};
+ }
+ 
+ const char* Time::parseErrorText(TimeParseError error) {
+     switch (error) {
+         case TimeParseError::None: return "нет ошибки";
+         case TimeParseError::Empty: return "пустая строка";
+         case TimeParseError::MissingField: return "нужно три числа: часы, минуты, секунды";
+         case TimeParseError::InvalidCharacter: return "недопустимый символ";
+         case TimeParseError::Negative: return "отрицательное значение";
+         case TimeParseError::MinutesOutOfRange: return "минуты должны быть меньше 60";
+         case TimeParseError::SecondsOutOfRange: return "секунды должны быть меньше 60";
+         case TimeParseError::Overflow: return "слишком большое значение";
+         case TimeParseError::TrailingCharacters: return "лишние символы после секунд";
+     }
+     return "неизвестная ошибка";
  }
  
  size_t Time::getOperationCount() {
-     return operationCount_;
- }
\ No newline at end of file
+     TimeStats stats = getOperationStats();
+     return stats.constructions + stats.copies + stats.moves;
+ }
+ 
+ TimeStats Time::getOperationStats() {
+     ShardRegistry& r = registry();
+     lock_guard<mutex> guard(r.lock);
+     TimeStats stats = r.retired;
+     for (const CounterShard* shard : r.live) {
+         stats.constructions += shard->constructions.load(memory_order_relaxed);
+         stats.copies += shard->copies.load(memory_order_relaxed);
+         stats.moves += shard->moves.load(memory_order_relaxed);
+         stats.arithmetic += shard->arithmetic.load(memory_order_relaxed);
+     }
+     return stats;
+ }
@@ -7,16 +7,62 @@
  #define TIME_H
  
  #include <cstddef>
+ #ifdef __cpp_impl_three_way_comparison
+ #include <compare>
+ #endif
+ 
+ /**
+  * @struct TimeStats
+  * @brief Счетчики операций Time, суммированные по всем потокам
+  */
+ struct TimeStats {
+     size_t constructions; ///< Создания конструкторами по умолчанию и параметризованным
+     size_t copies;        ///< Создания конструктором копирования
+     size_t moves;         ///< Создания конструктором перемещения
+     size_t arithmetic;    ///< Унарные операции и арифметическое присваивание
+ };
+ 
+ /**
+  * @brief Причина, по которой строку не удалось разобрать как время
+  */
+ enum class TimeParseError {
+     None,               ///< Ошибки нет
+     Empty,              ///< Пустая строка
+     MissingField,       ///< Меньше трёх чисел
+     InvalidCharacter,   ///< Посторонний символ вместо числа или разделителя
+     Negative,           ///< Отрицательное число
+     MinutesOutOfRange,  ///< Минуты не меньше 60
+     SecondsOutOfRange,  ///< Секунды не меньше 60
+     Overflow,           ///< Слишком большое значение
+     TrailingCharacters  ///< Лишние символы после секунд
+ };
+ 
+ /**
+  * @struct TimeParseResult
+  * @brief Результат разбора в стиле std::from_chars
+  */
+ struct TimeParseResult {
+     const char* ptr;      ///< Где остановился разбор (конец строки или место ошибки)
+     TimeParseError error; ///< Причина ошибки или None
+ };
  
  /**
   * @class Time
   * @brief Класс для работы с временем в формате часы:минуты:секунды
+  *
+  * Значение хранится в int и при переполнении прижимается к его границам
+  * (конструктор, сложение, умножение и деление). Для сумм за пределами
+  * int и долей секунды - TimeSpan из timespan.h.
+  *
+  * Методы доступа и сравнения определены в заголовке и встраиваются в
+  * место вызова. Конструкторы и деструктор остаются в time.cpp: они
+  * считают операции и печатают сообщение, поэтому не могут быть
+  * constexpr. Константы, вычисляемые при компиляции, - TimeValue и
+  * литералы из timevalue.h.
   */
  class Time {
  private:
      int totalSeconds_; ///< Общее количество секунд
-     
-     static size_t operationCount_; ///< Статический счетчик операций/объектов
  
  public:
      // Конструкторы 3 штуки
@@ -40,6 +86,20 @@
       */
      Time(const Time& other);
      
+     /**
+      * @brief Конструктор перемещения
+      * @param other Объект, значение которого забирается (остаётся прежним:
+      *              хранится одно int, и его деструктор выведет то же время)
+      *
+      * Объявленные копирование и деструктор подавляют неявное перемещение,
+      * поэтому оно объявлено явно и noexcept: std::vector<Time> при росте
+      * переносит элементы им, а не копированием.
+      */
+     Time(Time&& other) noexcept;
+     
+     Time& operator=(const Time& other) = default;     ///< Присваивание копированием
+     Time& operator=(Time&& other) noexcept = default; ///< Присваивание перемещением
+     
      /**
       * @brief Деструктор с выводом сообщения
       */
@@ -59,37 +119,79 @@
       * @brief Получить часы
       * @return Значение часов
       */
-     int getHours() const;
+     int getHours() const { return totalSeconds_ / 3600; }
      
      /**
       * @brief Получить минуты
       * @return Значение минут
       */
-     int getMinutes() const;
+     int getMinutes() const { return (totalSeconds_ % 3600) / 60; }
      
      /**
       * @brief Получить секунды
       * @return Значение секунд
       */
-     int getSeconds() const;
+     int getSeconds() const { return totalSeconds_ % 60; }
      
      /**
       * @brief Получить общее количество секунд
       * @return Общие секунды
       */
-     int getTotalSeconds() const;
+     int getTotalSeconds() const { return totalSeconds_; }
      
      /**
       * @brief Вывести время в формате HH:MM:SS
       */
      void print() const;
      
+     /// Наибольшая длина текста formatTo (отрицательные часы, минуты и секунды)
+     static constexpr size_t maxFormattedLength = 17;
+     
+     /**
+      * @brief Записать время в буфер в формате print() без выделения памяти
+      * @param out Буфер не короче maxFormattedLength символов
+      * @return Указатель за последним записанным символом (нуль не дописывается)
+      */
+     char* formatTo(char* out) const;
+     
+     /**
+      * @brief Записать произвольное число секунд в формате print()
+      * @param totalSeconds Общие секунды
+      * @param out Буфер не короче maxFormattedLength символов
+      * @return Указатель за последним записанным символом
+      */
+     static char* formatSeconds(int totalSeconds, char* out);
+     
+     /**
+      * @brief Разобрать время "Ч М С" или "Ч:ММ:СС" без выделения памяти
+      * @param first Начало текста
+      * @param last Конец текста
+      * @param totalSeconds Сюда записываются секунды при успехе
+      * @return Позиция остановки и код ошибки
+      *
+      * Правила те же, что при вводе с клавиатуры: числа неотрицательные,
+      * минуты и секунды меньше 60. Разбор заканчивается на '\n' или last;
+      * пробелы, табуляции и '\r' по краям допускаются.
+      */
+     static TimeParseResult parse(const char* first, const char* last, int& totalSeconds);
+     
+     /**
+      * @brief Описание ошибки разбора для сообщений пользователю
+      */
+     static const char* parseErrorText(TimeParseError error);
+     
      /**
       * @brief Получить количество операций/объектов
-      * @return Статистика работы
+      * @return Число созданных объектов Time (включая копии и перемещения) во всех потоках
       */
      static size_t getOperationCount();
      
+     /**
+      * @brief Получить счетчики операций по видам
+      * @return Сумма счетчиков всех потоков на момент вызова
+      */
+     static TimeStats getOperationStats();
+     
      // Унарные операторы (4 варианта)
      Time& operator++();       ///< Префиксный инкремент (+1 секунда)
      Time operator++(int);     ///< Постфиксный инкремент  
@@ -108,13 +210,18 @@
      Time operator*(double scalar) const;     ///< Умножение на скаляр
      Time operator/(double scalar) const;     ///< Деление на скаляр
  
-     // Бинарные операторы сравнения
-     bool operator<(const Time& other) const;  ///< Меньше
-     bool operator>(const Time& other) const;  ///< Больше
-     bool operator<=(const Time& other) const; ///< Меньше или равно
-     bool operator>=(const Time& other) const; ///< Больше или равно
-     bool operator==(const Time& other) const; ///< Равно
-     bool operator!=(const Time& other) const; ///< Не равно
+     // Бинарные операторы сравнения: по значению секунд, встраиваются
+ #ifdef __cpp_impl_three_way_comparison
+     auto operator<=>(const Time& other) const = default; ///< Все шесть сравнений (C++20)
+     bool operator==(const Time& other) const = default;  ///< Равно
+ #else
+     bool operator<(const Time& other) const { return totalSeconds_ < other.totalSeconds_; }   ///< Меньше
+     bool operator>(const Time& other) const { return totalSeconds_ > other.totalSeconds_; }   ///< Больше
+     bool operator<=(const Time& other) const { return totalSeconds_ <= other.totalSeconds_; } ///< Меньше или равно
+     bool operator>=(const Time& other) const { return totalSeconds_ >= other.totalSeconds_; } ///< Больше или равно
+     bool operator==(const Time& other) const { return totalSeconds_ == other.totalSeconds_; } ///< Равно
+     bool operator!=(const Time& other) const { return totalSeconds_ != other.totalSeconds_; } ///< Не равно
+ #endif
  };
  
- #endif
\ No newline at end of file
+ #endif
@@ -0,0 +1,358 @@
+/**
+ * @file timebatch.cpp
+ * @brief Реализация пакетных операций над секундами
+ *
+ * Векторные варианты собираются атрибутом target и выбираются во время
+ * выполнения, поэтому файл не требует особых флагов компилятора.
+ * Деление на 3600 и 60 выполняется в double: частное int32 на 3600
+ * представимо точно, а усечение cvttpd совпадает с целочисленным делением
+ * C++ (к нулю), в том числе для отрицательных значений.
+ *
+ * Сложение, вычитание и умножение насыщающие, как операторы Time:
+ * векторные варианты находят переполнение по знакам слагаемых и суммы и
+ * подставляют INT32_MAX или INT32_MIN, а произведение прижимают к
+ * границам int32 ещё в double, до cvttpd.
+ */
+
+ #include "timebatch.h"
+ #include "datetime.h"
+ #include "saturating.h"
+ #include <cstring>
+
+ #if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+ #define TIMEBATCH_X86 1
+ #include <immintrin.h>
+ #endif
+
+ using namespace std;
+
+ namespace {
+
+ // Скалярные варианты: те же выражения, что в операторах Time
+
+ void addScalar(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     for (size_t i = 0; i < n; i++) out[i] = saturatingAdd(a[i], b[i]);
+ }
+
+ void subtractScalar(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     for (size_t i = 0; i < n; i++) {
+         int32_t r = saturatingSub(a[i], b[i]);
+         out[i] = r < 0 ? 0 : r;
+     }
+ }
+
+ void scaleScalar(const int32_t* a, double scalar, int32_t* out, size_t n) {
+     for (size_t i = 0; i < n; i++) out[i] = saturatingFromDouble<int32_t>(a[i] * scalar);
+ }
+
+ void compareScalar(const int32_t* a, const int32_t* b, int8_t* out, size_t n) {
+     for (size_t i = 0; i < n; i++) out[i] = static_cast<int8_t>((a[i] > b[i]) - (a[i] < b[i]));
+ }
+
+ void splitScalar(const int32_t* a, int32_t* hours, int32_t* minutes, int32_t* seconds, size_t n) {
+     for (size_t i = 0; i < n; i++) {
+         int32_t total = a[i];
+         hours[i] = total / 3600;
+         minutes[i] = (total % 3600) / 60;
+         seconds[i] = total % 60;
+     }
+ }
+
+ #ifdef TIMEBATCH_X86
+
+ // SSE2 (есть на любом x86-64)
+
+ // Переполнение - знаковый бит overflow: подставить INT32_MAX для
+ // неотрицательного x и INT32_MIN для отрицательного
+ __attribute__((target("sse2")))
+ inline __m128i saturateSse2(__m128i r, __m128i x, __m128i overflow) {
+     __m128i mask = _mm_srai_epi32(overflow, 31);
+     __m128i bound = _mm_xor_si128(_mm_srai_epi32(x, 31), _mm_set1_epi32(INT32_MAX));
+     return _mm_or_si128(_mm_and_si128(mask, bound), _mm_andnot_si128(mask, r));
+ }
+
+ // Произведение в границах int32 (NaN - ноль, как saturatingFromDouble)
+ __attribute__((target("sse2")))
+ inline __m128d clampSse2(__m128d x) {
+     x = _mm_and_pd(x, _mm_cmpord_pd(x, x));
+     return _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(INT32_MIN)), _mm_set1_pd(INT32_MAX));
+ }
+
+ __attribute__((target("sse2")))
+ void addSse2(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     size_t i = 0;
+     for (; i + 4 <= n; i += 4) {
+         __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+         __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+         __m128i r = _mm_add_epi32(x, y);
+         // Переполнение: знак суммы отличается от знаков обоих слагаемых
+         __m128i overflow = _mm_and_si128(_mm_xor_si128(r, x), _mm_xor_si128(r, y));
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), saturateSse2(r, x, overflow));
+     }
+     addScalar(a + i, b + i, out + i, n - i);
+ }
+
+ __attribute__((target("sse2")))
+ void subtractSse2(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     size_t i = 0;
+     for (; i + 4 <= n; i += 4) {
+         __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+         __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+         __m128i r = _mm_sub_epi32(x, y);
+         // Переполнение: знаки x и y разные, и знак разности не как у x
+         __m128i overflow = _mm_and_si128(_mm_xor_si128(x, y), _mm_xor_si128(x, r));
+         r = saturateSse2(r, x, overflow);
+         r = _mm_and_si128(r, _mm_cmpgt_epi32(r, _mm_setzero_si128()));
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+     }
+     subtractScalar(a + i, b + i, out + i, n - i);
+ }
+
+ __attribute__((target("sse2")))
+ void scaleSse2(const int32_t* a, double scalar, int32_t* out, size_t n) {
+     __m128d k = _mm_set1_pd(scalar);
+     size_t i = 0;
+     for (; i + 2 <= n; i += 2) {
+         __m128d x = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i)));
+         _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_cvttpd_epi32(clampSse2(_mm_mul_pd(x, k))));
+     }
+     scaleScalar(a + i, scalar, out + i, n - i);
+ }
+
+ __attribute__((target("sse2")))
+ void compareSse2(const int32_t* a, const int32_t* b, int8_t* out, size_t n) {
+     size_t i = 0;
+     for (; i + 4 <= n; i += 4) {
+         __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+         __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+         // Маски сравнений равны -1, поэтому (a < b) - (a > b) даёт -1, 0 или 1
+         __m128i r = _mm_sub_epi32(_mm_cmplt_epi32(x, y), _mm_cmpgt_epi32(x, y));
+         __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(r, r), _mm_setzero_si128());
+         int32_t packed = _mm_cvtsi128_si32(bytes);
+         memcpy(out + i, &packed, 4);
+     }
+     compareScalar(a + i, b + i, out + i, n - i);
+ }
+
+ __attribute__((target("sse2")))
+ void splitSse2(const int32_t* a, int32_t* hours, int32_t* minutes, int32_t* seconds, size_t n) {
+     const __m128d hour = _mm_set1_pd(3600.0);
+     const __m128d minute = _mm_set1_pd(60.0);
+     size_t i = 0;
+     for (; i + 2 <= n; i += 2) {
+         __m128d x = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i)));
+         __m128i h = _mm_cvttpd_epi32(_mm_div_pd(x, hour));
+         __m128d rest = _mm_sub_pd(x, _mm_mul_pd(_mm_cvtepi32_pd(h), hour));
+         __m128i m = _mm_cvttpd_epi32(_mm_div_pd(rest, minute));
+         __m128i s = _mm_cvttpd_epi32(_mm_sub_pd(rest, _mm_mul_pd(_mm_cvtepi32_pd(m), minute)));
+         _mm_storel_epi64(reinterpret_cast<__m128i*>(hours + i), h);
+         _mm_storel_epi64(reinterpret_cast<__m128i*>(minutes + i), m);
+         _mm_storel_epi64(reinterpret_cast<__m128i*>(seconds + i), s);
+     }
+     splitScalar(a + i, hours + i, minutes + i, seconds + i, n - i);
+ }
+
+ // AVX2
+
+ __attribute__((target("avx2")))
+ inline __m256i saturateAvx2(__m256i r, __m256i x, __m256i overflow) {
+     __m256i bound = _mm256_xor_si256(_mm256_srai_epi32(x, 31), _mm256_set1_epi32(INT32_MAX));
+     return _mm256_blendv_epi8(r, bound, _mm256_srai_epi32(overflow, 31));
+ }
+
+ __attribute__((target("avx2")))
+ inline __m256d clampAvx2(__m256d x) {
+     x = _mm256_and_pd(x, _mm256_cmp_pd(x, x, _CMP_ORD_Q));
+     return _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(INT32_MIN)), _mm256_set1_pd(INT32_MAX));
+ }
+
+ __attribute__((target("avx2")))
+ void addAvx2(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     size_t i = 0;
+     for (; i + 8 <= n; i += 8) {
+         __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+         __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+         __m256i r = _mm256_add_epi32(x, y);
+         __m256i overflow = _mm256_and_si256(_mm256_xor_si256(r, x), _mm256_xor_si256(r, y));
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), saturateAvx2(r, x, overflow));
+     }
+     addScalar(a + i, b + i, out + i, n - i);
+ }
+
+ __attribute__((target("avx2")))
+ void subtractAvx2(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     size_t i = 0;
+     for (; i + 8 <= n; i += 8) {
+         __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+         __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+         __m256i r = _mm256_sub_epi32(x, y);
+         __m256i overflow = _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, r));
+         r = _mm256_max_epi32(saturateAvx2(r, x, overflow), _mm256_setzero_si256());
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+     }
+     subtractScalar(a + i, b + i, out + i, n - i);
+ }
+
+ __attribute__((target("avx2")))
+ void scaleAvx2(const int32_t* a, double scalar, int32_t* out, size_t n) {
+     __m256d k = _mm256_set1_pd(scalar);
+     size_t i = 0;
+     for (; i + 4 <= n; i += 4) {
+         __m256d x = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvttpd_epi32(clampAvx2(_mm256_mul_pd(x, k))));
+     }
+     scaleScalar(a + i, scalar, out + i, n - i);
+ }
+
+ __attribute__((target("avx2")))
+ void compareAvx2(const int32_t* a, const int32_t* b, int8_t* out, size_t n) {
+     size_t i = 0;
+     for (; i + 8 <= n; i += 8) {
+         __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+         __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+         __m256i r = _mm256_sub_epi32(_mm256_cmpgt_epi32(y, x), _mm256_cmpgt_epi32(x, y));
+         __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+         _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi16(words, words));
+     }
+     compareScalar(a + i, b + i, out + i, n - i);
+ }
+
+ __attribute__((target("avx2")))
+ void splitAvx2(const int32_t* a, int32_t* hours, int32_t* minutes, int32_t* seconds, size_t n) {
+     const __m256d hour = _mm256_set1_pd(3600.0);
+     const __m256d minute = _mm256_set1_pd(60.0);
+     size_t i = 0;
+     for (; i + 4 <= n; i += 4) {
+         __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+         __m128i h = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(v), hour));
+         __m128i rest = _mm_sub_epi32(v, _mm_mullo_epi32(h, _mm_set1_epi32(3600)));
+         __m128i m = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(rest), minute));
+         __m128i s = _mm_sub_epi32(rest, _mm_mullo_epi32(m, _mm_set1_epi32(60)));
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(hours + i), h);
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(minutes + i), m);
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(seconds + i), s);
+     }
+     splitScalar(a + i, hours + i, minutes + i, seconds + i, n - i);
+ }
+
+ #endif
+
+ bool isaSupported(TimeBatchIsa isa) {
+     switch (isa) {
+         case TimeBatchIsa::Scalar:
+             return true;
+ #ifdef TIMEBATCH_X86
+         case TimeBatchIsa::Sse2:
+             return __builtin_cpu_supports("sse2");
+         case TimeBatchIsa::Avx2:
+             return __builtin_cpu_supports("avx2");
+ #endif
+         default:
+             return false;
+     }
+ }
+
+ TimeBatchIsa detectIsa() {
+     if (isaSupported(TimeBatchIsa::Avx2)) return TimeBatchIsa::Avx2;
+     if (isaSupported(TimeBatchIsa::Sse2)) return TimeBatchIsa::Sse2;
+     return TimeBatchIsa::Scalar;
+ }
+
+ TimeBatchIsa& currentIsa() {
+     static TimeBatchIsa isa = detectIsa();
+     return isa;
+ }
+
+ } // namespace
+
+ TimeBatchIsa timeBatchIsa() {
+     return currentIsa();
+ }
+
+ bool setTimeBatchIsa(TimeBatchIsa isa) {
+     if (!isaSupported(isa)) return false;
+     currentIsa() = isa;
+     return true;
+ }
+
+ #ifdef TIMEBATCH_X86
+ #define TIMEBATCH_DISPATCH(name, ...)                                    \
+     switch (currentIsa()) {                                              \
+         case TimeBatchIsa::Avx2: name##Avx2(__VA_ARGS__); return;        \
+         case TimeBatchIsa::Sse2: name##Sse2(__VA_ARGS__); return;        \
+         default: name##Scalar(__VA_ARGS__); return;                      \
+     }
+ #else
+ #define TIMEBATCH_DISPATCH(name, ...) name##Scalar(__VA_ARGS__);
+ #endif
+
+ void addTimes(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     TIMEBATCH_DISPATCH(add, a, b, out, n)
+ }
+
+ void subtractTimes(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+     TIMEBATCH_DISPATCH(subtract, a, b, out, n)
+ }
+
+ void scaleTimes(const int32_t* a, double scalar, int32_t* out, size_t n) {
+     TIMEBATCH_DISPATCH(scale, a, scalar, out, n)
+ }
+
+ void compareTimes(const int32_t* a, const int32_t* b, int8_t* out, size_t n) {
+     TIMEBATCH_DISPATCH(compare, a, b, out, n)
+ }
+
+ void splitTimes(const int32_t* a, int32_t* hours, int32_t* minutes, int32_t* seconds, size_t n) {
+     TIMEBATCH_DISPATCH(split, a, hours, minutes, seconds, n)
+ }
+
+ char* formatTimes(const int32_t* a, size_t n, char* out, char separator) {
+     for (size_t i = 0; i < n; i++) {
+         out = Time::formatSeconds(a[i], out);
+         *out++ = separator;
+     }
+     return out;
+ }
+
+ // Без векторных вариантов: перевод Нери - Шнайдера - несколько умножений
+ // и сдвигов без таблиц, и скалярный цикл уже в разы быстрее gmtime_r
+ void splitDates(const int32_t* days, int32_t* years, int32_t* months, int32_t* daysOfMonth, size_t n) {
+     for (size_t i = 0; i < n; i++) {
+         CivilDate date = civilFromDays(days[i]);
+         years[i] = date.year;
+         months[i] = static_cast<int32_t>(date.month);
+         daysOfMonth[i] = static_cast<int32_t>(date.day);
+     }
+ }
+
+ char* formatDateTimes(const int64_t* unixSeconds, size_t n, char* out, char separator) {
+     for (size_t i = 0; i < n; i++) {
+         out = DateTime::fromUnixSeconds(unixSeconds[i]).formatTo(out);
+         *out++ = separator;
+     }
+     return out;
+ }
+
+ size_t parseTimes(const char* first, const char* last, int32_t* out, size_t capacity,
+                   vector<TimeLineError>* errors) {
+     size_t count = 0;
+     size_t line = 0;
+     const char* p = first;
+     while (p != last && count < capacity) {
+         line++;
+         int value;
+         TimeParseResult result = Time::parse(p, last, value);
+         if (result.error == TimeParseError::None) {
+             out[count++] = value;
+             p = result.ptr;
+         } else {
+             if (result.error != TimeParseError::Empty && errors != nullptr) {
+                 errors->push_back(TimeLineError{line, result.error});
+             }
+             p = static_cast<const char*>(memchr(result.ptr, '\n', last - result.ptr));
+             if (p == nullptr) p = last;
+         }
+         if (p != last) p++; // '\n'
+     }
+     return count;
+ }
@@ -0,0 +1,114 @@
+/**
+ * @file timebatch.h
+ * @brief Пакетные операции над массивами секунд (SSE2/AVX2 с запасным скалярным вариантом)
+ */
+
+ #ifndef TIMEBATCH_H
+ #define TIMEBATCH_H
+
+ #include "time.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <vector>
+
+ /**
+  * @brief Набор инструкций, которым выполняются пакетные операции
+  */
+ enum class TimeBatchIsa {
+     Scalar, ///< Обычный цикл
+     Sse2,   ///< 128-битные регистры
+     Avx2    ///< 256-битные регистры
+ };
+
+ /**
+  * @brief Текущий набор инструкций (по умолчанию - лучший из доступных)
+  */
+ TimeBatchIsa timeBatchIsa();
+
+ /**
+  * @brief Принудительно выбрать набор инструкций (для замеров)
+  * @param isa Желаемый набор
+  * @return false, если процессор его не поддерживает (выбор не меняется)
+  *
+  * Не потокобезопасно: вызывать до запуска пакетной обработки.
+  */
+ bool setTimeBatchIsa(TimeBatchIsa isa);
+
+ // Все функции принимают массивы по n элементов; выходной массив может
+ // совпадать с входным. Семантика - как у операторов Time, включая
+ // насыщение: результат за границами int32 прижимается к ним.
+
+ /**
+  * @brief out[i] = a[i] + b[i] с насыщением (как Time::operator+=)
+  */
+ void addTimes(const int32_t* a, const int32_t* b, int32_t* out, size_t n);
+
+ /**
+  * @brief out[i] = max(a[i] - b[i], 0), разность с насыщением (как Time::operator-=)
+  */
+ void subtractTimes(const int32_t* a, const int32_t* b, int32_t* out, size_t n);
+
+ /**
+  * @brief out[i] = a[i] * scalar без дробной части, в границах int32, NaN - 0 (как Time::operator*=)
+  */
+ void scaleTimes(const int32_t* a, double scalar, int32_t* out, size_t n);
+
+ /**
+  * @brief out[i] = -1, 0 или 1, если a[i] меньше, равно или больше b[i]
+  */
+ void compareTimes(const int32_t* a, const int32_t* b, int8_t* out, size_t n);
+
+ /**
+  * @brief Разложить секунды на часы, минуты и секунды (как getHours/getMinutes/getSeconds)
+  */
+ void splitTimes(const int32_t* a, int32_t* hours, int32_t* minutes, int32_t* seconds, size_t n);
+
+ /**
+  * @brief Записать столбец времён в текст (как Time::formatTo), ставя separator после каждого
+  * @param a Секунды
+  * @param n Число значений
+  * @param out Буфер не короче n * (Time::maxFormattedLength + 1) символов
+  * @param separator Символ после каждого значения (например, '\n')
+  * @return Указатель за последним записанным символом
+  */
+ char* formatTimes(const int32_t* a, size_t n, char* out, char separator);
+
+ /**
+  * @brief Разложить номера дней от 1970-01-01 на год, месяц и день (как civilFromDays из datetime.h)
+  */
+ void splitDates(const int32_t* days, int32_t* years, int32_t* months, int32_t* daysOfMonth, size_t n);
+
+ /**
+  * @brief Записать моменты как ГГГГ-ММ-ДД ЧЧ:ММ:СС (как DateTime::formatTo), ставя separator после каждого
+  * @param unixSeconds Секунды от 1970-01-01 00:00:00 UTC
+  * @param n Число значений
+  * @param out Буфер не короче n * (DateTime::maxFormattedLength + 1) символов
+  * @param separator Символ после каждого значения
+  * @return Указатель за последним записанным символом
+  */
+ char* formatDateTimes(const int64_t* unixSeconds, size_t n, char* out, char separator);
+
+ /**
+  * @struct TimeLineError
+  * @brief Строка, не прошедшая пакетный разбор
+  */
+ struct TimeLineError {
+     size_t line;          ///< Номер строки, начиная с 1
+     TimeParseError error; ///< Причина
+ };
+
+ /**
+  * @brief Разобрать буфер строк "Ч М С" или "Ч:ММ:СС" (как Time::parse)
+  * @param first Начало текста
+  * @param last Конец текста
+  * @param out Массив для секунд
+  * @param capacity Размер out; разбор останавливается, когда он заполнен
+  * @param errors Если не nullptr, сюда дописываются ошибочные строки
+  * @return Количество разобранных значений
+  *
+  * Пустые строки пропускаются, ошибочные - пропускаются и учитываются в errors.
+  */
+ size_t parseTimes(const char* first, const char* last, int32_t* out, size_t capacity,
+                   std::vector<TimeLineError>* errors = nullptr);
+
+ #endif
@@ -0,0 +1,213 @@
+/**
+ * @file timespan.h
+ * @brief Длительность с настраиваемым типом тиков и точностью, без переполнений
+ */
+
+ #ifndef TIMESPAN_H
+ #define TIMESPAN_H
+
+ #include "saturating.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <limits>
+ #include <type_traits>
+
+ /**
+  * @class TimeSpan
+  * @brief Знаковая длительность: Rep тиков по 1/TicksPerSecond секунды
+  * @tparam Rep Знаковый целый тип счётчика (int32_t, int64_t)
+  * @tparam TicksPerSecond Тиков в секунде: 1, 1000, ..., 1000000000
+  *
+  * В отличие от Time и TimeValue, разность может быть отрицательной, а
+  * все операции насыщающие: результат за границами Rep прижимается к
+  * max() или min(). Варианты checkedAdd, checkedSub и checkedMul
+  * сообщают о переполнении и не меняют значение. Деление на ноль
+  * оставляет значение без изменений, как в Time.
+  *
+  * Тип тривиально копируемый, все операции constexpr и inline: в
+  * горячем цикле сложение - это add и условный переход по флагу
+  * переполнения.
+  */
+ template <typename Rep, int64_t TicksPerSecond>
+ class TimeSpan {
+     static_assert(std::is_integral<Rep>::value && std::is_signed<Rep>::value, "нужен знаковый целый тип тиков");
+     static_assert(TicksPerSecond > 0, "тиков в секунде должно быть больше нуля");
+
+ private:
+     Rep ticks_ = 0; ///< Тики
+
+     static constexpr int fractionDigitsOf(int64_t ticks) {
+         return ticks == 1 ? 0 : 1 + fractionDigitsOf(ticks / 10);
+     }
+     static constexpr bool isPowerOfTen(int64_t ticks) {
+         return ticks == 1 || (ticks % 10 == 0 && isPowerOfTen(ticks / 10));
+     }
+     static_assert(isPowerOfTen(TicksPerSecond), "тиков в секунде должно быть 10^k");
+
+     // Целый множитель и делитель - шаблон: иначе вызов с int неоднозначен
+     // между перегрузками для int64_t и double
+     template <typename I>
+     using IfInteger = typename std::enable_if<std::is_integral<I>::value, int>::type;
+
+ public:
+     using rep = Rep;                                           ///< Тип тиков
+     static constexpr int64_t ticksPerSecond = TicksPerSecond;  ///< Тиков в секунде
+     static constexpr int fractionDigits = fractionDigitsOf(TicksPerSecond); ///< Знаков дробной части
+
+     /// Наибольшая длина текста formatTo: знак, все цифры тиков, разделители
+     static constexpr size_t maxFormattedLength =
+         1 + (std::numeric_limits<Rep>::digits10 + 1) + 4 + 2 + 1 + fractionDigits;
+
+     constexpr TimeSpan() noexcept = default;
+
+     static constexpr TimeSpan fromTicks(Rep ticks) noexcept { ///< Из тиков
+         TimeSpan span;
+         span.ticks_ = ticks;
+         return span;
+     }
+
+     /**
+      * @brief Из целых секунд (с насыщением)
+      */
+     static constexpr TimeSpan fromSeconds(int64_t seconds) noexcept {
+         return fromTicks(saturatingCast<Rep>(saturatingMul<int64_t>(seconds, TicksPerSecond)));
+     }
+
+     /**
+      * @brief Из часов, минут и секунд (с насыщением, в отличие от Time(int, int, int))
+      */
+     static constexpr TimeSpan fromHms(int64_t hours, int64_t minutes, int64_t seconds) noexcept {
+         int64_t total = saturatingAdd(saturatingAdd(saturatingMul<int64_t>(hours, 3600),
+                                                     saturatingMul<int64_t>(minutes, 60)), seconds);
+         return fromSeconds(total);
+     }
+
+     static constexpr TimeSpan zero() noexcept { return TimeSpan(); }                                    ///< Ноль
+     static constexpr TimeSpan max() noexcept { return fromTicks(std::numeric_limits<Rep>::max()); }  ///< Наибольшее
+     static constexpr TimeSpan min() noexcept { return fromTicks(std::numeric_limits<Rep>::min()); }  ///< Наименьшее
+
+     constexpr Rep ticks() const noexcept { return ticks_; }                                ///< Тики
+     constexpr int64_t totalSeconds() const noexcept { return ticks_ / TicksPerSecond; }   ///< Целые секунды (к нулю)
+     constexpr Rep subsecondTicks() const noexcept { return static_cast<Rep>(ticks_ % TicksPerSecond); } ///< Остаток
+
+     // Арифметика с насыщением
+     constexpr TimeSpan& operator+=(TimeSpan other) noexcept {
+         ticks_ = saturatingAdd(ticks_, other.ticks_);
+         return *this;
+     }
+     constexpr TimeSpan& operator-=(TimeSpan other) noexcept {
+         ticks_ = saturatingSub(ticks_, other.ticks_);
+         return *this;
+     }
+     template <typename I, IfInteger<I> = 0>
+     constexpr TimeSpan& operator*=(I factor) noexcept {
+         ticks_ = saturatingCast<Rep>(saturatingMul<int64_t>(ticks_, saturatingCast<int64_t>(factor)));
+         return *this;
+     }
+     constexpr TimeSpan& operator*=(double scalar) noexcept {
+         ticks_ = saturatingFromDouble<Rep>(static_cast<double>(ticks_) * scalar);
+         return *this;
+     }
+     template <typename I, IfInteger<I> = 0>
+     constexpr TimeSpan& operator/=(I divisor) noexcept {
+         // min() / -1 не помещается в Rep
+         if (std::is_signed<I>::value && divisor == static_cast<I>(-1)) return *this = -*this;
+         if (divisor != 0) ticks_ = saturatingCast<Rep>(static_cast<int64_t>(ticks_) / saturatingCast<int64_t>(divisor));
+         return *this;
+     }
+     constexpr TimeSpan& operator/=(double scalar) noexcept {
+         if (scalar != 0) ticks_ = saturatingFromDouble<Rep>(static_cast<double>(ticks_) / scalar);
+         return *this;
+     }
+
+     constexpr TimeSpan operator-() const noexcept { return fromTicks(saturatingSub<Rep>(0, ticks_)); }
+     constexpr TimeSpan operator+(TimeSpan other) const noexcept { return TimeSpan(*this) += other; }
+     constexpr TimeSpan operator-(TimeSpan other) const noexcept { return TimeSpan(*this) -= other; }
+     template <typename I, IfInteger<I> = 0>
+     constexpr TimeSpan operator*(I factor) const noexcept { return TimeSpan(*this) *= factor; }
+     constexpr TimeSpan operator*(double scalar) const noexcept { return TimeSpan(*this) *= scalar; }
+     template <typename I, IfInteger<I> = 0>
+     constexpr TimeSpan operator/(I divisor) const noexcept { return TimeSpan(*this) /= divisor; }
+     constexpr TimeSpan operator/(double scalar) const noexcept { return TimeSpan(*this) /= scalar; }
+
+     // Арифметика с проверкой: при переполнении возвращает false и не меняет значение
+     constexpr bool checkedAdd(TimeSpan other) noexcept { return ::checkedAdd(ticks_, other.ticks_, ticks_); }
+     constexpr bool checkedSub(TimeSpan other) noexcept { return ::checkedSub(ticks_, other.ticks_, ticks_); }
+     constexpr bool checkedMul(Rep factor) noexcept { return ::checkedMul(ticks_, factor, ticks_); }
+
+     // Сравнение
+     constexpr bool operator<(TimeSpan other) const noexcept { return ticks_ < other.ticks_; }
+     constexpr bool operator>(TimeSpan other) const noexcept { return ticks_ > other.ticks_; }
+     constexpr bool operator<=(TimeSpan other) const noexcept { return ticks_ <= other.ticks_; }
+     constexpr bool operator>=(TimeSpan other) const noexcept { return ticks_ >= other.ticks_; }
+     constexpr bool operator==(TimeSpan other) const noexcept { return ticks_ == other.ticks_; }
+     constexpr bool operator!=(TimeSpan other) const noexcept { return ticks_ != other.ticks_; }
+
+     /**
+      * @brief Записать длительность как [-]Ч:ММ:СС[.дробь] без выделения памяти
+      * @param out Буфер не короче maxFormattedLength символов
+      * @return Указатель за последним записанным символом
+      */
+     char* formatTo(char* out) const noexcept {
+         // Модуль в беззнаковом типе: -min() не помещается в Rep
+         uint64_t magnitude = ticks_ < 0 ? 0 - static_cast<uint64_t>(ticks_) : static_cast<uint64_t>(ticks_);
+         if (ticks_ < 0) *out++ = '-';
+         uint64_t fraction = magnitude % TicksPerSecond;
+         uint64_t seconds = magnitude / TicksPerSecond;
+         uint64_t hours = seconds / 3600;
+
+         char digits[24];
+         int count = 0;
+         do {
+             digits[count++] = static_cast<char>('0' + hours % 10);
+             hours /= 10;
+         } while (hours > 0);
+         while (count > 0) *out++ = digits[--count];
+         unsigned minutes = static_cast<unsigned>(seconds % 3600 / 60);
+         unsigned rest = static_cast<unsigned>(seconds % 60);
+         *out++ = ':';
+         *out++ = static_cast<char>('0' + minutes / 10);
+         *out++ = static_cast<char>('0' + minutes % 10);
+         *out++ = ':';
+         *out++ = static_cast<char>('0' + rest / 10);
+         *out++ = static_cast<char>('0' + rest % 10);
+         if (fractionDigits > 0) {
+             *out++ = '.';
+             for (int d = fractionDigits; d-- > 0;) {
+                 out[d] = static_cast<char>('0' + fraction % 10);
+                 fraction /= 10;
+             }
+             out += fractionDigits;
+         }
+         return out;
+     }
+ };
+
+ using TimeSpan32 = TimeSpan<int32_t, 1>;          ///< Секунды в int32_t: диапазон Time, но с насыщением
+ using TimeSpan64 = TimeSpan<int64_t, 1>;          ///< Секунды в int64_t: разности DateTime
+ using TimeSpanMs = TimeSpan<int64_t, 1000>;       ///< Миллисекунды: ±292 миллиона лет
+ using TimeSpanNs = TimeSpan<int64_t, 1000000000>; ///< Наносекунды: ±292 года
+
+ /**
+  * @brief Перевести длительность в другую точность
+  * @tparam To Целевой тип TimeSpan
+  * @return Значение с отброшенными лишними знаками (к нулю), за границами To - насыщенное
+  */
+ template <typename To, typename Rep, int64_t TicksPerSecond>
+ constexpr To timeSpanCast(TimeSpan<Rep, TicksPerSecond> from) noexcept {
+     using ToRep = typename To::rep;
+     if (To::ticksPerSecond >= TicksPerSecond) {
+         int64_t factor = To::ticksPerSecond / TicksPerSecond;
+         return To::fromTicks(saturatingCast<ToRep>(saturatingMul<int64_t>(from.ticks(), factor)));
+     }
+     int64_t divisor = TicksPerSecond / To::ticksPerSecond;
+     return To::fromTicks(saturatingCast<ToRep>(static_cast<int64_t>(from.ticks()) / divisor));
+ }
+
+ static_assert(std::is_trivially_copyable<TimeSpanNs>::value, "TimeSpan должен быть тривиально копируемым");
+ static_assert(sizeof(TimeSpan32) == sizeof(int32_t) && sizeof(TimeSpanNs) == sizeof(int64_t),
+               "TimeSpan не должен содержать ничего, кроме тиков");
+ static_assert((TimeSpan32::max() + TimeSpan32::fromSeconds(1)) == TimeSpan32::max(), "сложение насыщается");
+ static_assert(timeSpanCast<TimeSpan32>(TimeSpanNs::fromHms(1, 0, 1)).ticks() == 3601, "перевод точности");
+
+ #endif
@@ -0,0 +1,14 @@
+/**
+ * @file timevalue.cpp
+ * @brief Реализация методов TimeValue, не вошедших в заголовок
+ */
+
+ #include "timevalue.h"
+ #include <iostream>
+ 
+ using namespace std;
+ 
+ void TimeValue::print() const {
+     char buffer[Time::maxFormattedLength];
+     cout.write(buffer, formatTo(buffer) - buffer);
+ }
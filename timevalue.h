@@ -0,0 +1,181 @@
+/**
+ * @file timevalue.h
+ * @brief Легковесный тип-значение TimeValue для массовых вычислений
+ */
+
+ #ifndef TIMEVALUE_H
+ #define TIMEVALUE_H
+
+ #include "time.h"
+ #include "saturating.h"
+ #include <limits>
+ #include <type_traits>
+
+ /**
+  * @class TimeValue
+  * @brief Время в секундах без побочных эффектов
+  *
+  * Семантика операторов совпадает с Time (вычитание и декремент
+  * ограничены нулём, умножение и деление отбрасывают дробную часть,
+  * переполнение int насыщается),
+  * но объект тривиально копируемый: конструкторы и деструктор не
+  * увеличивают счётчик операций и ничего не выводят. Подходит для
+  * пакетной обработки, где создаются миллионы временных значений.
+  * Все операции, кроме вывода и преобразования в Time, - constexpr.
+  */
+ class TimeValue {
+ private:
+     int totalSeconds_ = 0; ///< Общее количество секунд
+
+ public:
+     /**
+      * @brief Конструктор по умолчанию. Создает время 00:00:00
+      */
+     constexpr TimeValue() noexcept = default;
+
+     /**
+      * @brief Параметризованный конструктор
+      * @param hours Часы
+      * @param minutes Минуты
+      * @param seconds Секунды
+      */
+     constexpr TimeValue(int hours, int minutes, int seconds) noexcept
+         : totalSeconds_(saturatingCast<int>(static_cast<long long>(hours) * 3600
+                                             + static_cast<long long>(minutes) * 60 + seconds)) {}
+
+     /**
+      * @brief Преобразование из Time
+      * @param time Исходное время
+      */
+     explicit TimeValue(const Time& time) noexcept
+         : totalSeconds_(time.getTotalSeconds()) {}
+
+     constexpr TimeValue(const TimeValue&) noexcept = default;
+     constexpr TimeValue& operator=(const TimeValue&) noexcept = default;
+     ~TimeValue() = default;
+
+     /**
+      * @brief Создать значение из общего числа секунд
+      * @param totalSeconds Секунды
+      * @return Новое значение
+      */
+     static constexpr TimeValue fromSeconds(int totalSeconds) noexcept {
+         return TimeValue(0, 0, totalSeconds);
+     }
+
+     /**
+      * @brief Преобразовать в Time
+      * @return Объект Time с тем же значением
+      */
+     Time toTime() const {
+         return Time(0, 0, totalSeconds_);
+     }
+
+     constexpr int getHours() const noexcept { return totalSeconds_ / 3600; }          ///< Часы
+     constexpr int getMinutes() const noexcept { return (totalSeconds_ % 3600) / 60; } ///< Минуты
+     constexpr int getSeconds() const noexcept { return totalSeconds_ % 60; }          ///< Секунды
+     constexpr int getTotalSeconds() const noexcept { return totalSeconds_; }          ///< Общие секунды
+
+     /**
+      * @brief Вывести время в формате H:MM:SS
+      */
+     void print() const;
+     
+     /**
+      * @brief Записать время в буфер (см. Time::formatTo)
+      * @param out Буфер не короче Time::maxFormattedLength символов
+      * @return Указатель за последним записанным символом
+      */
+     char* formatTo(char* out) const {
+         return Time::formatSeconds(totalSeconds_, out);
+     }
+
+     // Унарные операторы
+     constexpr TimeValue& operator++() noexcept {
+         totalSeconds_ = saturatingAdd(totalSeconds_, 1);
+         return *this;
+     }
+     constexpr TimeValue operator++(int) noexcept {
+         TimeValue temp(*this);
+         totalSeconds_ = saturatingAdd(totalSeconds_, 1);
+         return temp;
+     }
+     constexpr TimeValue& operator--() noexcept {
+         if (totalSeconds_ > 0) totalSeconds_--;
+         return *this;
+     }
+     constexpr TimeValue operator--(int) noexcept {
+         TimeValue temp(*this);
+         if (totalSeconds_ > 0) totalSeconds_--;
+         return temp;
+     }
+
+     // Операторы арифметического присваивания
+     constexpr TimeValue& operator+=(TimeValue other) noexcept {
+         totalSeconds_ = saturatingAdd(totalSeconds_, other.totalSeconds_);
+         return *this;
+     }
+     constexpr TimeValue& operator-=(TimeValue other) noexcept {
+         totalSeconds_ = saturatingSub(totalSeconds_, other.totalSeconds_);
+         if (totalSeconds_ < 0) totalSeconds_ = 0;
+         return *this;
+     }
+     constexpr TimeValue& operator*=(double scalar) noexcept {
+         totalSeconds_ = saturatingFromDouble<int>(totalSeconds_ * scalar);
+         return *this;
+     }
+     constexpr TimeValue& operator/=(double scalar) noexcept {
+         if (scalar != 0) {
+             totalSeconds_ = saturatingFromDouble<int>(totalSeconds_ / scalar);
+         }
+         return *this;
+     }
+
+     // Бинарные арифметические операторы
+     constexpr TimeValue operator+(TimeValue other) const noexcept { return TimeValue(*this) += other; }
+     constexpr TimeValue operator-(TimeValue other) const noexcept { return TimeValue(*this) -= other; }
+     constexpr TimeValue operator*(double scalar) const noexcept { return TimeValue(*this) *= scalar; }
+     constexpr TimeValue operator/(double scalar) const noexcept { return TimeValue(*this) /= scalar; }
+
+     // Бинарные операторы сравнения
+ #ifdef __cpp_impl_three_way_comparison
+     constexpr auto operator<=>(const TimeValue& other) const noexcept = default; ///< Все шесть сравнений (C++20)
+     constexpr bool operator==(const TimeValue& other) const noexcept = default;  ///< Равно
+ #else
+     constexpr bool operator<(TimeValue other) const noexcept { return totalSeconds_ < other.totalSeconds_; }
+     constexpr bool operator>(TimeValue other) const noexcept { return totalSeconds_ > other.totalSeconds_; }
+     constexpr bool operator<=(TimeValue other) const noexcept { return totalSeconds_ <= other.totalSeconds_; }
+     constexpr bool operator>=(TimeValue other) const noexcept { return totalSeconds_ >= other.totalSeconds_; }
+     constexpr bool operator==(TimeValue other) const noexcept { return totalSeconds_ == other.totalSeconds_; }
+     constexpr bool operator!=(TimeValue other) const noexcept { return totalSeconds_ != other.totalSeconds_; }
+ #endif
+ };
+
+ static_assert(std::is_trivially_copyable<TimeValue>::value, "TimeValue должен быть тривиально копируемым");
+ static_assert(sizeof(TimeValue) == sizeof(int), "TimeValue не должен содержать ничего, кроме секунд");
+
+ /**
+  * @brief Литералы времени: 1_h, 30_min, 45_s
+  *
+  * Подключаются через using namespace timeLiterals. Значения - TimeValue,
+  * поэтому выражения вроде 1_h + 30_min вычисляются при компиляции.
+  * Слишком большие числа насыщаются, как в конструкторе TimeValue.
+  */
+ namespace timeLiterals {
+     // Число из литерала, прижатое к int
+     constexpr int literalToInt(unsigned long long value) noexcept {
+         return value < static_cast<unsigned long long>(std::numeric_limits<int>::max())
+             ? static_cast<int>(value) : std::numeric_limits<int>::max();
+     }
+     constexpr TimeValue operator""_h(unsigned long long hours) noexcept {
+         return TimeValue(literalToInt(hours), 0, 0);
+     }
+     constexpr TimeValue operator""_min(unsigned long long minutes) noexcept {
+         return TimeValue(0, literalToInt(minutes), 0);
+     }
+     constexpr TimeValue operator""_s(unsigned long long seconds) noexcept {
+         return TimeValue(0, 0, literalToInt(seconds));
+     }
+ }
+
+ #endif
@@ -0,0 +1,220 @@
+/**
+ * @file tracing.cpp
+ * @brief Реализация замеров операций с расписанием
+ */
+
+ #include "tracing.h"
+
+ #ifdef SCHEDULE_TRACING
+
+ #include "time.h"
+ #include <chrono>
+ #include <cstdlib>
+ #include <mutex>
+ #include <new>
+ #include <ostream>
+ #include <vector>
+
+ using namespace std;
+
+ // Счётчик выделений потока. Подмена глобальных new/delete - единственный
+ // переносимый способ увидеть выделения стандартных контейнеров; она
+ // попадает в программу только вместе с замерами.
+ static thread_local size_t threadAllocations = 0;
+
+ __attribute__((noinline)) void* operator new(size_t size) {
+     threadAllocations++;
+     if (void* p = malloc(size != 0 ? size : 1)) return p;
+     throw bad_alloc();
+ }
+ __attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+ __attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+ namespace {
+
+ struct TraceEvent {
+     TraceOperation operation;
+     int64_t startNs;    ///< От начала трассы
+     int64_t durationNs;
+     uint32_t allocations;
+     uint32_t timeObjects;
+ };
+
+ struct TraceState {
+     mutex lock;
+     TraceHistogram histograms[traceOperationCount];
+     vector<TraceEvent> events;
+     size_t droppedEvents = 0;
+     int64_t originNs = 0; ///< Начало трассы
+ };
+
+ TraceState& state() {
+     static TraceState instance;
+     return instance;
+ }
+
+ int64_t nowNs() {
+     return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+ }
+
+ size_t timeObjects() {
+     TimeStats stats = Time::getOperationStats();
+     return stats.constructions + stats.copies + stats.moves;
+ }
+
+ size_t bucketOf(uint64_t ns) {
+     size_t bucket = ns == 0 ? 0 : static_cast<size_t>(63 - __builtin_clzll(ns));
+     return bucket < TraceHistogram::bucketCount ? bucket : TraceHistogram::bucketCount - 1;
+ }
+
+ // Доли наносекунд для полей ts/dur в микросекундах
+ void writeMicroseconds(ostream& out, int64_t ns) {
+     out << ns / 1000 << '.';
+     int64_t rest = ns % 1000;
+     out << static_cast<char>('0' + rest / 100) << static_cast<char>('0' + rest / 10 % 10)
+         << static_cast<char>('0' + rest % 10);
+ }
+
+ } // namespace
+
+ uint64_t TraceHistogram::percentileNs(double q) const {
+     if (count == 0) return 0;
+     uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count));
+     if (rank >= count) rank = count - 1;
+     uint64_t seen = 0;
+     for (size_t b = 0; b < bucketCount; b++) {
+         seen += buckets[b];
+         if (seen > rank) {
+             uint64_t upper = b + 1 < bucketCount ? (uint64_t(1) << (b + 1)) - 1 : maxNs;
+             return upper < maxNs ? upper : maxNs;
+         }
+     }
+     return maxNs;
+ }
+
+ TraceScope::TraceScope(TraceOperation operation)
+     : operation_(operation), startNs_(0), allocations_(threadAllocations), timeObjects_(timeObjects()) {
+     // Часы читаются последними, чтобы не считать в задержку сам замер
+     startNs_ = nowNs();
+ }
+
+ TraceScope::~TraceScope() {
+     int64_t endNs = nowNs();
+     uint64_t duration = static_cast<uint64_t>(endNs - startNs_);
+     size_t allocations = threadAllocations - allocations_;
+     size_t created = timeObjects() - timeObjects_;
+
+     TraceState& s = state();
+     lock_guard<mutex> guard(s.lock);
+     TraceHistogram& h = s.histograms[static_cast<size_t>(operation_)];
+     if (h.count == 0 || duration < h.minNs) h.minNs = duration;
+     if (duration > h.maxNs) h.maxNs = duration;
+     h.count++;
+     h.totalNs += duration;
+     h.buckets[bucketOf(duration)]++;
+     h.allocations += allocations;
+     h.timeObjects += created;
+
+     if (s.events.size() < maxTraceEvents) {
+         if (s.events.empty()) s.originNs = startNs_;
+         s.events.push_back({operation_, startNs_ - s.originNs, static_cast<int64_t>(duration),
+                             static_cast<uint32_t>(allocations), static_cast<uint32_t>(created)});
+     } else {
+         s.droppedEvents++;
+     }
+ }
+
+ const char* traceOperationName(TraceOperation operation) {
+     switch (operation) {
+         case TraceOperation::Add: return "add";
+         case TraceOperation::Edit: return "edit";
+         case TraceOperation::Delete: return "delete";
+         case TraceOperation::List: return "list";
+         case TraceOperation::Report: return "report";
+     }
+     return "?";
+ }
+
+ TraceHistogram traceHistogram(TraceOperation operation) {
+     TraceState& s = state();
+     lock_guard<mutex> guard(s.lock);
+     return s.histograms[static_cast<size_t>(operation)];
+ }
+
+ size_t traceThreadAllocations() {
+     return threadAllocations;
+ }
+
+ void resetTrace() {
+     TraceState& s = state();
+     lock_guard<mutex> guard(s.lock);
+     for (TraceHistogram& h : s.histograms) h = TraceHistogram();
+     s.events.clear();
+     s.droppedEvents = 0;
+     s.originNs = 0;
+ }
+
+ void writeTraceSummary(ostream& out) {
+     out << "Замеры операций (нс): число, среднее, p50, p99, макс., выделений и Time на операцию\n";
+     for (size_t i = 0; i < traceOperationCount; i++) {
+         TraceOperation operation = static_cast<TraceOperation>(i);
+         TraceHistogram h = traceHistogram(operation);
+         if (h.count == 0) continue;
+         out << "  " << traceOperationName(operation) << ": " << h.count
+             << ", " << h.totalNs / h.count
+             << ", " << h.percentileNs(0.5)
+             << ", " << h.percentileNs(0.99)
+             << ", " << h.maxNs
+             << ", " << static_cast<double>(h.allocations) / static_cast<double>(h.count)
+             << ", " << static_cast<double>(h.timeObjects) / static_cast<double>(h.count) << '\n';
+     }
+ }
+
+ void writeTraceJson(ostream& out) {
+     out << "{\"unit\":\"ns\",\"operations\":[";
+     for (size_t i = 0; i < traceOperationCount; i++) {
+         TraceOperation operation = static_cast<TraceOperation>(i);
+         TraceHistogram h = traceHistogram(operation);
+         if (i > 0) out << ',';
+         out << "{\"name\":\"" << traceOperationName(operation) << '"'
+             << ",\"count\":" << h.count
+             << ",\"totalNs\":" << h.totalNs
+             << ",\"minNs\":" << h.minNs
+             << ",\"maxNs\":" << h.maxNs
+             << ",\"p50Ns\":" << h.percentileNs(0.5)
+             << ",\"p90Ns\":" << h.percentileNs(0.9)
+             << ",\"p99Ns\":" << h.percentileNs(0.99)
+             << ",\"allocations\":" << h.allocations
+             << ",\"timeObjects\":" << h.timeObjects
+             << ",\"histogram\":[";
+         // Только непустые корзины: [нижняя граница, нс; число]
+         bool first = true;
+         for (size_t b = 0; b < TraceHistogram::bucketCount; b++) {
+             if (h.buckets[b] == 0) continue;
+             if (!first) out << ',';
+             first = false;
+             out << '[' << (b == 0 ? 0 : uint64_t(1) << b) << ',' << h.buckets[b] << ']';
+         }
+         out << "]}";
+     }
+     out << "]}\n";
+ }
+
+ void writeTraceChrome(ostream& out) {
+     TraceState& s = state();
+     lock_guard<mutex> guard(s.lock);
+     out << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":" << s.droppedEvents << "},\"traceEvents\":[";
+     for (size_t i = 0; i < s.events.size(); i++) {
+         const TraceEvent& e = s.events[i];
+         if (i > 0) out << ",\n";
+         out << "{\"name\":\"" << traceOperationName(e.operation)
+             << "\",\"cat\":\"schedule\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":";
+         writeMicroseconds(out, e.startNs);
+         out << ",\"dur\":";
+         writeMicroseconds(out, e.durationNs);
+         out << ",\"args\":{\"allocations\":" << e.allocations << ",\"timeObjects\":" << e.timeObjects << "}}";
+     }
+     out << "]}\n";
+ }
+
+ #endif
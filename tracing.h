@@ -0,0 +1,132 @@
+/**
+ * @file tracing.h
+ * @brief Замеры задержек операций с расписанием: гистограммы и трасса для chrome://tracing
+ */
+
+ #ifndef TRACING_H
+ #define TRACING_H
+
+ // Замеры включаются определением SCHEDULE_TRACING (в CMake - OOP2_TRACING=ON).
+ // Без него TRACE_OPERATION раскрывается в пустой оператор, а tracing.cpp
+ // не содержит ни кода, ни данных: выключенные замеры ничего не стоят.
+
+ #ifdef SCHEDULE_TRACING
+
+ #include <cstddef>
+ #include <cstdint>
+ #include <iosfwd>
+
+ /**
+  * @brief Замеряемые операции
+  */
+ enum class TraceOperation {
+     Add,    ///< Добавление мероприятия
+     Edit,   ///< Правка мероприятия
+     Delete, ///< Удаление мероприятия
+     List,   ///< Вывод всего расписания
+     Report, ///< Итоги, статистика, конфликты
+ };
+
+ constexpr size_t traceOperationCount = 5; ///< Число значений TraceOperation
+
+ /**
+  * @struct TraceHistogram
+  * @brief Задержки одной операции по степеням двойки наносекунд
+  */
+ struct TraceHistogram {
+     static constexpr size_t bucketCount = 40; ///< Корзина b: [2^b, 2^(b+1)) нс, последняя - всё, что дольше
+
+     uint64_t buckets[bucketCount] = {}; ///< Число замеров в корзине
+     uint64_t count = 0;                 ///< Число замеров
+     uint64_t totalNs = 0;               ///< Сумма задержек
+     uint64_t minNs = 0;                 ///< Наименьшая задержка
+     uint64_t maxNs = 0;                 ///< Наибольшая задержка
+     uint64_t allocations = 0;           ///< Выделения памяти за все замеры
+     uint64_t timeObjects = 0;           ///< Созданные объекты Time (в т.ч. временные)
+
+     /**
+      * @brief Оценка квантиля сверху: верхняя граница корзины, не больше maxNs
+      * @param q Доля от 0 до 1
+      */
+     uint64_t percentileNs(double q) const;
+ };
+
+ /**
+  * @class TraceScope
+  * @brief Замер операции от создания до разрушения объекта
+  *
+  * Записывает задержку, число выделений памяти потока и созданных
+  * объектов Time. Стоимость замера - два чтения часов, чтение счётчиков
+  * Time и запись под мьютексом; операции меню и сценариев выполняются
+  * в одном потоке, так что мьютекс не бывает занят.
+  */
+ class TraceScope {
+ private:
+     TraceOperation operation_;
+     int64_t startNs_;
+     size_t allocations_;
+     size_t timeObjects_;
+
+ public:
+     explicit TraceScope(TraceOperation operation);
+     ~TraceScope();
+     TraceScope(const TraceScope&) = delete;
+     TraceScope& operator=(const TraceScope&) = delete;
+ };
+
+ /**
+  * @brief Имя операции в отчётах ("add", "edit", ...)
+  */
+ const char* traceOperationName(TraceOperation operation);
+
+ /**
+  * @brief Копия гистограммы операции
+  */
+ TraceHistogram traceHistogram(TraceOperation operation);
+
+ /**
+  * @brief Выделения памяти текущим потоком с начала программы
+  *
+  * Считает подменённый в tracing.cpp operator new.
+  */
+ size_t traceThreadAllocations();
+
+ /**
+  * @brief Сбросить гистограммы и события
+  */
+ void resetTrace();
+
+ /**
+  * @brief Краткая таблица по операциям (экран статистики)
+  */
+ void writeTraceSummary(std::ostream& out);
+
+ /**
+  * @brief Гистограммы всех операций в JSON
+  */
+ void writeTraceJson(std::ostream& out);
+
+ /**
+  * @brief События в формате Trace Event (chrome://tracing, Perfetto)
+  *
+  * Хранится не больше maxTraceEvents событий; более поздние учитываются
+  * только в гистограммах, их число записывается в метаданные трассы.
+  */
+ void writeTraceChrome(std::ostream& out);
+
+ constexpr size_t maxTraceEvents = size_t(1) << 20; ///< Предел событий трассы (~32 МБ)
+
+ #define TRACE_CONCAT_INNER(a, b) a##b
+ #define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+ /// Замерить операцию до конца текущего блока
+ #define TRACE_OPERATION(operation) \
+     TraceScope TRACE_CONCAT(traceScope, __LINE__)(TraceOperation::operation)
+
+ #else
+
+ #define TRACE_OPERATION(operation) ((void)0)
+
+ #endif
+
+ #endif